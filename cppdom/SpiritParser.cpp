@@ -39,6 +39,9 @@
 /** \file SpiritParser.cpp
   definitions for the spirit parsing classes
 */
+#include <fstream>
+#include <iterator>
+
 #include <cppdom/SpiritParser.h>
 
 namespace bs = boost::spirit;
@@ -58,55 +61,110 @@ XmlBuilder::XmlBuilder(cppdom::DocumentPtr doc, cppdom::ContextPtr context)
 */
 
 
-void Parser::parseDocument(cppdom::Document& doc, std::string& content)
+// StreamWindow methods
+
+StreamWindow::StreamWindow(std::istream& in, std::size_t lookahead)
+   : mIn(in), mLookahead(lookahead), mBase(0)
+{}
+
+bool StreamWindow::fill(std::size_t pos)
 {
-   mCharBuilder.reinit(&doc, doc.getContext());
-   XmlGrammar<XmlBuilder<const char*> > xml_grammar(&mCharBuilder);
-   parse_info<char const*> result;
+   const std::size_t chunk_size = 4096;
+   while(pos >= mBase + mBuffer.size())
+   {
+      if(!mIn)
+      {  return false; }
 
-   result = bs::parse(content.c_str(), xml_grammar);
-   if(!result.full)
+      const std::size_t size = mBuffer.size();
+      mBuffer.resize(size + chunk_size);
+      mIn.read(&mBuffer[size], chunk_size);
+      mBuffer.resize(size + std::size_t(mIn.gcount()));
+   }
+
+   // Drop what lies more than the lookahead behind pos, once there is
+   // enough of it to pay for moving the rest
+   if(pos > mBase + mLookahead)
    {
-      throw CPPDOM_ERROR(xml_invalid_operation, "Invalid format of XML.");
+      const std::size_t drop = pos - mLookahead - mBase;
+      if(drop >= mLookahead && drop >= chunk_size)
+      {
+         mBuffer.erase(mBuffer.begin(), mBuffer.begin() + drop);
+         mBase += drop;
+      }
    }
+   return true;
 }
 
-void Parser::parseDocument(cppdom::Document& doc, std::istream& instream)
-{
-    typedef char char_t;
-    typedef bs::multi_pass<std::istream_iterator<char_t> > iterator_t;
-
-    //typedef skip_parser_iteration_policy<space_parser> iter_policy_t;
-    //typedef scanner_policies<iter_policy_t> scanner_policies_t;
-    //typedef scanner<iterator_t, scanner_policies_t> scanner_t;
-
-    //typedef rule<scanner_t> rule_t;
 
-    //iter_policy_t iter_policy(space_p);
-    //scanner_policies_t policies(iter_policy);
+// Parser methods
 
-    typedef  XmlBuilder<iterator_t> builder_t;
+void Parser::parseDocument(cppdom::Document& doc, std::string& content)
+{
+   parseRange<FullXmlPolicy>(doc, content.data(), content.data() + content.size());
+}
 
-    builder_t local_builder;
-    local_builder.reinit(&doc, doc.getContext());
+void Parser::parseDocument(cppdom::Document& doc, std::istream& instream)
+{
+   mBuffer.assign(std::istreambuf_iterator<char>(instream), std::istreambuf_iterator<char>());
+   parseBuffer(doc);
+}
 
-    XmlGrammar<builder_t> xml_grammar(&local_builder);
-    bs::parse_info<iterator_t> result;
+void Parser::parseFile(cppdom::Document& doc, const std::string& filename)
+{
+   std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+   if(!in)
+   {
+      throw CPPDOM_ERROR(xml_filename_invalid, "Filename passed to parseFile was invalid");
+   }
 
-    iterator_t first( bs::make_multi_pass( std::istream_iterator<char_t>(instream)));
-    iterator_t last( bs::make_multi_pass( std::istream_iterator<char_t>()));
+   in.seekg(0, std::ios::end);
+   const std::streamoff size = in.tellg();
+   in.seekg(0, std::ios::beg);
+   if(size < 0)
+   {
+      parseDocument(doc, in);
+      return;
+   }
 
-    result = bs::parse(first, last, xml_grammar, bs::space_p);
-    if(!result.full)
-    {
-       throw CPPDOM_ERROR(xml_invalid_operation, "Invalid format of XML.");
-    }
+   mBuffer.resize(std::size_t(size));
+   if(size > 0)
+   {
+      in.read(&mBuffer[0], size);
+   }
+   mBuffer.resize(std::size_t(in.gcount()));
+   parseBuffer(doc);
+}
 
-    //std::string test(first,last);
-    //parseDocument(doc,test);
+void Parser::parseBuffer(cppdom::Document& doc)
+{
+   try
+   {
+      parseRange<FullXmlPolicy>(doc, mBuffer.data(), mBuffer.data() + mBuffer.size());
+   }
+   catch(...)
+   {
+      std::string().swap(mBuffer);
+      throw;
+   }
+   std::string().swap(mBuffer);
 }
 
+void Parser::parseStream(cppdom::Document& doc, std::istream& instream, std::size_t lookahead)
+{
+   typedef XmlBuilder<StreamIterator> builder_t;
 
+   builder_t local_builder;
+   local_builder.reinit(&doc, doc.getContext());
+   XmlGrammar<builder_t> xml_grammar(&local_builder);
+
+   StreamWindow window(instream, lookahead);
+   bs::parse_info<StreamIterator> result;
+   result = bs::parse(StreamIterator(window), StreamIterator(), xml_grammar);
+   if(!result.full)
+   {
+      throw CPPDOM_ERROR(xml_invalid_operation, "Invalid format of XML.");
+   }
+}
 
 }  // namespace spirit
 } // namespace cppdom
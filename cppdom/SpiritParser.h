@@ -51,10 +51,11 @@
 #include <boost/spirit/core.hpp>
 #include <boost/spirit/actor/push_back_actor.hpp>
 #include <boost/spirit/utility.hpp>
-#include <boost/bind.hpp>
 
-#include <boost/spirit/iterator/multi_pass.hpp>
 #include <iostream>
+#include <iterator>
+#include <vector>
+#include <cstddef>
 
 namespace cppdom
 {
@@ -62,9 +63,66 @@ namespace cppdom
 namespace spirit
 {
 
+/** Tracing policy of XmlBuilder that traces nothing. */
+struct NoTrace
+{
+   template<typename IteratorType>
+   static void startElement(IteratorType, IteratorType) {}
+   template<typename IteratorType>
+   static void endElement(IteratorType, IteratorType) {}
+   static void endElementQuick() {}
+   template<typename IteratorType>
+   static void startAttribute(IteratorType, IteratorType) {}
+   template<typename IteratorType>
+   static void attribValue(IteratorType, IteratorType) {}
+   static void elementText(const std::string&) {}
+};
+
+/**
+ * Tracing policy of XmlBuilder that prints each callback to a stream,
+ * std::cout unless another one is given (see XmlBuilder::setTrace).
+ */
+class StreamTrace
+{
+public:
+   explicit StreamTrace(std::ostream& out = std::cout)
+      : mOut(&out)
+   {}
+
+   template<typename IteratorType>
+   void startElement(IteratorType first, IteratorType last)
+   { *mOut << "Elt in: [" << std::string(first, last) << "]" << std::endl; }
+
+   template<typename IteratorType>
+   void endElement(IteratorType first, IteratorType last)
+   { *mOut << "Elt exit: " << std::string(first, last) << std::endl; }
+
+   void endElementQuick()
+   { *mOut << "Elt exit quick.." << std::endl; }
+
+   template<typename IteratorType>
+   void startAttribute(IteratorType first, IteratorType last)
+   { *mOut << "  attrib: " << std::string(first, last) << std::endl; }
+
+   template<typename IteratorType>
+   void attribValue(IteratorType first, IteratorType last)
+   { *mOut << " [" << std::string(first, last) << "] " << std::endl; }
+
+   void elementText(const std::string& text)
+   { *mOut << "   Text: [" << text << "] " << std::endl; }
+
+private:
+   std::ostream* mOut;   /**< where the trace goes */
+};
+
 /** Class for building an xml node tree from a spirit parser.
+ *
+ * Element names are interned straight from the parsed range where the
+ * iterators point into contiguous memory, and through one reused buffer
+ * otherwise. Tracing is chosen at compile time by TracePolicy (NoTrace or
+ * StreamTrace), so the default builder does no console output.
  */
-template<typename IteratorType>
+template<typename IteratorType, typename TracePolicy = NoTrace>
 class XmlBuilder
 {
 public:
@@ -80,6 +138,7 @@ public:
       {
          throw CPPDOM_ERROR(xml_invalid_argument, "Attempted to use doc with no context.");
       }
+      mCdataHandle = mContext->insertTagname("cdata");
 
       mNodeStack.clear();
       mNodeStack.push_back(mDocRoot);     // Doc is at base of stack
@@ -94,13 +153,13 @@ public:
    /** Called when element is found and starts. */
    void startElement(IteratorType first, IteratorType last)
    {
-      std::string elt_name(first, last);
-      std::cout << "Elt in: [" << elt_name << "]" << std::endl;
+      mTrace.startElement(first, last);
 
       // - Create node
       // - Add to tree
       // - Put on stack to get ready for more
-      NodePtr new_elt(new cppdom::Node(elt_name,mContext));
+      NodePtr new_elt(new cppdom::Node(mContext));
+      new_elt->setNameHandle(internName(first, last));
       mNodeStack.back()->addChild(new_elt);
       mNodeStack.push_back(new_elt.get());
    }
@@ -108,11 +167,15 @@ public:
    /** Called when element ends. */
    void endElement(IteratorType first, IteratorType last)
    {
-      std::string elt_name(first,last);
-      std::cout << "Elt exit: " << elt_name << std::endl;
+      mTrace.endElement(first, last);
       // Should always have more then one on stack since doc root is
       // on stack at all times and we need one more to pop
       assert(mNodeStack.size() > 1);
+      const std::string& start_name = mContext->getTagname(mNodeStack.back()->getNameHandle());
+      if(!sameName(start_name, first, last))
+      {
+         throw CPPDOM_ERROR(xml_tagname_close_mismatch, "");
+      }
       mNodeStack.pop_back();
 
    #ifdef _DEBUG
@@ -123,10 +186,13 @@ public:
       /** Called when element ends. */
    void endElementQuick(IteratorType first, IteratorType last)
    {
-      std::cout << "Elt exit quick.." << std::endl;
+      cppdom::ignore_unused_variable_warning(first);
+      cppdom::ignore_unused_variable_warning(last);
+      mTrace.endElementQuick();
       // Should always have more then one on stack since doc root is
       // on stack at all times and we need one more to pop
       assert(mNodeStack.size() > 1);
+      mNodeStack.back()->setType(Node::xml_nt_leaf);     // as the Parser does
       mNodeStack.pop_back();
 
    #ifdef _DEBUG
@@ -137,59 +203,239 @@ public:
    /** Called at the start of an attribute. */
    void startAttribute(IteratorType first, IteratorType last)
    {
-      std::string attrib(first,last);
-      std::cout << "  attrib: " << attrib << std::endl;
-      mCurAttribute = attrib;
+      mTrace.startAttribute(first, last);
+      mCurAttribute.assign(first, last);
       assert(!mCurAttribute.empty());
    }
 
    /** Called with value of attribute. */
    void attribValue(IteratorType first, IteratorType last)
    {
-      std::string attrib_value(first,last);
-      std::cout << " [" << attrib_value << "] " << std::endl;
+      mTrace.attribValue(first, last);
+      assert(!mCurAttribute.empty());
+      mText.assign(first, last);
+      if(cppdom::textContainsXmlEscaping(mText))
+      {  mText = removeXmlEscaping(mText, false); }
+      mNodeStack.back()->attrib()[mCurAttribute].setValue(mText);
+   }
+
+   /** Called with value of attribute when the grammar does not unescape. */
+   void attribValueRaw(IteratorType first, IteratorType last)
+   {
+      mTrace.attribValue(first, last);
       assert(!mCurAttribute.empty());
-      if(cppdom::textContainsXmlEscaping(attrib_value))
-      {  attrib_value = removeXmlEscaping(attrib_value, false); }
-      mNodeStack.back()->attrib().set(mCurAttribute, attrib_value);
+      mText.assign(first, last);
+      mNodeStack.back()->attrib()[mCurAttribute].setValue(mText);
    }
 
    /** Called with element content text. */
    void elementText(IteratorType first, IteratorType last)
    {
-      std::string elem_text(first,last);
-      if(textContainsXmlEscaping(elem_text))
-      {  elem_text = removeXmlEscaping(elem_text, true); }
+      mText.assign(first, last);
+      if(textContainsXmlEscaping(mText))
+      {  mText = removeXmlEscaping(mText, true); }
+      addText();
+   }
 
-      std::cout << "   Text: [" << elem_text << "] " << std::endl;
-      if(!elem_text.empty())
+   /** Called with element content text when the grammar does not unescape. */
+   void elementTextRaw(IteratorType first, IteratorType last)
+   {
+      mText.assign(first, last);
+      addText();
+   }
+
+   cppdom::Document* getDocRoot()
+   { return mDocRoot; }
+
+   /** Replaces the tracing policy, e.g. with a StreamTrace on another stream. */
+   void setTrace(const TracePolicy& trace)
+   { mTrace = trace; }
+
+protected:
+   /** adds mText as a cdata child of the current node */
+   void addText()
+   {
+      mTrace.elementText(mText);
+      if(!mText.empty())
       {
-         cppdom::NodePtr cdata_node(new cppdom::Node("cdata",mContext));
+         cppdom::NodePtr cdata_node(new cppdom::Node(mContext));
+         cdata_node->setNameHandle(mCdataHandle);
          cdata_node->setType(Node::xml_nt_cdata);
-         cdata_node->setCdata(elem_text);
+         cdata_node->setCdata(mText);
          mNodeStack.back()->addChild(cdata_node);
       }
    }
 
-   cppdom::Document* getDocRoot()
-   { return mDocRoot; }
+   /** names in contiguous memory are interned without a copy */
+   TagNameHandle internName(const char* first, const char* last)
+   {
+      return mContext->insertTagname(first, std::size_t(last - first));
+   }
+
+   template<typename OtherIteratorType>
+   TagNameHandle internName(OtherIteratorType first, OtherIteratorType last)
+   {
+      mText.assign(first, last);
+      return mContext->insertTagname(mText);
+   }
+
+   static bool sameName(const std::string& name, const char* first, const char* last)
+   {
+      return std::size_t(last - first) == name.size() &&
+             0 == name.compare(0, name.size(), first, name.size());
+   }
+
+   template<typename OtherIteratorType>
+   static bool sameName(const std::string& name, OtherIteratorType first, OtherIteratorType last)
+   {
+      std::string::const_iterator i = name.begin();
+      for(; first != last; ++first, ++i)
+      {
+         if(i == name.end() || *i != *first)
+         {  return false; }
+      }
+      return i == name.end();
+   }
 
 public:
    cppdom::Document*             mDocRoot;      /**< The root of the document. */
    std::vector<cppdom::Node*>    mNodeStack;    /**< The current stack of nodes. */
    cppdom::ContextPtr            mContext;      /**< The context we are using in the builder. */
+   TagNameHandle                 mCdataHandle;  /**< Name of cdata nodes in mContext. */
 
    std::string                   mCurAttribute; /**< Name of the current attribute we are using. */
+   std::string                   mText;         /**< Reused buffer for text and values. */
+   TracePolicy                   mTrace;        /**< Gets every callback, see NoTrace. */
+};
+
+/**
+ * Features of XmlGrammar, all switched on. Derive from this and switch
+ * features off to get a grammar that does less work; input using a
+ * feature that is off does not parse.
+ */
+struct FullXmlPolicy
+{
+   enum
+   {
+      comments = true,                 /**< <!-- comments --> */
+      processingInstructions = true,   /**< <?pi ?> */
+      cdataSections = true,            /**< <![CDATA[ ]]> */
+      doctype = true,                  /**< <!DOCTYPE > is skipped */
+      trimText = true,                 /**< leading whitespace of text is dropped,
+                                            so whitespace only text gives no text */
+      unescape = true                  /**< entity references in values and text are
+                                            resolved; if off the builder gets
+                                            attribValueRaw() and elementTextRaw() */
+   };
+};
+
+/** Policy for trusted, machine written documents: elements, attributes and text only. */
+struct TrustedXmlPolicy : public FullXmlPolicy
+{
+   enum
+   {
+      comments = false,
+      processingInstructions = false,
+      cdataSections = false,
+      doctype = false,
+      unescape = false
+   };
+};
+
+/** @name Semantic actions calling the builder directly */
+//@{
+template<typename BUILDER_T>
+struct StartElementAction
+{
+   explicit StartElementAction(BUILDER_T* builder) : mBuilder(builder) {}
+   template<typename IteratorType>
+   void operator()(IteratorType first, IteratorType last) const
+   { mBuilder->startElement(first, last); }
+   BUILDER_T* mBuilder;
+};
+
+template<typename BUILDER_T>
+struct EndElementAction
+{
+   explicit EndElementAction(BUILDER_T* builder) : mBuilder(builder) {}
+   template<typename IteratorType>
+   void operator()(IteratorType first, IteratorType last) const
+   { mBuilder->endElement(first, last); }
+   BUILDER_T* mBuilder;
+};
+
+template<typename BUILDER_T>
+struct EndElementQuickAction
+{
+   explicit EndElementQuickAction(BUILDER_T* builder) : mBuilder(builder) {}
+   template<typename IteratorType>
+   void operator()(IteratorType first, IteratorType last) const
+   { mBuilder->endElementQuick(first, last); }
+   BUILDER_T* mBuilder;
+};
+
+template<typename BUILDER_T>
+struct StartAttributeAction
+{
+   explicit StartAttributeAction(BUILDER_T* builder) : mBuilder(builder) {}
+   template<typename IteratorType>
+   void operator()(IteratorType first, IteratorType last) const
+   { mBuilder->startAttribute(first, last); }
+   BUILDER_T* mBuilder;
+};
+
+/** calls attribValue(), or attribValueRaw() when not unescaping */
+template<typename BUILDER_T, bool Unescape>
+struct AttribValueAction
+{
+   explicit AttribValueAction(BUILDER_T* builder) : mBuilder(builder) {}
+   template<typename IteratorType>
+   void operator()(IteratorType first, IteratorType last) const
+   { mBuilder->attribValue(first, last); }
+   BUILDER_T* mBuilder;
+};
+
+template<typename BUILDER_T>
+struct AttribValueAction<BUILDER_T, false>
+{
+   explicit AttribValueAction(BUILDER_T* builder) : mBuilder(builder) {}
+   template<typename IteratorType>
+   void operator()(IteratorType first, IteratorType last) const
+   { mBuilder->attribValueRaw(first, last); }
+   BUILDER_T* mBuilder;
+};
+
+/** calls elementText(), or elementTextRaw() when not unescaping */
+template<typename BUILDER_T, bool Unescape>
+struct ElementTextAction
+{
+   explicit ElementTextAction(BUILDER_T* builder) : mBuilder(builder) {}
+   template<typename IteratorType>
+   void operator()(IteratorType first, IteratorType last) const
+   { mBuilder->elementText(first, last); }
+   BUILDER_T* mBuilder;
+};
+
+template<typename BUILDER_T>
+struct ElementTextAction<BUILDER_T, false>
+{
+   explicit ElementTextAction(BUILDER_T* builder) : mBuilder(builder) {}
+   template<typename IteratorType>
+   void operator()(IteratorType first, IteratorType last) const
+   { mBuilder->elementTextRaw(first, last); }
+   BUILDER_T* mBuilder;
 };
+//@}
 
 /**
 * XML grammar.
 * Based on: http://www.w3.org/TR/2004/REC-xml-20040204/
 *
 * type: BUILDER_T must implement the interface concept similar to XmlBuilder above.
+* type: POLICY_T selects the features of the grammar, see FullXmlPolicy.
 */
-template<typename BUILDER_T>
-struct XmlGrammar : public boost::spirit::grammar<XmlGrammar<BUILDER_T> >
+template<typename BUILDER_T, typename POLICY_T = FullXmlPolicy>
+struct XmlGrammar : public boost::spirit::grammar<XmlGrammar<BUILDER_T, POLICY_T> >
 {
    XmlGrammar(BUILDER_T* builder)
       : mBuilder(builder)
@@ -205,7 +451,14 @@ struct XmlGrammar : public boost::spirit::grammar<XmlGrammar<BUILDER_T> >
       {
          namespace bs = boost::spirit;
          using namespace boost::spirit;
-         
+
+         const StartElementAction<BUILDER_T>    start_element(self.mBuilder);
+         const EndElementAction<BUILDER_T>      end_element(self.mBuilder);
+         const EndElementQuickAction<BUILDER_T> end_element_quick(self.mBuilder);
+         const StartAttributeAction<BUILDER_T>  start_attribute(self.mBuilder);
+         const AttribValueAction<BUILDER_T, bool(POLICY_T::unescape)> attrib_value_action(self.mBuilder);
+         const ElementTextAction<BUILDER_T, bool(POLICY_T::unescape)> element_text(self.mBuilder);
+
          document = prolog >> element >> *misc;       // Main document root
          ws = +space_p;                               // Whitespace, simplified from XML spec
 
@@ -220,37 +473,62 @@ struct XmlGrammar : public boost::spirit::grammar<XmlGrammar<BUILDER_T> >
          names = name >> *(blank_p >> name);
          nmtoken = +name_char;
 
-         comment = confix_p("<!--", *anychar_p, "-->");  // Slightly less strict.
-
-         pi = str_p("<?") >> name >> anychar_p >> str_p("?>");
-
-         cdata_sect = str_p("<![CDATA[") >> cdata >> str_p("]]>");
+         // Features switched off never match
+         if(POLICY_T::comments)
+         {  comment = confix_p("<!--", *anychar_p, "-->"); }  // Slightly less strict.
+         else
+         {  comment = nothing_p; }
+
+         if(POLICY_T::processingInstructions)
+         {  pi = str_p("<?") >> name >> anychar_p >> str_p("?>"); }
+         else
+         {  pi = nothing_p; }
+
+         if(POLICY_T::cdataSections)
+         {  cdata_sect = str_p("<![CDATA[") >> cdata >> str_p("]]>"); }
+         else
+         {  cdata_sect = nothing_p; }
          cdata = *anychar_p;
 
          misc = comment | pi | ws;
-         prolog = !xmldecl >> *misc >> !(doctypedecl >> *misc);
          xmldecl = confix_p("<?xml", *anychar_p, "?>");        // Use confix since any_char cosumes everything
-
-         doctypedecl = str_p("<!DOCTYPE")
-                           >> *(anychar_p - chset_p("[>"))
-                           >> !('[' >> *(anychar_p - ']') >> ']')
-                           >> *space_p >> '>';
+         if(POLICY_T::doctype)
+         {
+            prolog = !xmldecl >> *misc >> !(doctypedecl >> *misc);
+            doctypedecl = str_p("<!DOCTYPE")
+                              >> *(anychar_p - chset_p("[>"))
+                              >> !('[' >> *(anychar_p - ']') >> ']')
+                              >> *space_p >> '>';
+         }
+         else
+         {
+            prolog = !xmldecl >> *misc;
+            doctypedecl = nothing_p;
+         }
 
          // element = (start element) >> ( (more elts >> end) | (quick end))
-         element = ch_p('<') >> name[boost::bind(&BUILDER_T::startElement,self.mBuilder,_1,_2)] >> *(ws >> attribute) >> *space_p
+         element = ch_p('<') >> name[start_element] >> *(ws >> attribute) >> *space_p
                    >> ( (ch_p('>') >> elem_content >> str_p("</")
-                                   >> name[boost::bind(&BUILDER_T::endElement,self.mBuilder,_1,_2)] >> *space_p >> ch_p('>')) |
-                        (str_p("/>"))[boost::bind(&BUILDER_T::endElementQuick,self.mBuilder,_1,_2)] );
+                                   >> name[end_element] >> *space_p >> ch_p('>')) |
+                        (str_p("/>"))[end_element_quick] );
 
          // elementText: eliminate extra space by consuming initial whitespace & only call when char_data matches
-         elem_content = *space_p >> !(char_data[boost::bind(&BUILDER_T::elementText,self.mBuilder,_1,_2)])
-                          >> *( (element | comment | pi | cdata_sect) >> *space_p >> !(char_data[boost::bind(&BUILDER_T::elementText,self.mBuilder,_1,_2)]) );
-
-         attribute = name[boost::bind(&BUILDER_T::startAttribute,self.mBuilder,_1,_2)] >> *space_p >> '=' >> *space_p >> attrib_value;
-         attrib_value = ('"' >> (*(anychar_p-'"'))[boost::bind(&BUILDER_T::attribValue,self.mBuilder,_1,_2)] >> '"') |
-                        ("'" >> (*(anychar_p-"'"))[boost::bind(&BUILDER_T::attribValue,self.mBuilder,_1,_2)] >> "'");
-
-         BOOST_SPIRIT_DEBUG_RULE(attribute);
+         if(POLICY_T::trimText)
+         {
+            elem_content = *space_p >> !(char_data[element_text])
+                             >> *( (element | comment | pi | cdata_sect) >> *space_p >> !(char_data[element_text]) );
+         }
+         else
+         {
+            elem_content = !(char_data[element_text])
+                             >> *( (element | comment | pi | cdata_sect) >> !(char_data[element_text]) );
+         }
+
+         attribute = name[start_attribute] >> *space_p >> '=' >> *space_p >> attrib_value;
+         attrib_value = ('"' >> (*(anychar_p-'"'))[attrib_value_action] >> '"') |
+                        ("'" >> (*(anychar_p-"'"))[attrib_value_action] >> "'");
+
+      BOOST_SPIRIT_DEBUG_RULE(attribute);
          BOOST_SPIRIT_DEBUG_RULE(attrib_value);
          BOOST_SPIRIT_DEBUG_RULE(cdata_sect);
          BOOST_SPIRIT_DEBUG_RULE(cdata);
@@ -300,23 +578,149 @@ struct XmlGrammar : public boost::spirit::grammar<XmlGrammar<BUILDER_T> >
 };
 
 
+/** Input of a stream kept in a window of bounded size.
+ *
+ * Reads the stream as positions are asked for and drops what lies more
+ * than the lookahead behind the furthest position read.
+ */
+class CPPDOM_CLASS StreamWindow
+{
+public:
+   StreamWindow(std::istream& in, std::size_t lookahead);
+
+   /** returns true if pos is before the end of the input */
+   bool has(std::size_t pos)
+   {
+      return (pos < mBase + mBuffer.size()) || fill(pos);
+   }
+
+   /** the character at pos, which must be before the end of the input
+    * \exception throws cppdom::Error when pos was dropped from the window
+    */
+   char at(std::size_t pos)
+   {
+      if(pos < mBase)
+      {
+         throw CPPDOM_ERROR(xml_invalid_operation, "Stream parser went back further than its lookahead.");
+      }
+      has(pos);
+      return mBuffer[pos - mBase];
+   }
+
+private:
+   /** reads until pos is in the window, returns false at the end of the input */
+   bool fill(std::size_t pos);
+
+   std::istream&     mIn;
+   std::size_t       mLookahead;
+   std::vector<char> mBuffer;    /**< the window */
+   std::size_t       mBase;      /**< position of mBuffer[0] */
+};
+
+/** Forward iterator over a StreamWindow, the end iterator is default constructed. */
+class StreamIterator
+{
+public:
+   typedef std::forward_iterator_tag   iterator_category;
+   typedef char                        value_type;
+   typedef std::ptrdiff_t              difference_type;
+   typedef const char*                 pointer;
+   typedef char                        reference;
+
+   StreamIterator()
+      : mWindow(NULL), mPos(0)
+   {}
+
+   explicit StreamIterator(StreamWindow& window)
+      : mWindow(&window), mPos(0)
+   {}
+
+   char operator*() const
+   { return mWindow->at(mPos); }
+
+   StreamIterator& operator++()
+   {
+      ++mPos;
+      return *this;
+   }
+
+   StreamIterator operator++(int)
+   {
+      StreamIterator old(*this);
+      ++mPos;
+      return old;
+   }
+
+   bool operator==(const StreamIterator& other) const
+   {
+      const bool at_end(atEnd()), other_at_end(other.atEnd());
+      return (at_end || other_at_end) ? (at_end == other_at_end) : (mPos == other.mPos);
+   }
+
+   bool operator!=(const StreamIterator& other) const
+   { return !(*this == other); }
+
+private:
+   bool atEnd() const
+   { return (NULL == mWindow) || !mWindow->has(mPos); }
+
+   StreamWindow*  mWindow;
+   std::size_t    mPos;
+};
+
 /** The actual parser class that we will use.
  *
- * Provides a simple interface for using the builder and grammar.
+ * Provides a simple interface for using the builder and grammar. All
+ * overloads build the same tree from the same input.
  */
-class Parser
+class CPPDOM_CLASS Parser
 {
 public:
+   /** default lookahead of parseStream() */
+   enum { DefaultLookahead = 1 << 20 };
+
    /** Parse document coming in from string. */
    void parseDocument(cppdom::Document& doc, std::string& content);
 
-   /** Parse document from istream input. */
+   /** Parse document from istream input, which is read into memory first. */
    void parseDocument(cppdom::Document& doc, std::istream& instream);
 
+   /** Parse document from a file, which is read into memory in one go. */
+   void parseFile(cppdom::Document& doc, const std::string& filename);
+
+   /**
+    * Parse document from istream input without holding all of it in
+    * memory. Only the last lookahead characters read are kept, so no
+    * text or attribute value may be longer than that.
+    */
+   void parseStream(cppdom::Document& doc, std::istream& instream,
+                    std::size_t lookahead = DefaultLookahead);
+
+   /**
+    * Parse document from a range of characters with the grammar features
+    * selected by POLICY_T, e.g. parseRange<TrustedXmlPolicy>(doc, first, last).
+    */
+   template<typename POLICY_T>
+   void parseRange(cppdom::Document& doc, const char* first, const char* last)
+   {
+      mCharBuilder.reinit(&doc, doc.getContext());
+      XmlGrammar<XmlBuilder<const char*>, POLICY_T> xml_grammar(&mCharBuilder);
+
+      boost::spirit::parse_info<const char*> result = boost::spirit::parse(first, last, xml_grammar);
+      if(!result.full)
+      {
+         throw CPPDOM_ERROR(xml_invalid_operation, "Invalid format of XML.");
+      }
+   }
+
 public:
    XmlBuilder<const char*>  mCharBuilder;   /**< The builder that we are using. */
-   //XmlBuilder<const char*>  mCharBuilder;   /**< The builder that we are using. */
 
+private:
+   /** Parses mBuffer and releases it, the tree does not refer to it. */
+   void parseBuffer(cppdom::Document& doc);
+
+   std::string              mBuffer;        /**< Input read by the istream and file overloads, empty between parses. */
 };
 
 }  // namespace spirit
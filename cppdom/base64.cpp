@@ -0,0 +1,247 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file base64.cpp
+
+  base64 coding of binary cdata
+
+*/
+
+// needed includes
+#include <ostream>
+#include <cppdom/base64.h>
+
+// namespace declaration
+namespace cppdom
+{
+namespace base64
+{
+   namespace
+   {
+      const char digits[] =
+         "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+      /** values of the chars, see the constants below for the others */
+      enum { Space = 64, Pad = 65, Bad = 255 };
+
+      struct ValueTable
+      {
+         unsigned char mValues[256];
+
+         ValueTable()
+         {
+            for (unsigned i = 0; i < 256; ++i)
+            {  mValues[i] = Bad; }
+            for (unsigned i = 0; i < 64; ++i)
+            {  mValues[static_cast<unsigned char>(digits[i])] = static_cast<unsigned char>(i); }
+            mValues[static_cast<unsigned char>(' ')] = Space;
+            mValues[static_cast<unsigned char>('\t')] = Space;
+            mValues[static_cast<unsigned char>('\r')] = Space;
+            mValues[static_cast<unsigned char>('\n')] = Space;
+            mValues[static_cast<unsigned char>('=')] = Pad;
+         }
+      };
+
+      // Filled during static initialization, before any thread can decode
+      const ValueTable valueTable;
+
+      inline unsigned valueOf(char c)
+      {
+         return valueTable.mValues[static_cast<unsigned char>(c)];
+      }
+
+      /** bytes per block encode() writes to a stream */
+      const std::size_t StreamBlock = 3 * 1024;
+   }
+
+   char* encode(const unsigned char* data, std::size_t size, char* dest)
+   {
+      const unsigned char* end = data + size / 3 * 3;
+      for (; data != end; data += 3)
+      {
+         const unsigned long group = (unsigned long)(data[0]) << 16 |
+                                     (unsigned long)(data[1]) << 8 | data[2];
+         dest[0] = digits[(group >> 18) & 63];
+         dest[1] = digits[(group >> 12) & 63];
+         dest[2] = digits[(group >> 6) & 63];
+         dest[3] = digits[group & 63];
+         dest += 4;
+      }
+
+      const std::size_t rest = size % 3;
+      if (rest != 0)
+      {
+         const unsigned long group = (unsigned long)(data[0]) << 16 |
+                                     ((rest == 2) ? (unsigned long)(data[1]) << 8 : 0);
+         dest[0] = digits[(group >> 18) & 63];
+         dest[1] = digits[(group >> 12) & 63];
+         dest[2] = (rest == 2) ? digits[(group >> 6) & 63] : '=';
+         dest[3] = '=';
+         dest += 4;
+      }
+      return dest;
+   }
+
+   void encode(const unsigned char* data, std::size_t size, std::string& text)
+   {
+      const std::size_t old_size = text.size();
+      text.resize(old_size + encodedLength(size));
+      if (size != 0)
+      {  encode(data, size, &text[old_size]); }
+   }
+
+   void encode(const unsigned char* data, std::size_t size, std::ostream& out)
+   {
+      char block[StreamBlock / 3 * 4];
+      while (size != 0)
+      {
+         const std::size_t count = (size < StreamBlock) ? size : StreamBlock;
+         const char* end = encode(data, count, block);
+         out.write(block, end - block);
+         data += count;
+         size -= count;
+      }
+   }
+
+   // Decoder methods
+
+   Decoder::Decoder()
+      : mBits(0), mCount(0), mPadding(0)
+   {}
+
+   unsigned char* Decoder::decode(const char* first, const char* last, unsigned char* dest)
+   {
+      while (first != last)
+      {
+         // Whole groups of digits, the common case, go four chars at a time
+         if (mCount == 0 && mPadding == 0)
+         {
+            while (last - first >= 4)
+            {
+               const unsigned a = valueOf(first[0]);
+               const unsigned b = valueOf(first[1]);
+               const unsigned c = valueOf(first[2]);
+               const unsigned d = valueOf(first[3]);
+               if ((a | b | c | d) >= 64)
+               {  break; }
+               const unsigned long group = (unsigned long)(a) << 18 | (unsigned long)(b) << 12 |
+                                           (unsigned long)(c) << 6 | d;
+               dest[0] = static_cast<unsigned char>(group >> 16);
+               dest[1] = static_cast<unsigned char>(group >> 8);
+               dest[2] = static_cast<unsigned char>(group);
+               dest += 3;
+               first += 4;
+            }
+            if (first == last)
+            {  break; }
+         }
+
+         const unsigned value = valueOf(*first++);
+         if (value == Space)
+         {  continue; }
+         if (value == Bad)
+         {  return NULL; }
+
+         if (value == Pad)
+         {
+            // Padding completes a group of two or three digits
+            if (mCount + mPadding < 2 || mCount + mPadding == 4)
+            {  return NULL; }
+            ++mPadding;
+         }
+         else
+         {
+            if (mPadding != 0)
+            {  return NULL; }
+            mBits = (mBits << 6) | value;
+            ++mCount;
+         }
+
+         if (mCount + mPadding == 4)
+         {
+            const unsigned long group = mBits << (6 * mPadding);
+            dest[0] = static_cast<unsigned char>(group >> 16);
+            if (mCount > 2)
+            {  dest[1] = static_cast<unsigned char>(group >> 8); }
+            if (mCount > 3)
+            {  dest[2] = static_cast<unsigned char>(group); }
+            dest += mCount - 1;
+            mBits = 0;
+            // After padding the text is over: mCount stays, so more digits fail
+            if (mPadding == 0)
+            {  mCount = 0; }
+         }
+      }
+      return dest;
+   }
+
+   bool Decoder::decode(const char* first, const char* last, std::vector<unsigned char>& data)
+   {
+      const std::size_t old_size = data.size();
+      data.resize(old_size + maxDecodedLength(last - first));
+      unsigned char* end = decode(first, last, &data[0] + old_size);
+      if (end == NULL)
+      {
+         data.resize(old_size);
+         return false;
+      }
+      data.resize(end - &data[0]);
+      return true;
+   }
+
+   bool Decoder::decode(const char* first, const char* last, std::string& data)
+   {
+      const std::size_t old_size = data.size();
+      data.resize(old_size + maxDecodedLength(last - first));
+      unsigned char* begin = reinterpret_cast<unsigned char*>(&data[0]);
+      unsigned char* end = decode(first, last, begin + old_size);
+      if (end == NULL)
+      {
+         data.resize(old_size);
+         return false;
+      }
+      data.resize(end - begin);
+      return true;
+   }
+
+   bool Decoder::finished() const
+   {
+      return (mCount + mPadding) % 4 == 0;
+   }
+}
+}
@@ -0,0 +1,120 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file base64.h
+
+  base64 coding of binary cdata
+
+*/
+
+// prevent multiple includes
+#ifndef CPPDOM_BASE64_H
+#define CPPDOM_BASE64_H
+
+// needed includes
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+#include <cppdom/config.h>
+
+// namespace declaration
+namespace cppdom
+{
+namespace base64
+{
+   /** length of the base64 text of size bytes, with padding */
+   inline std::size_t encodedLength(std::size_t size)
+   {
+      return (size + 2) / 3 * 4;
+   }
+
+   /**
+    * writes the base64 text of size bytes to dest, which has room for
+    * encodedLength(size) chars. returns the end of the text
+    */
+   CPPDOM_EXPORT(char*) encode(const unsigned char* data, std::size_t size, char* dest);
+
+   /** appends the base64 text of size bytes to text */
+   CPPDOM_EXPORT(void) encode(const unsigned char* data, std::size_t size, std::string& text);
+
+   /** writes the base64 text of size bytes to out a block at a time, never all at once */
+   CPPDOM_EXPORT(void) encode(const unsigned char* data, std::size_t size, std::ostream& out);
+
+   /**
+    * Decodes base64 text that may arrive in pieces.
+    * Whitespace is skipped. Anything else that is not base64, or text after
+    * the padding, makes the text invalid.
+    */
+   class CPPDOM_CLASS Decoder
+   {
+   public:
+      Decoder();
+
+      /** room decode() needs for chars chars of text */
+      static std::size_t maxDecodedLength(std::size_t chars)
+      {  return chars / 4 * 3 + 3; }
+
+      /**
+       * decodes the text in [first, last) to dest, which has room for
+       * maxDecodedLength(last - first) bytes. dest may be first: the bytes
+       * never overtake the text they come from.
+       *
+       * @return the end of the bytes, NULL if the text is invalid
+       */
+      unsigned char* decode(const char* first, const char* last, unsigned char* dest);
+
+      /** decode() that appends the bytes to data */
+      bool decode(const char* first, const char* last, std::vector<unsigned char>& data);
+
+      /** decode() that appends the bytes to data */
+      bool decode(const char* first, const char* last, std::string& data);
+
+      /** returns if the text so far is complete, it does not end inside a group */
+      bool finished() const;
+
+   protected:
+      unsigned long  mBits;      /**< sextets of the current group */
+      unsigned       mCount;     /**< number of sextets in mBits */
+      unsigned       mPadding;   /**< '=' seen, the text is over once the group is */
+   };
+}
+}
+
+#endif
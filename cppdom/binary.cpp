@@ -0,0 +1,982 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/*! \file binary.cpp
+
+  writer, reader and memory mapping of binary document images
+
+*/
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+#if defined(WIN32) || defined(WIN64)
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+// needed includes
+#include <cppdom/cppdom.h>
+#include <cppdom/binary.h>
+
+
+// namespace declaration
+namespace cppdom
+{
+namespace binary
+{
+   // The layout relies on 32 bit words and on records without padding
+   typedef char WordSizeCheck[sizeof(Word) == 4 ? 1 : -1];
+   typedef char HeaderSizeCheck[sizeof(Header) == 8 * sizeof(Word) ? 1 : -1];
+   typedef char NodeRecordSizeCheck[sizeof(NodeRecord) == 10 * sizeof(Word) ? 1 : -1];
+
+   const char magic[4] = { 'C', 'P', 'D', 'B' };
+
+   /** cdata, comment and pi records keep their text in the pool */
+   inline bool hasText(Word type)
+   {
+      return type == Word(Node::xml_nt_cdata) || type == Word(Node::xml_nt_comment) ||
+             type == Word(Node::xml_nt_pi);
+   }
+
+   /** flattens a node tree into the tables of an image */
+   class ImageBuilder
+   {
+   public:
+      ImageBuilder(ContextPtr context)
+         : mFirstPi(npos), mContext(context)
+      {}
+
+      void addDocument(Document& doc)
+      {
+         addNode(doc, npos);
+
+         Word prev(npos);
+         NodeList& pis = doc.getPiList();
+         for (NodeList::iterator i = pis.begin(); i != pis.end(); ++i)
+         {
+            Word pi = addNode(**i, npos);
+            if (npos == prev)
+            {  mFirstPi = pi; }
+            else
+            {  mNodes[prev].mNextSibling = pi; }
+            prev = pi;
+         }
+      }
+
+      void write(std::ostream& out)
+      {
+         Header header;
+         fillHeader(header);
+         out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+         writeTable(out, mNames);
+         writeTable(out, mNodes);
+         writeTable(out, mAttribs);
+         out.write(mPool.data(), std::streamsize(mPool.size()));
+      }
+
+      /** writes the image into word storage, returns the image size in bytes */
+      std::size_t write(std::vector<Word>& image)
+      {
+         const std::size_t size = sizeof(Header) + mNames.size() * sizeof(NameRecord) +
+                                  mNodes.size() * sizeof(NodeRecord) +
+                                  mAttribs.size() * sizeof(AttribRecord) + mPool.size();
+         image.resize((size + sizeof(Word) - 1) / sizeof(Word));
+
+         char* dest = reinterpret_cast<char*>(&image[0]);
+         Header header;
+         fillHeader(header);
+         std::memcpy(dest, &header, sizeof(header));
+         dest += sizeof(header);
+         dest = copyTable(dest, mNames);
+         dest = copyTable(dest, mNodes);
+         dest = copyTable(dest, mAttribs);
+         if (!mPool.empty())
+         {  std::memcpy(dest, mPool.data(), mPool.size()); }
+         return size;
+      }
+
+   protected:
+      void fillHeader(Header& header) const
+      {
+         std::memcpy(header.mMagic, magic, sizeof(magic));
+         header.mVersion = version;
+         header.mByteOrder = byteOrderMark;
+         header.mNameCount = Word(mNames.size());
+         header.mNodeCount = Word(mNodes.size());
+         header.mAttribCount = Word(mAttribs.size());
+         header.mPoolSize = Word(mPool.size());
+         header.mFirstPi = mFirstPi;
+      }
+
+      template<class T>
+      static char* copyTable(char* dest, const std::vector<T>& table)
+      {
+         if (!table.empty())
+         {  std::memcpy(dest, &table[0], table.size() * sizeof(T)); }
+         return dest + table.size() * sizeof(T);
+      }
+
+      template<class T>
+      void writeTable(std::ostream& out, const std::vector<T>& table)
+      {
+         if (!table.empty())
+         {
+            out.write(reinterpret_cast<const char*>(&table[0]),
+                      std::streamsize(table.size() * sizeof(T)));
+         }
+      }
+
+      Word addString(const char* str, std::size_t len)
+      {
+         if (mPool.size() + len + 1 >= std::size_t(npos))
+         {
+            throw CPPDOM_ERROR(xml_invalid_binary_format, "Document too large for a binary image");
+         }
+         Word offset = Word(mPool.size());
+         mPool.append(str, len);
+         mPool += '\0';
+         return offset;
+      }
+
+      Word addName(const std::string& name)
+      {
+         std::map<std::string, Word>::iterator found = mNameIndex.find(name);
+         if (found != mNameIndex.end())
+         {  return found->second; }
+
+         NameRecord rec;
+         rec.mOffset = addString(name.data(), name.size());
+         rec.mLength = Word(name.size());
+         Word index = Word(mNames.size());
+         mNames.push_back(rec);
+         mNameIndex.insert(std::make_pair(name, index));
+         return index;
+      }
+
+      Word addNodeName(Node& node)
+      {
+         // Nodes from our context are looked up by handle, so the name
+         // string is only built once per distinct tag
+         if (node.getContext().get() != mContext.get())
+         {  return addName(node.getName()); }
+
+         std::map<TagNameHandle, Word>::iterator found = mHandleIndex.find(node.getNameHandle());
+         if (found != mHandleIndex.end())
+         {  return found->second; }
+
+         Word index = addName(node.getName());
+         mHandleIndex.insert(std::make_pair(node.getNameHandle(), index));
+         return index;
+      }
+
+      Word addNode(Node& node, Word parent)
+      {
+         NodeRecord rec;
+         rec.mType = Word(node.getType());
+         rec.mName = addNodeName(node);
+         rec.mParent = parent;
+         rec.mFirstChild = npos;
+         rec.mNextSibling = npos;
+         rec.mChildCount = Word(node.getChildren().size());
+         rec.mFirstAttrib = Word(mAttribs.size());
+         rec.mAttribCount = Word(node.attrib().size());
+         rec.mTextOffset = 0;
+         rec.mTextLength = 0;
+
+         if (hasText(rec.mType))
+         {
+            std::string cdata(node.getCdata());
+            rec.mTextOffset = addString(cdata.data(), cdata.size());
+            rec.mTextLength = Word(cdata.size());
+         }
+
+         // Attributes of a node are consecutive and sorted like the map
+         const Attributes& attrs = node.attrib();
+         for (Attributes::const_iterator a = attrs.begin(); a != attrs.end(); ++a)
+         {
+            const std::string& value = a->second.getString();
+            AttribRecord arec;
+            arec.mName = addName(a->first);
+            arec.mValueOffset = addString(value.data(), value.size());
+            arec.mValueLength = Word(value.size());
+            mAttribs.push_back(arec);
+         }
+
+         Word index = Word(mNodes.size());
+         mNodes.push_back(rec);
+
+         // Children follow their parent in document order
+         Word prev(npos);
+         NodeList& children = node.getChildren();
+         for (NodeList::iterator c = children.begin(); c != children.end(); ++c)
+         {
+            Word child = addNode(**c, index);
+            if (npos == prev)
+            {  mNodes[index].mFirstChild = child; }
+            else
+            {  mNodes[prev].mNextSibling = child; }
+            prev = child;
+         }
+         return index;
+      }
+
+      Word                             mFirstPi;
+      ContextPtr                       mContext;
+      std::vector<NameRecord>          mNames;
+      std::vector<NodeRecord>          mNodes;
+      std::vector<AttribRecord>        mAttribs;
+      std::string                      mPool;
+      std::map<std::string, Word>      mNameIndex;
+      std::map<TagNameHandle, Word>    mHandleIndex;
+   };
+
+   /** rebuilds a node tree from an image */
+   class TreeBuilder
+   {
+   public:
+      TreeBuilder(const BinaryDocument& image, ContextPtr context)
+         : mImage(image), mContext(context), mHandles(image.getNameCount(), -1)
+      {}
+
+      /** drops the current content of a node that is about to be refilled */
+      void clear(Node& node)
+      {
+         node.dropLazy();
+         for (NodeList::iterator i = node.mNodeList.begin(); i != node.mNodeList.end(); ++i)
+         {  (*i)->mParent = NULL; }
+         node.mNodeList.clear();
+         node.mAttributes.clear();
+         node.mCdata.clear();
+         node.mCdataBinary = false;
+         node.invalidateHash();
+         node.invalidateOrder();
+      }
+
+      void fill(Node& node, Word index)
+      {
+         const NodeRecord& rec = mImage.getNodeRecord(index);
+
+         node.mNodeType = Node::Type(rec.mType);
+         node.mNodeNameHandle = getHandle(rec.mName);
+#ifdef CPPDOM_DEBUG
+         node.mNodeName_debug = mImage.getNameString(rec.mName);
+#endif
+         if (hasText(rec.mType))
+         {
+            node.mCdata.assign(mImage.getPoolString(rec.mTextOffset), rec.mTextLength);
+         }
+
+         // Records are sorted like the map, so every insert goes to the end
+         for (Word a = rec.mFirstAttrib; a < rec.mFirstAttrib + rec.mAttribCount; ++a)
+         {
+            const AttribRecord& arec = mImage.getAttribRecord(a);
+            Attributes::value_type value(mImage.getNameString(arec.mName),
+               Attribute(std::string(mImage.getPoolString(arec.mValueOffset), arec.mValueLength)));
+            node.mAttributes.insert(node.mAttributes.end(), value);
+         }
+
+         node.mNodeList.reserve(rec.mChildCount);
+         for (Word c = rec.mFirstChild; c != npos; c = mImage.getNodeRecord(c).mNextSibling)
+         {
+            NodePtr child(new Node(mContext));
+            fill(*child, c);
+            child->mParent = &node;
+            child->mIndex = unsigned(node.mNodeList.size());
+            node.mNodeList.push_back(child);
+         }
+      }
+
+      NodePtr createPi(Word index)
+      {
+         NodePtr pi(new Node(mContext));
+         fill(*pi, index);
+         return pi;
+      }
+
+   protected:
+      TagNameHandle getHandle(Word name)
+      {
+         if (mHandles[name] < 0)
+         {  mHandles[name] = mContext->insertTagname(mImage.getNameString(name)); }
+         return mHandles[name];
+      }
+
+      const BinaryDocument&         mImage;
+      ContextPtr                    mContext;
+      std::vector<TagNameHandle>    mHandles;   /**< name index -> tagname handle */
+   };
+
+   /** platform data of a mapped image file */
+   struct MappedFile
+   {
+#if defined(WIN32) || defined(WIN64)
+      HANDLE         mFile;
+      HANDLE         mMapping;
+#endif
+      const void*    mView;
+      std::size_t    mSize;
+   };
+
+   namespace
+   {
+      /** maps the whole file read-only, returns NULL on failure */
+      MappedFile* mapReadOnly(const std::string& filename)
+      {
+#if defined(WIN32) || defined(WIN64)
+         HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                   OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+         if (INVALID_HANDLE_VALUE == file)
+         {  return NULL; }
+
+         DWORD size_high(0);
+         DWORD size_low = GetFileSize(file, &size_high);
+         HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+         if (NULL == mapping)
+         {
+            CloseHandle(file);
+            return NULL;
+         }
+         const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+         if (NULL == view)
+         {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return NULL;
+         }
+
+         MappedFile* mapped = new MappedFile;
+         mapped->mFile = file;
+         mapped->mMapping = mapping;
+         mapped->mView = view;
+         mapped->mSize = (std::size_t(size_high) << 16 << 16) | size_low;
+         return mapped;
+#else
+         int fd = ::open(filename.c_str(), O_RDONLY);
+         if (fd < 0)
+         {  return NULL; }
+
+         struct stat info;
+         if (::fstat(fd, &info) != 0 || info.st_size <= 0)
+         {
+            ::close(fd);
+            return NULL;
+         }
+
+         std::size_t size = std::size_t(info.st_size);
+         void* view = ::mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+         ::close(fd);     // the mapping keeps the file referenced
+         if (MAP_FAILED == view)
+         {  return NULL; }
+
+         MappedFile* mapped = new MappedFile;
+         mapped->mView = view;
+         mapped->mSize = size;
+         return mapped;
+#endif
+      }
+
+      void unmap(MappedFile* mapped)
+      {
+#if defined(WIN32) || defined(WIN64)
+         UnmapViewOfFile(mapped->mView);
+         CloseHandle(mapped->mMapping);
+         CloseHandle(mapped->mFile);
+#else
+         ::munmap(const_cast<void*>(mapped->mView), mapped->mSize);
+#endif
+         delete mapped;
+      }
+   }
+}
+
+   // BinaryNode methods
+
+   BinaryNode::BinaryNode()
+      : mDoc(NULL), mIndex(binary::npos)
+   {}
+
+   BinaryNode::BinaryNode(const BinaryDocument* doc, binary::Word index)
+      : mDoc(doc), mIndex(index)
+   {}
+
+   bool BinaryNode::isValid() const
+   {
+      return (mDoc != NULL) && (mIndex != binary::npos);
+   }
+
+   binary::Word BinaryNode::getIndex() const
+   {
+      return mIndex;
+   }
+
+   const binary::NodeRecord& BinaryNode::record() const
+   {
+      return mDoc->getNodeRecord(mIndex);
+   }
+
+   Node::Type BinaryNode::getType() const
+   {
+      return Node::Type(record().mType);
+   }
+
+   const char* BinaryNode::getName() const
+   {
+      return mDoc->getNameString(record().mName);
+   }
+
+   binary::Word BinaryNode::getNameIndex() const
+   {
+      return record().mName;
+   }
+
+   BinaryNode BinaryNode::getParent() const
+   {
+      return BinaryNode(mDoc, record().mParent);
+   }
+
+   BinaryNode BinaryNode::getFirstChild() const
+   {
+      return BinaryNode(mDoc, record().mFirstChild);
+   }
+
+   BinaryNode BinaryNode::getNextSibling() const
+   {
+      return BinaryNode(mDoc, record().mNextSibling);
+   }
+
+   unsigned BinaryNode::getChildCount() const
+   {
+      return record().mChildCount;
+   }
+
+   BinaryNode BinaryNode::getChild(const std::string& name) const
+   {
+      // Resolve the name once, then compare name indices only
+      binary::Word name_index = mDoc->findName(name);
+      if (binary::npos != name_index)
+      {
+         for (binary::Word c = record().mFirstChild; c != binary::npos;
+              c = mDoc->getNodeRecord(c).mNextSibling)
+         {
+            if (mDoc->getNodeRecord(c).mName == name_index)
+            {  return BinaryNode(mDoc, c); }
+         }
+      }
+      return BinaryNode(mDoc, binary::npos);
+   }
+
+   BinaryNode BinaryNode::getChildPath(const std::string& path) const
+   {
+      std::vector<binary::Word> name_path;
+      if (!mDoc->findPath(path, name_path))
+      {  return BinaryNode(mDoc, binary::npos); }
+
+      binary::Word cur(mIndex);
+      for (unsigned i = 0; i < name_path.size() && cur != binary::npos; ++i)
+      {
+         binary::Word c = mDoc->getNodeRecord(cur).mFirstChild;
+         while (c != binary::npos && mDoc->getNodeRecord(c).mName != name_path[i])
+         {  c = mDoc->getNodeRecord(c).mNextSibling; }
+         cur = c;
+      }
+      return BinaryNode(mDoc, cur);
+   }
+
+   bool BinaryNode::hasChild(const std::string& path) const
+   {
+      return getChildPath(path).isValid();
+   }
+
+   std::vector<BinaryNode> BinaryNode::getChildren() const
+   {
+      std::vector<BinaryNode> result;
+      result.reserve(record().mChildCount);
+      for (binary::Word c = record().mFirstChild; c != binary::npos;
+           c = mDoc->getNodeRecord(c).mNextSibling)
+      {
+         result.push_back(BinaryNode(mDoc, c));
+      }
+      return result;
+   }
+
+   std::vector<BinaryNode> BinaryNode::getChildren(const std::string& name) const
+   {
+      std::vector<BinaryNode> result;
+      binary::Word name_index = mDoc->findName(name);
+      if (binary::npos != name_index)
+      {
+         for (binary::Word c = record().mFirstChild; c != binary::npos;
+              c = mDoc->getNodeRecord(c).mNextSibling)
+         {
+            if (mDoc->getNodeRecord(c).mName == name_index)
+            {  result.push_back(BinaryNode(mDoc, c)); }
+         }
+      }
+      return result;
+   }
+
+   unsigned BinaryNode::getAttribCount() const
+   {
+      return record().mAttribCount;
+   }
+
+   const char* BinaryNode::getAttribName(unsigned i) const
+   {
+      return mDoc->getNameString(mDoc->getAttribRecord(record().mFirstAttrib + i).mName);
+   }
+
+   const char* BinaryNode::getAttribValue(unsigned i) const
+   {
+      return mDoc->getPoolString(mDoc->getAttribRecord(record().mFirstAttrib + i).mValueOffset);
+   }
+
+   bool BinaryNode::hasAttribute(const std::string& name) const
+   {
+      binary::Word name_index = mDoc->findName(name);
+      const binary::NodeRecord& rec = record();
+      for (binary::Word a = 0; a < rec.mAttribCount && name_index != binary::npos; ++a)
+      {
+         if (mDoc->getAttribRecord(rec.mFirstAttrib + a).mName == name_index)
+         {  return true; }
+      }
+      return false;
+   }
+
+   const char* BinaryNode::getAttribute(const std::string& name) const
+   {
+      binary::Word name_index = mDoc->findName(name);
+      const binary::NodeRecord& rec = record();
+      for (binary::Word a = 0; a < rec.mAttribCount && name_index != binary::npos; ++a)
+      {
+         const binary::AttribRecord& arec = mDoc->getAttribRecord(rec.mFirstAttrib + a);
+         if (arec.mName == name_index)
+         {  return mDoc->getPoolString(arec.mValueOffset); }
+      }
+      return "";
+   }
+
+   const char* BinaryNode::getCdata() const
+   {
+      const binary::NodeRecord& rec = record();
+      if (binary::hasText(rec.mType))
+      {  return mDoc->getPoolString(rec.mTextOffset); }
+
+      for (binary::Word c = rec.mFirstChild; c != binary::npos;
+           c = mDoc->getNodeRecord(c).mNextSibling)
+      {
+         const binary::NodeRecord& child = mDoc->getNodeRecord(c);
+         if (Node::xml_nt_cdata == child.mType)
+         {  return mDoc->getPoolString(child.mTextOffset); }
+      }
+      return "";
+   }
+
+   std::size_t BinaryNode::getCdataLength() const
+   {
+      const binary::NodeRecord& rec = record();
+      if (binary::hasText(rec.mType))
+      {  return rec.mTextLength; }
+
+      for (binary::Word c = rec.mFirstChild; c != binary::npos;
+           c = mDoc->getNodeRecord(c).mNextSibling)
+      {
+         const binary::NodeRecord& child = mDoc->getNodeRecord(c);
+         if (Node::xml_nt_cdata == child.mType)
+         {  return child.mTextLength; }
+      }
+      return 0;
+   }
+
+   std::string BinaryNode::getFullCdata() const
+   {
+      const binary::NodeRecord& rec = record();
+      if (binary::hasText(rec.mType))
+      {  return std::string(mDoc->getPoolString(rec.mTextOffset), rec.mTextLength); }
+
+      std::string ret_val;
+      for (binary::Word c = rec.mFirstChild; c != binary::npos;
+           c = mDoc->getNodeRecord(c).mNextSibling)
+      {
+         const binary::NodeRecord& child = mDoc->getNodeRecord(c);
+         if (Node::xml_nt_cdata == child.mType)
+         {  ret_val.append(mDoc->getPoolString(child.mTextOffset), child.mTextLength); }
+      }
+      return ret_val;
+   }
+
+   // BinaryDocument methods
+
+   BinaryDocument::BinaryDocument()
+      : mData(NULL), mSize(0), mHeader(NULL), mNames(NULL), mNodes(NULL)
+      , mAttribs(NULL), mPool(NULL), mMapping(NULL)
+   {}
+
+   BinaryDocument::~BinaryDocument()
+   {
+      close();
+   }
+
+   void BinaryDocument::attach(const void* data, std::size_t size)
+   {
+      close();
+      setImage(static_cast<const char*>(data), size);
+   }
+
+   void BinaryDocument::mapFile(const std::string& filename)
+   {
+      close();
+      binary::MappedFile* mapped = binary::mapReadOnly(filename);
+      if (NULL == mapped)
+      {
+         throw CPPDOM_ERROR(xml_file_access, "Could not map binary document file");
+      }
+      mMapping = mapped;
+      setImage(static_cast<const char*>(mapped->mView), mapped->mSize);
+   }
+
+   void BinaryDocument::load(std::istream& in)
+   {
+      close();
+      std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+      // Word storage keeps the tables aligned
+      mOwned.resize((bytes.size() + sizeof(binary::Word) - 1) / sizeof(binary::Word));
+      if (!bytes.empty())
+      {  std::memcpy(&mOwned[0], bytes.data(), bytes.size()); }
+      setImage(mOwned.empty() ? NULL : reinterpret_cast<const char*>(&mOwned[0]), bytes.size());
+   }
+
+   void BinaryDocument::close()
+   {
+      if (NULL != mMapping)
+      {
+         binary::unmap(static_cast<binary::MappedFile*>(mMapping));
+         mMapping = NULL;
+      }
+      mOwned.clear();
+      mNameIndex.clear();
+      mData = NULL;
+      mSize = 0;
+      mHeader = NULL;
+      mNames = NULL;
+      mNodes = NULL;
+      mAttribs = NULL;
+      mPool = NULL;
+   }
+
+   void BinaryDocument::save(std::ostream& out) const
+   {
+      if (NULL != mData)
+      {  out.write(mData, std::streamsize(mSize)); }
+   }
+
+   bool BinaryDocument::isOpen() const
+   {
+      return mHeader != NULL;
+   }
+
+   void BinaryDocument::setImage(const char* data, std::size_t size)
+   {
+      using namespace binary;
+
+      // Any failure leaves the view closed
+      if (NULL == data || size < sizeof(Header) ||
+          (reinterpret_cast<std::size_t>(data) % sizeof(Word)) != 0)
+      {
+         close();
+         throw CPPDOM_ERROR(xml_invalid_binary_format, "Image too small or misaligned");
+      }
+
+      const Header* header = reinterpret_cast<const Header*>(data);
+      if (std::memcmp(header->mMagic, magic, sizeof(magic)) != 0 ||
+          header->mVersion != version || header->mByteOrder != byteOrderMark)
+      {
+         close();
+         throw CPPDOM_ERROR(xml_invalid_binary_format, "Not a binary document image of this version and byte order");
+      }
+
+      // Check the table sizes against the image size without overflowing
+      std::size_t offset = sizeof(Header);
+      std::size_t remaining = size - offset;
+      const std::size_t counts[3] = { header->mNameCount, header->mNodeCount, header->mAttribCount };
+      const std::size_t record_sizes[3] = { sizeof(NameRecord), sizeof(NodeRecord), sizeof(AttribRecord) };
+      std::size_t table_offsets[3];
+      for (unsigned t = 0; t < 3; ++t)
+      {
+         if (counts[t] > remaining / record_sizes[t])
+         {
+            close();
+            throw CPPDOM_ERROR(xml_invalid_binary_format, "Image tables exceed the image");
+         }
+         table_offsets[t] = offset;
+         offset += counts[t] * record_sizes[t];
+         remaining -= counts[t] * record_sizes[t];
+      }
+      if (remaining != header->mPoolSize || header->mNodeCount == 0)
+      {
+         close();
+         throw CPPDOM_ERROR(xml_invalid_binary_format, "Image has a bad string pool or no nodes");
+      }
+
+      const NameRecord* names = reinterpret_cast<const NameRecord*>(data + table_offsets[0]);
+      const NodeRecord* nodes = reinterpret_cast<const NodeRecord*>(data + table_offsets[1]);
+      const AttribRecord* attribs = reinterpret_cast<const AttribRecord*>(data + table_offsets[2]);
+      const char* pool = data + offset;
+      const Word pool_size = header->mPoolSize;
+      const Word node_count = header->mNodeCount;
+
+      // Validate every reference once, so accessors can trust the image
+      bool valid = (header->mFirstPi == npos) || (header->mFirstPi < node_count);
+      for (Word n = 0; valid && n < header->mNameCount; ++n)
+      {
+         valid = (names[n].mOffset < pool_size) &&
+                 (names[n].mLength < pool_size - names[n].mOffset) &&
+                 (pool[names[n].mOffset + names[n].mLength] == '\0');
+      }
+      for (Word a = 0; valid && a < header->mAttribCount; ++a)
+      {
+         valid = (attribs[a].mName < header->mNameCount) &&
+                 (attribs[a].mValueOffset < pool_size) &&
+                 (attribs[a].mValueLength < pool_size - attribs[a].mValueOffset) &&
+                 (pool[attribs[a].mValueOffset + attribs[a].mValueLength] == '\0');
+      }
+      for (Word i = 0; valid && i < node_count; ++i)
+      {
+         const NodeRecord& rec = nodes[i];
+         valid = (rec.mType <= Word(Node::xml_nt_pi)) &&
+                 (rec.mName < header->mNameCount) &&
+                 (rec.mParent == npos || rec.mParent < i) &&
+                 (rec.mFirstChild == npos || rec.mFirstChild > i) &&
+                 (rec.mFirstChild == npos || rec.mFirstChild < node_count) &&
+                 (rec.mNextSibling == npos || rec.mNextSibling > i) &&
+                 (rec.mNextSibling == npos || rec.mNextSibling < node_count) &&
+                 (rec.mFirstAttrib <= header->mAttribCount) &&
+                 (rec.mAttribCount <= header->mAttribCount - rec.mFirstAttrib) &&
+                 (!hasText(rec.mType) ||
+                  ((rec.mTextOffset < pool_size) &&
+                   (rec.mTextLength < pool_size - rec.mTextOffset) &&
+                   (pool[rec.mTextOffset + rec.mTextLength] == '\0')));
+      }
+
+      // Every node is on at most one chain of siblings, and the child
+      // counts are the lengths of the chains; readers reserve by them
+      std::vector<char> linked(valid ? node_count : 0, 0);
+      for (Word c = header->mFirstPi; valid && c != npos; c = nodes[c].mNextSibling)
+      {
+         valid = (linked[c] == 0);
+         linked[c] = 1;
+      }
+      for (Word i = 0; valid && i < node_count; ++i)
+      {
+         Word length(0);
+         for (Word c = nodes[i].mFirstChild; valid && c != npos; c = nodes[c].mNextSibling)
+         {
+            valid = (linked[c] == 0);
+            linked[c] = 1;
+            ++length;
+         }
+         valid = valid && (length == nodes[i].mChildCount);
+      }
+      if (!valid)
+      {
+         close();
+         throw CPPDOM_ERROR(xml_invalid_binary_format, "Image contains an invalid reference");
+      }
+
+      mData = data;
+      mSize = size;
+      mHeader = header;
+      mNames = names;
+      mNodes = nodes;
+      mAttribs = attribs;
+      mPool = pool;
+
+      // Lookups by name are the common query, hash the (few) names once
+      for (Word n = 0; n < header->mNameCount; ++n)
+      {
+         mNameIndex[std::string(pool + names[n].mOffset, names[n].mLength)] = TagNameHandle(n);
+      }
+   }
+
+   BinaryNode BinaryDocument::getDocument() const
+   {
+      return BinaryNode(this, 0);
+   }
+
+   BinaryNode BinaryDocument::getRootElement() const
+   {
+      for (binary::Word c = mNodes[0].mFirstChild; c != binary::npos; c = mNodes[c].mNextSibling)
+      {
+         if (!binary::hasText(mNodes[c].mType))
+         {  return BinaryNode(this, c); }
+      }
+      return BinaryNode(this, binary::npos);
+   }
+
+   BinaryNode BinaryDocument::getFirstPi() const
+   {
+      return BinaryNode(this, mHeader->mFirstPi);
+   }
+
+   binary::Word BinaryDocument::getNodeCount() const
+   {
+      return (NULL == mHeader) ? 0 : mHeader->mNodeCount;
+   }
+
+   binary::Word BinaryDocument::getNameCount() const
+   {
+      return (NULL == mHeader) ? 0 : mHeader->mNameCount;
+   }
+
+   const char* BinaryDocument::getNameString(binary::Word nameIndex) const
+   {
+      return mPool + mNames[nameIndex].mOffset;
+   }
+
+   binary::Word BinaryDocument::findName(const std::string& name) const
+   {
+      NameToTagMap_t::const_iterator found = mNameIndex.find(name);
+      return (found == mNameIndex.end()) ? binary::npos : binary::Word((*found).second);
+   }
+
+   bool BinaryDocument::findPath(const std::string& path, std::vector<binary::Word>& nameIndices) const
+   {
+      std::vector<std::string> node_path;
+      splitStr(path, "/", std::back_inserter(node_path));
+      nameIndices.clear();
+      nameIndices.reserve(node_path.size());
+      for (unsigned i = 0; i < node_path.size(); ++i)
+      {
+         binary::Word name_index = findName(node_path[i]);
+         if (binary::npos == name_index)
+         {  return false; }
+         nameIndices.push_back(name_index);
+      }
+      return !nameIndices.empty();
+   }
+
+   const binary::NodeRecord& BinaryDocument::getNodeRecord(binary::Word index) const
+   {
+      return mNodes[index];
+   }
+
+   const binary::AttribRecord& BinaryDocument::getAttribRecord(binary::Word index) const
+   {
+      return mAttribs[index];
+   }
+
+   const char* BinaryDocument::getPoolString(binary::Word offset) const
+   {
+      return mPool + offset;
+   }
+
+   // FrozenDocument methods
+
+   FrozenDocument::FrozenDocument(Document& doc)
+   {
+      binary::ImageBuilder builder(doc.getContext());
+      builder.addDocument(doc);
+      std::size_t size = builder.write(mOwned);
+      setImage(reinterpret_cast<const char*>(&mOwned[0]), size);
+   }
+
+   // Document binary methods
+
+   void Document::saveBinary(std::ostream& out)
+   {
+      binary::ImageBuilder builder(mContext);
+      builder.addDocument(*this);
+      builder.write(out);
+   }
+
+   void Document::saveBinaryFile(const std::string& filename)
+   {
+      std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+      if (!out.good())
+      {
+         throw CPPDOM_ERROR(xml_filename_invalid, "Filename passed to saveBinaryFile was invalid");
+      }
+      saveBinary(out);
+   }
+
+   void Document::loadBinary(std::istream& in)
+   {
+      BinaryDocument image;
+      image.load(in);
+      loadBinary(image);
+   }
+
+   void Document::loadBinary(const BinaryDocument& image)
+   {
+      if (!image.isOpen())
+      {
+         throw CPPDOM_ERROR(xml_invalid_argument, "Attempted to load from a closed binary image");
+      }
+
+      binary::TreeBuilder builder(image, mContext);
+      builder.clear(*this);
+      mProcInstructions.clear();
+      builder.fill(*this, 0);
+      mNodeType = Node::xml_nt_document;
+
+      for (BinaryNode pi = image.getFirstPi(); pi.isValid(); pi = pi.getNextSibling())
+      {
+         mProcInstructions.push_back(builder.createPi(pi.getIndex()));
+      }
+      rebuildIndexes();
+   }
+
+   void Document::loadBinaryFile(const std::string& filename)
+   {
+      BinaryDocument image;
+      image.mapFile(filename);
+      loadBinary(image);
+   }
+
+   FrozenDocumentPtr Document::freeze()
+   {
+      return FrozenDocumentPtr(new FrozenDocument(*this));
+   }
+}
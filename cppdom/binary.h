@@ -0,0 +1,341 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file binary.h
+
+  compact binary snapshot format for documents
+
+  A snapshot ("image") is a single block of memory laid out as
+
+     Header | NameRecord[] | NodeRecord[] | AttribRecord[] | string pool
+
+  Every integer is a native 32-bit word and every string in the pool is
+  NUL terminated, so an image can be used in place, straight from a
+  read-only memory mapping, without allocating anything per node.
+  Nodes are stored in document order with first-child/next-sibling links.
+
+  FrozenDocument uses the same layout for an immutable in-memory copy of
+  a document that is cheap to traverse and safe to share between threads.
+*/
+
+// prevent multiple includes
+#ifndef CPPDOM_BINARY_H
+#define CPPDOM_BINARY_H
+
+// needed includes
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cppdom/cppdom.h>
+
+// namespace declaration
+namespace cppdom
+{
+   /** definitions of the on-disk snapshot layout */
+   namespace binary
+   {
+      /** every integer in an image is one of these */
+      typedef unsigned int Word;
+
+      /** reference to no node, attribute or name */
+      const Word npos = 0xffffffffu;
+
+      /** version of the layout written by this library */
+      const Word version = 1;
+
+      /** written in native byte order, used to reject foreign images */
+      const Word byteOrderMark = 0x01020304u;
+
+      /** image header, always at offset 0 */
+      struct Header
+      {
+         char  mMagic[4];        /**< "CPDB" */
+         Word  mVersion;         /**< layout version */
+         Word  mByteOrder;       /**< byteOrderMark as written by the producer */
+         Word  mNameCount;       /**< number of entries in the name table */
+         Word  mNodeCount;       /**< number of node records, node 0 is the document */
+         Word  mAttribCount;     /**< number of attribute records */
+         Word  mPoolSize;        /**< size of the string pool in bytes */
+         Word  mFirstPi;         /**< first processing instruction node or npos */
+      };
+
+      /** element and attribute names, shared by all nodes */
+      struct NameRecord
+      {
+         Word  mOffset;          /**< pool offset of the name */
+         Word  mLength;          /**< length of the name without the NUL */
+      };
+
+      /** one node of the tree */
+      struct NodeRecord
+      {
+         Word  mType;            /**< the Node::Type of the node */
+         Word  mName;            /**< index into the name table */
+         Word  mParent;          /**< parent node or npos */
+         Word  mFirstChild;      /**< first child node or npos */
+         Word  mNextSibling;     /**< next sibling node or npos */
+         Word  mChildCount;      /**< number of children */
+         Word  mFirstAttrib;     /**< index of the first attribute record */
+         Word  mAttribCount;     /**< number of attribute records */
+         Word  mTextOffset;      /**< pool offset of the cdata (cdata, comment and pi nodes) */
+         Word  mTextLength;      /**< length of the cdata */
+      };
+
+      /** one attribute, the records of a node are consecutive */
+      struct AttribRecord
+      {
+         Word  mName;            /**< index into the name table */
+         Word  mValueOffset;     /**< pool offset of the value */
+         Word  mValueLength;     /**< length of the value */
+      };
+   }
+
+   class BinaryDocument;
+
+   /**
+    * Handle to a node inside a BinaryDocument.
+    * A handle is just a document pointer and a node index; it is only valid
+    * as long as the BinaryDocument it came from.
+    */
+   class CPPDOM_CLASS BinaryNode
+   {
+   public:
+      /** constructs an invalid handle */
+      BinaryNode();
+
+      /** constructs a handle to the node with the given index */
+      BinaryNode(const BinaryDocument* doc, binary::Word index);
+
+      /** returns false for the handle returned when there is no such node */
+      bool isValid() const;
+
+      /** returns the index of the node record */
+      binary::Word getIndex() const;
+
+      /** returns type of node */
+      Node::Type getType() const;
+
+      /** returns the element name of the node */
+      const char* getName() const;
+
+      /** returns the index of the name in the name table */
+      binary::Word getNameIndex() const;
+
+      /** @name Navigation */
+      //@{
+      BinaryNode getParent() const;
+      BinaryNode getFirstChild() const;
+      BinaryNode getNextSibling() const;
+      unsigned getChildCount() const;
+
+      /** Returns the first child of the given local name. */
+      BinaryNode getChild(const std::string& name) const;
+
+      /** Return first child of the given name.
+       * @param path    Name can be a single element name or a chain of the form "tag/tag/tag"
+       */
+      BinaryNode getChildPath(const std::string& path) const;
+
+      /** Returns true if the node has a child of the given name or path. */
+      bool hasChild(const std::string& path) const;
+
+      /** returns a list of the nodes children */
+      std::vector<BinaryNode> getChildren() const;
+
+      /** Returns a list of all children with local name of childName */
+      std::vector<BinaryNode> getChildren(const std::string& name) const;
+      //@}
+
+      /** @name Attribute information */
+      //@{
+      unsigned getAttribCount() const;
+      const char* getAttribName(unsigned i) const;
+      const char* getAttribValue(unsigned i) const;
+
+      /** Check if the node has a given attribute */
+      bool hasAttribute(const std::string& name) const;
+
+      /**
+       * Get the named attribute.
+       * @returns empty string ("") if not found, else the value
+       */
+      const char* getAttribute(const std::string& name) const;
+      //@}
+
+      /**
+       * returns cdata string
+       * @note: For node type "cdata", this returns the local cdata.
+       *        Comment and pi nodes return their text.
+       *        For other nodes, this returns the data of the first cdata
+       *        child or an empty string.
+       */
+      const char* getCdata() const;
+
+      /** returns the length of the string returned by getCdata() */
+      std::size_t getCdataLength() const;
+
+      /**
+       * Returns the full cdata of the node or immediate children.
+       * @see Node::getFullCdata
+       */
+      std::string getFullCdata() const;
+
+   protected:
+      const binary::NodeRecord& record() const;
+
+      const BinaryDocument*   mDoc;    /**< the image the node lives in */
+      binary::Word            mIndex;  /**< index of the node record */
+   };
+
+   /**
+    * Read-only view of a binary snapshot written by Document::saveBinary().
+    *
+    * The image can be attached from memory, read from a stream or mapped
+    * straight from a file. Navigating the view never allocates; use
+    * Document::loadBinary() to turn it back into a mutable node tree.
+    */
+   class CPPDOM_CLASS BinaryDocument
+   {
+   public:
+      BinaryDocument();
+      ~BinaryDocument();
+
+      /**
+       * Views an image that is already in memory. The memory must be aligned
+       * to at least 4 bytes and stay unchanged while the view is in use.
+       * \exception throws cppdom::Error when the image is malformed
+       */
+      void attach(const void* data, std::size_t size);
+
+      /**
+       * Maps the given file read-only and views it.
+       * \exception throws cppdom::Error when the file can not be mapped or
+       *            does not hold a valid image
+       */
+      void mapFile(const std::string& filename);
+
+      /**
+       * Reads an image from the stream into memory owned by the view.
+       * \exception throws cppdom::Error when the image is malformed
+       */
+      void load(std::istream& in);
+
+      /** releases the image */
+      void close();
+
+      /** writes the image to a stream, the result can be loaded again */
+      void save(std::ostream& out) const;
+
+      /** returns true when an image is attached */
+      bool isOpen() const;
+
+      /** returns the document node */
+      BinaryNode getDocument() const;
+
+      /** returns the first element below the document node */
+      BinaryNode getRootElement() const;
+
+      /** returns the first processing instruction, their siblings are the others */
+      BinaryNode getFirstPi() const;
+
+      /** returns the number of nodes in the image */
+      binary::Word getNodeCount() const;
+
+      /** returns the number of names in the name table */
+      binary::Word getNameCount() const;
+
+      /** returns an entry of the name table */
+      const char* getNameString(binary::Word nameIndex) const;
+
+      /** looks up a name in the name table, returns binary::npos if not used */
+      binary::Word findName(const std::string& name) const;
+
+      /** looks up every element of a "tag/tag/tag" path in the name table */
+      bool findPath(const std::string& path, std::vector<binary::Word>& nameIndices) const;
+
+      /** @name Raw table access */
+      //@{
+      const binary::NodeRecord& getNodeRecord(binary::Word index) const;
+      const binary::AttribRecord& getAttribRecord(binary::Word index) const;
+      const char* getPoolString(binary::Word offset) const;
+      //@}
+
+   protected:
+      /** checks the image and sets up the table pointers */
+      void setImage(const char* data, std::size_t size);
+
+   private:
+      BinaryDocument(const BinaryDocument&);
+      BinaryDocument& operator=(const BinaryDocument&);
+
+   protected:
+      const char*                   mData;      /**< start of the image */
+      std::size_t                   mSize;      /**< size of the image in bytes */
+      const binary::Header*         mHeader;    /**< the image header */
+      const binary::NameRecord*     mNames;     /**< the name table */
+      const binary::NodeRecord*     mNodes;     /**< the node records */
+      const binary::AttribRecord*   mAttribs;   /**< the attribute records */
+      const char*                   mPool;      /**< the string pool */
+
+      NameToTagMap_t                mNameIndex; /**< name string -> name table index */
+
+      std::vector<binary::Word>     mOwned;     /**< storage for images read or built in memory */
+      void*                         mMapping;   /**< platform data of a mapped file */
+   };
+
+   /** handle to a node of a FrozenDocument */
+   typedef BinaryNode FrozenNode;
+
+   /**
+    * Immutable, flattened copy of a document for query-heavy use.
+    *
+    * Nodes live in one array in document order with first-child and
+    * next-sibling indices; names, attributes and text live in pools.
+    * Everything is const and handles are plain values, so a frozen document
+    * can be read by any number of threads without reference counting.
+    */
+   class CPPDOM_CLASS FrozenDocument : public BinaryDocument
+   {
+   public:
+      /** flattens the given document; later changes to it are not seen */
+      explicit FrozenDocument(Document& doc);
+   };
+}
+
+#endif
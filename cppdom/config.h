@@ -116,5 +116,37 @@
 #  define CPPDOM_CLASS
 #endif
 
+// -----------------------------------
+// threading support of the standard library
+#if !defined(CPPDOM_HAS_STD_THREAD) && !defined(CPPDOM_NO_THREADS)
+#  if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1700)
+#     define CPPDOM_HAS_STD_THREAD
+#  endif
+#endif
+
+// -----------------------------------
+// <charconv> number conversion (C++17)
+#if !defined(CPPDOM_HAS_CHARCONV) && !defined(CPPDOM_NO_CHARCONV)
+#  if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#     define CPPDOM_HAS_CHARCONV
+#  endif
+#endif
+
+// -----------------------------------
+// rvalue references and move semantics (C++11)
+#if !defined(CPPDOM_HAS_RVALUE_REFERENCES) && !defined(CPPDOM_NO_RVALUE_REFERENCES)
+#  if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1600)
+#     define CPPDOM_HAS_RVALUE_REFERENCES
+#  endif
+#endif
+
+// -----------------------------------
+// 64 bit integer type (C++11, or an extension of the compiler)
+#if !defined(CPPDOM_HAS_LONG_LONG)
+#  if __cplusplus >= 201103L || defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1400)
+#     define CPPDOM_HAS_LONG_LONG
+#  endif
+#endif
+
 // -----------------------------------
 #endif
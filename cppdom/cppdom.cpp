@@ -46,11 +46,32 @@
 #include <fstream>
 #include <string>
 #include <iterator>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <cctype>
+#include <cerrno>
+#include <cfloat>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 // needed includes
 #include <cppdom/cppdom.h>
+
+#ifdef CPPDOM_HAS_CHARCONV
+#  include <charconv>
+#  if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#     define CPPDOM_HAS_FLOAT_CHARCONV
+#  endif
+#endif
+
 #include <cppdom/xmlparser.h>
+#include <cppdom/lazy.h>
+#include <cppdom/base64.h>
 #include <cppdom/predicates.h>
+#include <cppdom/tagtable.h>
 #include <cppdom/version.h>
 
 
@@ -175,10 +196,446 @@ namespace cppdom
    }
 
 
+   // Value conversion helpers
+   namespace
+   {
+#ifdef CPPDOM_HAS_LONG_LONG
+      typedef long long          LongestInt;
+      typedef unsigned long long LongestUInt;
+#else
+      typedef long               LongestInt;
+      typedef unsigned long      LongestUInt;
+#endif
+
+      inline bool isSpace(char c)
+      {
+         return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+      }
+
+      /** narrows [first, last) to text without surrounding whitespace */
+      bool trimText(const std::string& text, const char*& first, const char*& last)
+      {
+         first = text.c_str();
+         last = first + text.size();
+         while (first != last && isSpace(*first))
+         {  ++first; }
+         while (last != first && isSpace(*(last - 1)))
+         {  --last; }
+         return first != last;
+      }
+
+      // The parse functions below take one value [first, last). *last is
+      // whitespace or the terminating NUL of the string, the C library
+      // fallbacks rely on that to stop.
+
+      /** parses [first, last) as a whole base 10 integer */
+      bool parseLongest(const char* first, const char* last, LongestInt& value)
+      {
+         // operator>> accepts a leading '+', from_chars and friends may not
+         if (*first == '+' && last - first > 1 && first[1] != '-')
+         {  ++first; }
+#ifdef CPPDOM_HAS_CHARCONV
+         std::from_chars_result result = std::from_chars(first, last, value);
+         return result.ec == std::errc() && result.ptr == last;
+#else
+         char* end;
+         errno = 0;
+#  ifdef CPPDOM_HAS_LONG_LONG
+#     if defined(_MSC_VER) && _MSC_VER < 1800
+         value = _strtoi64(first, &end, 10);
+#     else
+         value = strtoll(first, &end, 10);
+#     endif
+#  else
+         value = std::strtol(first, &end, 10);
+#  endif
+         return errno == 0 && end == last && std::isdigit((unsigned char)*(last - 1));
+#endif
+      }
+
+      bool parseLongest(const char* first, const char* last, LongestUInt& value)
+      {
+         if (*first == '+' && last - first > 1 && first[1] != '-')
+         {  ++first; }
+         if (*first == '-')
+         {  return false; }
+#ifdef CPPDOM_HAS_CHARCONV
+         std::from_chars_result result = std::from_chars(first, last, value);
+         return result.ec == std::errc() && result.ptr == last;
+#else
+         char* end;
+         errno = 0;
+#  ifdef CPPDOM_HAS_LONG_LONG
+#     if defined(_MSC_VER) && _MSC_VER < 1800
+         value = _strtoui64(first, &end, 10);
+#     else
+         value = strtoull(first, &end, 10);
+#     endif
+#  else
+         value = std::strtoul(first, &end, 10);
+#  endif
+         return errno == 0 && end == last && std::isdigit((unsigned char)*(last - 1));
+#endif
+      }
+
+      /** parses an integer of type T, checking its range */
+      template<class T, class Longest>
+      bool parseInteger(const char* first, const char* last, T& value)
+      {
+         Longest longest;
+         if (!parseLongest(first, last, longest))
+         {  return false; }
+         if (longest < Longest(std::numeric_limits<T>::min()) ||
+             longest > Longest(std::numeric_limits<T>::max()))
+         {  return false; }
+         value = T(longest);
+         return true;
+      }
+
+#ifndef CPPDOM_HAS_FLOAT_CHARCONV
+      /** the decimal point of the C locale in effect, '.' in the "C" locale */
+      char localeDecimalPoint()
+      {
+         const char* point = std::localeconv()->decimal_point;
+         return (point != NULL && *point != '\0') ? *point : '.';
+      }
+#endif
+
+      bool parseDouble(const char* first, const char* last, double& value)
+      {
+         if (*first == '+' && last - first > 1 && first[1] != '-')
+         {  ++first; }
+#ifdef CPPDOM_HAS_FLOAT_CHARCONV
+         std::from_chars_result result = std::from_chars(first, last, value);
+         return result.ec == std::errc() && result.ptr == last;
+#else
+         // strtod also reads hex floats, from_chars and operator>> do not
+         if (std::find(first, last, 'x') != last || std::find(first, last, 'X') != last)
+         {  return false; }
+
+         char* end;
+         errno = 0;
+         const char point = localeDecimalPoint();
+         if (point == '.')
+         {
+            value = std::strtod(first, &end);
+            return errno == 0 && end == last;
+         }
+
+         // strtod uses the locale's decimal point, xml always uses '.'
+         std::string number(first, last);
+         std::replace(number.begin(), number.end(), '.', point);
+         value = std::strtod(number.c_str(), &end);
+         return errno == 0 && end == number.c_str() + number.size();
+#endif
+      }
+
+      bool parseFloat(const char* first, const char* last, float& value)
+      {
+         double d;
+         if (!parseDouble(first, last, d) || (d == d && (d > FLT_MAX || d < -FLT_MAX) &&
+                                              d <= DBL_MAX && d >= -DBL_MAX))
+         {  return false; }
+         value = float(d);
+         return true;
+      }
+
+      /** the parse function for each type */
+      inline bool parseToken(const char* f, const char* l, short& v)
+      {  return parseInteger<short, LongestInt>(f, l, v); }
+      inline bool parseToken(const char* f, const char* l, unsigned short& v)
+      {  return parseInteger<unsigned short, LongestUInt>(f, l, v); }
+      inline bool parseToken(const char* f, const char* l, int& v)
+      {  return parseInteger<int, LongestInt>(f, l, v); }
+      inline bool parseToken(const char* f, const char* l, unsigned int& v)
+      {  return parseInteger<unsigned int, LongestUInt>(f, l, v); }
+      inline bool parseToken(const char* f, const char* l, long& v)
+      {  return parseInteger<long, LongestInt>(f, l, v); }
+      inline bool parseToken(const char* f, const char* l, unsigned long& v)
+      {  return parseInteger<unsigned long, LongestUInt>(f, l, v); }
+#ifdef CPPDOM_HAS_LONG_LONG
+      inline bool parseToken(const char* f, const char* l, long long& v)
+      {  return parseInteger<long long, LongestInt>(f, l, v); }
+      inline bool parseToken(const char* f, const char* l, unsigned long long& v)
+      {  return parseInteger<unsigned long long, LongestUInt>(f, l, v); }
+#endif
+      inline bool parseToken(const char* f, const char* l, float& v)
+      {  return parseFloat(f, l, v); }
+      inline bool parseToken(const char* f, const char* l, double& v)
+      {  return parseDouble(f, l, v); }
+
+      template<class T>
+      bool parseTrimmed(const std::string& text, T& value)
+      {
+         const char* first;
+         const char* last;
+         return trimText(text, first, last) && parseToken(first, last, value);
+      }
+
+      /** parses whitespace separated values, reusing the vector's storage */
+      template<class T>
+      bool parseValues(const std::string& text, std::vector<T>& values)
+      {
+         values.clear();
+         const char* p = text.c_str();
+         const char* end = p + text.size();
+         for (;;)
+         {
+            while (p != end && isSpace(*p))
+            {  ++p; }
+            if (p == end)
+            {  return true; }
+
+            const char* token = p;
+            while (p != end && !isSpace(*p))
+            {  ++p; }
+
+            T value;
+            if (!parseToken(token, p, value))
+            {  return false; }
+            values.push_back(value);
+         }
+      }
+
+      /** longest text an integer or floating point value is written as */
+      const std::size_t maxNumberChars = 32;
+
+      /** writes value to buffer, returns the end of it */
+      template<class T>
+      char* writeInteger(char* buffer, T value)
+      {
+#ifdef CPPDOM_HAS_CHARCONV
+         return std::to_chars(buffer, buffer + maxNumberChars, value).ptr;
+#else
+         // Digits backwards from the end of the buffer, then moved to the front
+         char digits[maxNumberChars];
+         char* p = digits + maxNumberChars;
+         const bool negative = value < T(0);
+         do
+         {
+            const int digit = int(value % 10);
+            *--p = char('0' + (negative ? -digit : digit));
+            value /= 10;
+         }
+         while (value != 0);
+         if (negative)
+         {  *--p = '-'; }
+         return std::copy(p, digits + maxNumberChars, buffer);
+#endif
+      }
+
+      /** writes value like an ostream with default settings ("%g") */
+      template<class T>
+      char* writeFloat(char* buffer, T value)
+      {
+#ifdef CPPDOM_HAS_FLOAT_CHARCONV
+         return std::to_chars(buffer, buffer + maxNumberChars, value,
+                              std::chars_format::general, 6).ptr;
+#else
+         char* end = buffer + std::sprintf(buffer, "%.6g", double(value));
+         const char point = localeDecimalPoint();
+         if (point != '.')
+         {  std::replace(buffer, end, point, '.'); }
+         return end;
+#endif
+      }
+
+      /** the write function for each type */
+      inline char* writeToken(char* b, short v)                { return writeInteger(b, v); }
+      inline char* writeToken(char* b, unsigned short v)       { return writeInteger(b, v); }
+      inline char* writeToken(char* b, int v)                  { return writeInteger(b, v); }
+      inline char* writeToken(char* b, unsigned int v)         { return writeInteger(b, v); }
+      inline char* writeToken(char* b, long v)                 { return writeInteger(b, v); }
+      inline char* writeToken(char* b, unsigned long v)        { return writeInteger(b, v); }
+#ifdef CPPDOM_HAS_LONG_LONG
+      inline char* writeToken(char* b, long long v)            { return writeInteger(b, v); }
+      inline char* writeToken(char* b, unsigned long long v)   { return writeInteger(b, v); }
+#endif
+      inline char* writeToken(char* b, float v)                { return writeFloat(b, v); }
+      inline char* writeToken(char* b, double v)               { return writeFloat(b, v); }
+
+      template<class T>
+      void formatToken(std::string& text, T value)
+      {
+         char buffer[maxNumberChars];
+         text.assign(buffer, writeToken(buffer, value));
+      }
+
+      /** writes values separated by single spaces */
+      template<class T>
+      void formatValues(std::string& text, const T* values, std::size_t count)
+      {
+         text.clear();
+         text.reserve(count * 8);
+         char buffer[maxNumberChars + 1];
+         for (std::size_t i = 0; i < count; ++i)
+         {
+            char* first = buffer + 1;
+            if (i != 0)
+            {
+               buffer[0] = ' ';
+               first = buffer;
+            }
+            text.append(first, writeToken(buffer + 1, values[i]));
+         }
+      }
+   }
+
+   bool parseValue(const std::string& text, bool& value)
+   {
+      const char* first;
+      const char* last;
+      if (!trimText(text, first, last))
+      {  return false; }
+
+      const std::string word(first, last);
+      if (word == "1" || word == "true")
+      {  value = true; }
+      else if (word == "0" || word == "false")
+      {  value = false; }
+      else
+      {  return false; }
+      return true;
+   }
+
+   bool parseValue(const std::string& text, short& value)
+   {  return parseTrimmed(text, value); }
+
+   bool parseValue(const std::string& text, unsigned short& value)
+   {  return parseTrimmed(text, value); }
+
+   bool parseValue(const std::string& text, int& value)
+   {  return parseTrimmed(text, value); }
+
+   bool parseValue(const std::string& text, unsigned int& value)
+   {  return parseTrimmed(text, value); }
+
+   bool parseValue(const std::string& text, long& value)
+   {  return parseTrimmed(text, value); }
+
+   bool parseValue(const std::string& text, unsigned long& value)
+   {  return parseTrimmed(text, value); }
+
+#ifdef CPPDOM_HAS_LONG_LONG
+   bool parseValue(const std::string& text, long long& value)
+   {  return parseTrimmed(text, value); }
+
+   bool parseValue(const std::string& text, unsigned long long& value)
+   {  return parseTrimmed(text, value); }
+#endif
+
+   bool parseValue(const std::string& text, float& value)
+   {  return parseTrimmed(text, value); }
+
+   bool parseValue(const std::string& text, double& value)
+   {  return parseTrimmed(text, value); }
+
+   void formatValue(std::string& text, bool value)
+   {  text = value ? "1" : "0"; }
+
+   void formatValue(std::string& text, short value)
+   {  formatToken(text, value); }
+
+   void formatValue(std::string& text, unsigned short value)
+   {  formatToken(text, value); }
+
+   void formatValue(std::string& text, int value)
+   {  formatToken(text, value); }
+
+   void formatValue(std::string& text, unsigned int value)
+   {  formatToken(text, value); }
+
+   void formatValue(std::string& text, long value)
+   {  formatToken(text, value); }
+
+   void formatValue(std::string& text, unsigned long value)
+   {  formatToken(text, value); }
+
+#ifdef CPPDOM_HAS_LONG_LONG
+   void formatValue(std::string& text, long long value)
+   {  formatToken(text, value); }
+
+   void formatValue(std::string& text, unsigned long long value)
+   {  formatToken(text, value); }
+#endif
+
+   void formatValue(std::string& text, float value)
+   {  formatToken(text, value); }
+
+   void formatValue(std::string& text, double value)
+   {  formatToken(text, value); }
+
+   bool parseArray(const std::string& text, std::vector<short>& values)
+   {  return parseValues(text, values); }
+
+   bool parseArray(const std::string& text, std::vector<unsigned short>& values)
+   {  return parseValues(text, values); }
+
+   bool parseArray(const std::string& text, std::vector<int>& values)
+   {  return parseValues(text, values); }
+
+   bool parseArray(const std::string& text, std::vector<unsigned int>& values)
+   {  return parseValues(text, values); }
+
+   bool parseArray(const std::string& text, std::vector<long>& values)
+   {  return parseValues(text, values); }
+
+   bool parseArray(const std::string& text, std::vector<unsigned long>& values)
+   {  return parseValues(text, values); }
+
+#ifdef CPPDOM_HAS_LONG_LONG
+   bool parseArray(const std::string& text, std::vector<long long>& values)
+   {  return parseValues(text, values); }
+
+   bool parseArray(const std::string& text, std::vector<unsigned long long>& values)
+   {  return parseValues(text, values); }
+#endif
+
+   bool parseArray(const std::string& text, std::vector<float>& values)
+   {  return parseValues(text, values); }
+
+   bool parseArray(const std::string& text, std::vector<double>& values)
+   {  return parseValues(text, values); }
+
+   void formatArray(std::string& text, const short* values, std::size_t count)
+   {  formatValues(text, values, count); }
+
+   void formatArray(std::string& text, const unsigned short* values, std::size_t count)
+   {  formatValues(text, values, count); }
+
+   void formatArray(std::string& text, const int* values, std::size_t count)
+   {  formatValues(text, values, count); }
+
+   void formatArray(std::string& text, const unsigned int* values, std::size_t count)
+   {  formatValues(text, values, count); }
+
+   void formatArray(std::string& text, const long* values, std::size_t count)
+   {  formatValues(text, values, count); }
+
+   void formatArray(std::string& text, const unsigned long* values, std::size_t count)
+   {  formatValues(text, values, count); }
+
+#ifdef CPPDOM_HAS_LONG_LONG
+   void formatArray(std::string& text, const long long* values, std::size_t count)
+   {  formatValues(text, values, count); }
+
+   void formatArray(std::string& text, const unsigned long long* values, std::size_t count)
+   {  formatValues(text, values, count); }
+#endif
+
+   void formatArray(std::string& text, const float* values, std::size_t count)
+   {  formatValues(text, values, count); }
+
+   void formatArray(std::string& text, const double* values, std::size_t count)
+   {  formatValues(text, values, count); }
+
+
    // Error methods
    Error::Error(ErrorCode code, std::string localDesc, std::string location)
       : mErrorCode(code), mLocalDesc(localDesc), mLocation(location)
-   {}
+   {
+      mWhat = getString();
+   }
 
    Error::Error(ErrorCode code, std::string localDesc, std::string file, unsigned line_num)
       : mErrorCode(code), mLocalDesc(localDesc)
@@ -186,6 +643,7 @@ namespace cppdom
       std::stringstream location_stream;
       location_stream << file << ":" << line_num;
       mLocation = location_stream.str();
+      mWhat = getString();
    }
 
    Error::~Error() throw()
@@ -222,6 +680,8 @@ namespace cppdom
          XMLERRORCODE(xml_invalid_operation, "attempted to execute command that would cause invalid structure");
          XMLERRORCODE(xml_invalid_argument,  "attempted to use an invalid argument");
          XMLERRORCODE(xml_escaping_failure, "error with escaping in XML data");
+         XMLERRORCODE(xml_invalid_binary_format, "invalid binary document image");
+         XMLERRORCODE(xml_invalid_base64, "invalid base64 text");
 
          XMLERRORCODE(xml_dummy,"dummy error code (this error should never been seen)");
       }
@@ -241,8 +701,7 @@ namespace cppdom
 
    const char* Error::what() const throw()
    {
-      std::string error_desc = getString();
-      return error_desc.c_str();
+      return mWhat.c_str();
    }
 
    //LLocation methods
@@ -278,52 +737,49 @@ namespace cppdom
       mLine = mPos = 0;
    }
 
+   void Location::set(int line, int pos)
+   {
+      mLine = line;
+      mPos = pos;
+   }
+
    // Context methods
 
    Context::Context()
-      : mEventHandler(new EventHandler)
+      : mTagTable(new TagTable), mEventHandler(new EventHandler)
    {
       mInit = false;
-      mNextHandle = 0;
       mHandleEvents = false;
+      mKeepComments = false;
+      mKeepPis = false;
+      mWhitespaceMode = xml_ws_trim_leading;
    }
 
    Context::~Context()
    {
+      delete mTagTable;
    }
 
-   std::string Context::getTagname(TagNameHandle handle)
+   const std::string& Context::getTagname(TagNameHandle handle) const
    {
-      TagNameMap_t::const_iterator iter = mTagToName.find(handle);
+      static const std::string empty_name;
+      const std::string* name = mTagTable->getName(handle);
+      return (NULL == name) ? empty_name : *name;
+   }
 
-      if (iter == mTagToName.end())
-      {  return std::string(""); }
-      else
-      {  return iter->second; }
+   TagNameHandle Context::findTagname(const std::string& tagName) const
+   {
+      return mTagTable->find(tagName);
    }
 
    TagNameHandle Context::insertTagname(const std::string& tagName)
    {
-      // Check the list of know tags first, then if not known insert into both lists
-      NameToTagMap_t::const_iterator found_name = mNameToTag.find(tagName);
-
-      // If already have it
-      if(found_name != mNameToTag.end())
-      {
-         return found_name->second;
-      }
-
-      TagNameHandle new_handle = mNextHandle;
-      mNextHandle += 1;
-
-      // Else we need to insert it
-      // insert new tagname
-      TagNameMap_t::value_type tag_to_name_value(new_handle, tagName);
-      mTagToName.insert(tag_to_name_value);
-      NameToTagMap_t::value_type name_to_tag_value(tagName, new_handle);
-      mNameToTag.insert(name_to_tag_value);
+      return mTagTable->insert(tagName);
+   }
 
-      return new_handle;
+   TagNameHandle Context::insertTagname(const char* tagName, std::size_t length)
+   {
+      return mTagTable->insert(tagName, length);
    }
 
    Location& Context::getLocation()
@@ -347,8 +803,91 @@ namespace cppdom
       return mHandleEvents;
    }
 
+   void Context::setElementFilter(ElementFilterPtr filter)
+   {
+      mElementFilter = filter;
+   }
 
-   // Attributes methods
+   const ElementFilterPtr& Context::getElementFilter() const
+   {
+      return mElementFilter;
+   }
+
+   void Context::setWhitespaceMode(WhitespaceMode mode)
+   {
+      mWhitespaceMode = mode;
+   }
+
+   Context::WhitespaceMode Context::getWhitespaceMode() const
+   {
+      return mWhitespaceMode;
+   }
+
+   void Context::setKeepComments(bool keep)
+   {
+      mKeepComments = keep;
+   }
+
+   bool Context::getKeepComments() const
+   {
+      return mKeepComments;
+   }
+
+   void Context::setKeepProcessingInstructions(bool keep)
+   {
+      mKeepPis = keep;
+   }
+
+   bool Context::getKeepProcessingInstructions() const
+   {
+      return mKeepPis;
+   }
+
+   void Context::addBase64Element(const std::string& tagname)
+   {
+      const TagNameHandle handle = insertTagname(tagname);
+      if (!isBase64Element(handle))
+      {
+         mBase64Elements.push_back(handle);
+      }
+   }
+
+   bool Context::isBase64Element(TagNameHandle handle) const
+   {
+      return std::find(mBase64Elements.begin(), mBase64Elements.end(), handle) !=
+             mBase64Elements.end();
+   }
+
+
+   // PathFilter methods
+
+   PathFilter::PathFilter()
+   {}
+
+   void PathFilter::addPath(const std::string& path)
+   {
+      mPaths.push_back(std::vector<std::string>());
+      splitStr(path, "/", std::back_inserter(mPaths.back()));
+   }
+
+   bool PathFilter::keepElement(const std::vector<TagNameHandle>& path, const Context& context)
+   {
+      // Kept: the ancestors of a wanted element, and what is inside one
+      for (std::vector<std::vector<std::string> >::const_iterator p = mPaths.begin();
+           p != mPaths.end(); ++p)
+      {
+         const std::size_t common = std::min(p->size(), path.size());
+         std::size_t i(0);
+         while (i < common && context.getTagname(path[i]) == (*p)[i])
+         {  ++i; }
+         if (i == common)
+         {  return true; }
+      }
+      return false;
+   }
+
+
+   // Attribute methods
 
    Attribute::Attribute()
       : mData("")
@@ -356,12 +895,58 @@ namespace cppdom
 
    Attribute::Attribute(const Attribute& attr)
       : mData(attr.mData)
-   {}
+   {
+      copyCache(attr);
+   }
 
    Attribute::Attribute(const std::string& val)
       : mData(val)
    {}
 
+   Attribute& Attribute::operator=(const Attribute& attr)
+   {
+      if (this != &attr)
+      {
+         mData = attr.mData;
+         mCache.mType.store(0);
+         copyCache(attr);
+      }
+      return *this;
+   }
+
+
+   void Attribute::copyCache(const Attribute& attr)
+   {
+      const long type = attr.mCache.mType.load();
+      if (type > 0)
+      {
+         mCache.mValue = attr.mCache.mValue;
+         mCache.mType.store(type);
+      }
+   }
+
+   bool Attribute::loadCache(int type, void* value, std::size_t size) const
+   {
+      if (mCache.mType.load() != type)
+      {
+         return false;
+      }
+      std::memcpy(value, &mCache.mValue, size);
+      return true;
+   }
+
+   void Attribute::storeCache(int type, const void* value, std::size_t size) const
+   {
+      // first reader to get here fills the cache, everyone else skips it
+      long expected = 0;
+      if (!mCache.mType.compareExchange(expected, -1))
+      {
+         return;
+      }
+      std::memcpy(&mCache.mValue, value, size);
+      mCache.mType.store(type);
+   }
+
    const std::string& Attribute::getString() const
    {
       return mData;
@@ -377,6 +962,17 @@ namespace cppdom
    Attributes::Attributes()
    {}
 
+   Attributes::Attributes(const Attributes& attribs)
+      : std::map<std::string, Attribute>(attribs)
+   {}
+
+   Attributes& Attributes::operator=(const Attributes& attribs)
+   {
+      std::map<std::string, Attribute>::operator=(attribs);
+      return *this;
+   }
+
+
    Attribute Attributes::get(const std::string& key) const
    {
       Attributes::const_iterator iter;
@@ -404,33 +1000,160 @@ namespace cppdom
 
    // Node methods
 
+   struct Node::OrderStamp
+   {
+      /** the numbers of one node */
+      struct Numbers
+      {
+         const Node* mNode;
+         unsigned    mDepth;
+         unsigned    mPreOrder;
+         unsigned    mPostOrder;
+      };
+
+      OrderStamp()
+         : mRefs(0), mValid(true), mMask(0)
+      {}
+
+      void acquire()
+      {  mRefs.fetchAdd(1); }
+
+      void release()
+      {
+         if (mRefs.fetchAdd(-1) == 1)
+         {  delete this; }
+      }
+
+      /** makes the lookup table for the numbers added in preorder */
+      void buildTable()
+      {
+         std::size_t size = 1;
+         while (size < 2 * mNumbers.size())
+         {  size *= 2; }
+         mMask = size - 1;
+         mTable.assign(size, unsigned(-1));
+         for (unsigned n = 0; n < mNumbers.size(); ++n)
+         {
+            std::size_t slot = hashNode(mNumbers[n].mNode) & mMask;
+            while (mTable[slot] != unsigned(-1))
+            {  slot = (slot + 1) & mMask; }
+            mTable[slot] = n;
+         }
+      }
+
+      /** returns the numbers of a node numbered by this stamp */
+      const Numbers& find(const Node* node) const
+      {
+         std::size_t slot = hashNode(node) & mMask;
+         while (mNumbers[mTable[slot]].mNode != node)
+         {  slot = (slot + 1) & mMask; }
+         return mNumbers[mTable[slot]];
+      }
+
+      static std::size_t hashNode(const Node* node)
+      {
+         // Nodes are heap blocks, the low bits of their addresses are zero
+         const std::size_t bits = reinterpret_cast<std::size_t>(node) >> 4;
+         return bits ^ (bits >> 7) ^ (bits >> 17);
+      }
+
+      threads::Atomic<long> mRefs;    /**< nodes numbered by this stamp */
+      bool  mValid;   /**< the tree has not changed since */
+      std::vector<Numbers>  mNumbers; /**< numbers of the nodes, in preorder */
+      std::vector<unsigned> mTable;   /**< open addressing table of positions in mNumbers */
+      std::size_t           mMask;    /**< size of mTable minus one */
+   };
+
+   /** A node of a NodePath, shared by the paths of the nodes below it. */
+   struct NodePathStep
+   {
+      NodePathStep(NodePathStep* parent, TagNameHandle name, unsigned index);
+
+      void acquire()
+      {  mRefs.fetchAdd(1); }
+
+      void release()
+      {
+         // Free the chain iteratively, a long path is released in one go
+         NodePathStep* step = this;
+         while (step != NULL && step->mRefs.fetchAdd(-1) == 1)
+         {
+            NodePathStep* parent = step->mParent;
+            delete step;
+            step = parent;
+         }
+      }
+
+      /** returns the step i nodes from the top */
+      const NodePathStep* at(std::size_t i) const
+      {
+         const NodePathStep* step = this;
+         for (std::size_t n = mLength - 1; n > i; --n)
+         {  step = step->mParent; }
+         return step;
+      }
+
+      threads::Atomic<long> mRefs;  /**< paths, nodes and steps below referring to it */
+      NodePathStep*   mParent;  /**< the step above, NULL at the top */
+      TagNameHandle   mName;
+      unsigned        mIndex;
+      std::size_t     mLength;  /**< number of steps down to this one */
+      Node::HashValue mHash;    /**< hash of the steps down to this one */
+   };
+
    Node::Node()
-      : mNodeType(xml_nt_node), mParent(0)
+      : mNodeNameHandle(-1), mIndex(0), mNodeType(xml_nt_node), mCdataBinary(false)
+      , mHashValid(false), mIndexed(false), mParent(0), mHash(0), mLazySource(NULL)
+      , mLazyIndex(0), mOrder(NULL), mPathStep(NULL)
    {}
 
    Node::Node(ContextPtr ctx)
-      : mContext(ctx), mNodeType(xml_nt_node), mParent(0)
+      : mNodeNameHandle(-1), mIndex(0), mContext(ctx), mNodeType(xml_nt_node), mCdataBinary(false)
+      , mHashValid(false), mIndexed(false), mParent(0), mHash(0), mLazySource(NULL)
+      , mLazyIndex(0), mOrder(NULL), mPathStep(NULL)
    {}
 
    Node::Node(std::string nodeName, ContextPtr ctx)
-      : mContext(ctx), mNodeType(xml_nt_node), mParent(0)
+      : mNodeNameHandle(-1), mIndex(0), mContext(ctx), mNodeType(xml_nt_node), mCdataBinary(false)
+      , mHashValid(false), mIndexed(false), mParent(0), mHash(0), mLazySource(NULL)
+      , mLazyIndex(0), mOrder(NULL), mPathStep(NULL)
    { setName(nodeName); }
 
    Node::Node(const Node& node)
       : mNodeNameHandle(node.mNodeNameHandle)
+      , mIndex(node.mIndex)
 #ifdef CPPDOM_DEBUG
       , mNodeName_debug(node.mNodeName_debug)
 #endif
       , mContext(node.mContext)
       , mNodeType(node.mNodeType)
+      , mCdataBinary(node.mCdataBinary)
+      , mHashValid(node.mHashValid)
+      , mIndexed(false)
       , mAttributes(node.mAttributes)
       , mCdata(node.mCdata)
       , mNodeList(node.mNodeList)
       , mParent(node.mParent)
-   {}
+      , mHash(node.mHash)
+      , mLazySource(node.mLazySource)
+      , mLazyIndex(node.mLazyIndex)
+      , mOrder(NULL)
+      , mPathStep(NULL)
+   {
+      // The copy parses the shared text on its own when it is used
+      if (mLazySource != NULL)
+      {  mLazySource->acquire(); }
+   }
+
 
    Node::~Node()
    {
+      if (mLazySource != NULL)
+      {  mLazySource->release(); }
+      if (mOrder != NULL)
+      {  mOrder->release(); }
+      if (mPathStep != NULL)
+      {  mPathStep->release(); }
       for (NodeList::iterator i = mNodeList.begin(); i != mNodeList.end(); ++i)
       {
          (*i)->mParent = NULL;
@@ -455,6 +1178,7 @@ namespace cppdom
 
    Node& Node::operator=(const Node& node)
    {
+      indexContent(false, true);
       mNodeNameHandle = node.mNodeNameHandle;
 #ifdef CPPDOM_DEBUG
       mNodeName_debug = node.mNodeName_debug;
@@ -463,11 +1187,320 @@ namespace cppdom
       mNodeType = node.mNodeType;
       mAttributes = node.mAttributes;
       mCdata = node.mCdata;
+      mCdataBinary = node.mCdataBinary;
       mNodeList = node.mNodeList;
       mParent = node.mParent;
+      if (node.mLazySource != NULL)
+      {  node.mLazySource->acquire(); }
+      if (mLazySource != NULL)
+      {  mLazySource->release(); }
+      mLazySource = node.mLazySource;
+      mLazyIndex = node.mLazyIndex;
+      invalidateOrder();
+
+      // The content is node's, so is its hash; our ancestors changed
+      invalidateHash();
+      mHash = node.mHash;
+      mHashValid = node.mHashValid;
+
+      mIndexed = (mParent != NULL && mParent->mIndexed);
+      indexContent(true, true);
       return *this;
    }
 
+   void Node::takeContent(Node& node)
+   {
+      indexContent(false, true);
+      node.indexContent(false, true);
+      for (NodeList::iterator i = mNodeList.begin(); i != mNodeList.end(); ++i)
+      {
+         (*i)->mParent = NULL;
+      }
+      mNodeNameHandle = node.mNodeNameHandle;
+#ifdef CPPDOM_DEBUG
+      mNodeName_debug.swap(node.mNodeName_debug);
+#endif
+      mContext = node.mContext;
+      mNodeType = node.mNodeType;
+      mAttributes.swap(node.mAttributes);
+      mCdata.swap(node.mCdata);
+      mCdataBinary = node.mCdataBinary;
+      mNodeList.swap(node.mNodeList);
+      for (NodeList::iterator i = mNodeList.begin(); i != mNodeList.end(); ++i)
+      {
+         (*i)->mParent = this;
+      }
+      if (mLazySource != NULL)
+      {  mLazySource->release(); }
+      mLazySource = node.mLazySource;
+      mLazyIndex = node.mLazyIndex;
+      node.mLazySource = NULL;
+      invalidateOrder();
+      node.invalidateOrder();
+
+      invalidateHash();
+      mHash = node.mHash;
+      mHashValid = node.mHashValid;
+
+      // node now holds our old content, which goes
+      node.mNodeList.clear();
+      node.mAttributes.clear();
+      node.mCdata.clear();
+      node.mCdataBinary = false;
+      node.invalidateHash();
+
+      indexContent(true, true);
+   }
+
+   NodePtr Node::clone(bool deep, ContextPtr context) const
+   {
+      expand();
+      if (context.get() == NULL)
+      {  context = mContext; }
+
+      NodePtr copy(new Node(context));
+      if (context.get() == mContext.get() || mNodeNameHandle == -1)
+      {  copy->mNodeNameHandle = mNodeNameHandle; }
+      else
+      {  copy->mNodeNameHandle = context->insertTagname(mContext->getTagname(mNodeNameHandle)); }
+#ifdef CPPDOM_DEBUG
+      copy->mNodeName_debug = mNodeName_debug;
+#endif
+      copy->mNodeType = mNodeType;
+      copy->mAttributes = mAttributes;
+      copy->mCdata = mCdata;
+      copy->mCdataBinary = mCdataBinary;
+
+      if (deep)
+      {
+         copy->mNodeList.reserve(mNodeList.size());
+         for (NodeList::const_iterator i = mNodeList.begin(); i != mNodeList.end(); ++i)
+         {
+            copy->mNodeList.push_back((*i)->clone(true, context));
+            copy->mNodeList.back()->mParent = copy.get();
+            copy->mNodeList.back()->mIndex = unsigned(copy->mNodeList.size() - 1);
+         }
+         // The hash does not depend on the context
+         copy->mHash = mHash;
+         copy->mHashValid = mHashValid;
+      }
+      return copy;
+   }
+
+   void Node::expandLazy() const
+   {
+      // The node stops being lazy first, so the accessors that fill it do
+      // not try to parse it again
+      LazySource* source = mLazySource;
+      mLazySource = NULL;
+      Node& self = const_cast<Node&>(*this);
+      try
+      {
+         source->expand(self, mLazyIndex);
+      }
+      catch (...)
+      {
+         // Stay unparsed, so the next access reports the error again
+         for (NodeList::iterator i = self.mNodeList.begin(); i != self.mNodeList.end(); ++i)
+         {  (*i)->mParent = NULL; }
+         self.mNodeList.clear();
+         self.mAttributes.clear();
+         self.invalidateHash();
+         mLazySource = source;
+         throw;
+      }
+      source->release();
+   }
+
+   void Node::dropLazy()
+   {
+      if (mLazySource != NULL)
+      {
+         mLazySource->release();
+         mLazySource = NULL;
+      }
+   }
+
+   /** Structural hash helpers */
+   namespace
+   {
+#ifdef CPPDOM_HAS_LONG_LONG
+      const Node::HashValue hashBasis = 14695981039346656037ULL;
+      const Node::HashValue hashPrime = 1099511628211ULL;
+      const Node::HashValue hashGolden = 0x9e3779b97f4a7c15ULL;
+#else
+      const Node::HashValue hashBasis = 2166136261UL;
+      const Node::HashValue hashPrime = 16777619UL;
+      const Node::HashValue hashGolden = 0x9e3779b9UL;
+#endif
+
+      /** FNV-1a, continued over [first, last) */
+      Node::HashValue hashChars(Node::HashValue h, const char* first, const char* last)
+      {
+         for (; first != last; ++first)
+         {
+            h ^= (unsigned char)(*first);
+            h *= hashPrime;
+         }
+         return h;
+      }
+
+      Node::HashValue hashString(const std::string& str)
+      {
+         return hashChars(hashBasis, str.data(), str.data() + str.size());
+      }
+
+      /** hashString() of the base64 text of bytes, which is made a block at a time */
+      Node::HashValue hashBase64(const std::string& bytes)
+      {
+         const std::size_t block = 3 * 256;
+         char text[block / 3 * 4];
+         const unsigned char* data = reinterpret_cast<const unsigned char*>(bytes.data());
+         Node::HashValue h = hashBasis;
+         for (std::size_t done = 0; done < bytes.size(); done += block)
+         {
+            const std::size_t count = std::min(block, bytes.size() - done);
+            h = hashChars(h, text, base64::encode(data + done, count, text));
+         }
+         return h;
+      }
+
+      /** appends the text of cdata, the base64 of it if it holds bytes */
+      void appendCdataText(std::string& text, const std::string& cdata, bool binary)
+      {
+         if (binary)
+         {
+            base64::encode(reinterpret_cast<const unsigned char*>(cdata.data()), cdata.size(), text);
+         }
+         else
+         {
+            text += cdata;
+         }
+      }
+
+      /** order dependent combination of hashes */
+      inline void hashCombine(Node::HashValue& seed, Node::HashValue value)
+      {
+         seed ^= value + hashGolden + (seed << 6) + (seed >> 2);
+      }
+
+      /** cdata, comment and pi nodes keep their text in mCdata */
+      inline bool hasOwnText(Node::Type type)
+      {
+         return type == Node::xml_nt_cdata || type == Node::xml_nt_comment ||
+                type == Node::xml_nt_pi;
+      }
+
+      const std::string& nameOf(const ContextPtr& context, TagNameHandle handle)
+      {
+         static const std::string empty_name;
+         return (context.get() == NULL) ? empty_name : context->getTagname(handle);
+      }
+
+      /** the handles a context has for some names, sorted */
+      std::vector<TagNameHandle> resolveNames(const ContextPtr& context,
+                                              const std::vector<std::string>& names)
+      {
+         std::vector<TagNameHandle> handles;
+         if (context.get() != NULL)
+         {
+            for (std::vector<std::string>::const_iterator n = names.begin(); n != names.end(); ++n)
+            {
+               const TagNameHandle handle = context->findTagname(*n);
+               if (handle >= 0)
+               {  handles.push_back(handle); }
+            }
+         }
+         std::sort(handles.begin(), handles.end());
+         return handles;
+      }
+   }
+
+   Node::HashValue Node::getHash() const
+   {
+      if (mHashValid)
+      {
+         return mHash;
+      }
+
+      expand();
+      HashValue h = hashString(nameOf(mContext, mNodeNameHandle));
+
+      // Attributes are a sorted map, so equal attribute sets hash alike
+      hashCombine(h, HashValue(mAttributes.size()));
+      for (Attributes::const_iterator a = mAttributes.begin(); a != mAttributes.end(); ++a)
+      {
+         hashCombine(h, hashString(a->first));
+         hashCombine(h, hashString(a->second.getString()));
+      }
+
+      // isEqual() compares the text of cdata, comment and pi nodes, and sees
+      // an empty one like an element without children
+      if (hasOwnText(mNodeType) && !mCdata.empty())
+      {
+         hashCombine(h, mCdataBinary ? hashBase64(mCdata) : hashString(mCdata));
+      }
+
+      hashCombine(h, HashValue(mNodeList.size()));
+      for (NodeList::const_iterator c = mNodeList.begin(); c != mNodeList.end(); ++c)
+      {
+         hashCombine(h, (*c)->getHash());
+      }
+
+      mHash = h;
+      mHashValid = true;
+      return mHash;
+   }
+
+   bool Node::hasHash() const
+   {
+      return mHashValid;
+   }
+
+   void Node::invalidateHash()
+   {
+      // A node without a hash has no ancestor with one, so stop there.
+      // Not writing then keeps readers of unhashed documents from racing.
+      if (!mHashValid)
+      {  return; }
+
+      mHashValid = false;
+      for (Node* n = mParent; n != NULL && n->mHashValid; n = n->mParent)
+      {
+         n->mHashValid = false;
+      }
+   }
+
+   struct Node::EqualIgnores
+   {
+      EqualIgnores(const std::vector<std::string>& attribs,
+                   const std::vector<std::string>& elements,
+                   const ContextPtr& myContext, const ContextPtr& otherContext)
+         : mAttribs(attribs)
+         , mMyElements(resolveNames(myContext, elements))
+         , mOtherElements((myContext == otherContext) ? mMyElements
+                                                      : resolveNames(otherContext, elements))
+         , mNothing(attribs.empty() && elements.empty())
+      {
+         std::sort(mAttribs.begin(), mAttribs.end());
+      }
+
+      bool isIgnoredAttrib(const std::string& name) const
+      {  return std::binary_search(mAttribs.begin(), mAttribs.end(), name); }
+
+      /** true if both elements are of an ignored type */
+      bool isIgnoredElement(TagNameHandle mine, TagNameHandle other) const
+      {
+         return std::binary_search(mMyElements.begin(), mMyElements.end(), mine) &&
+                std::binary_search(mOtherElements.begin(), mOtherElements.end(), other);
+      }
+
+      std::vector<std::string>   mAttribs;
+      std::vector<TagNameHandle> mMyElements;     /**< ignored names in our context */
+      std::vector<TagNameHandle> mOtherElements;  /**< the same in the other's context */
+      bool                       mNothing;        /**< nothing is ignored */
+   };
+
    /** Returns true if the nodes are equal
    * @param ignoreAttribs - Attributes to ignore in the comparison
    * @param ignoreElements - Elements to ignore in the comparison
@@ -475,27 +1508,48 @@ namespace cppdom
    bool Node::isEqual(NodePtr otherNode, const std::vector<std::string>& ignoreAttribs,
                       const std::vector<std::string>& ignoreElements,
                       bool dbgit, const unsigned debugIndent)
+   {
+      const EqualIgnores ignores(ignoreAttribs, ignoreElements,
+                                 mContext, otherNode->mContext);
+      return isEqual(*otherNode, ignores, dbgit, debugIndent);
+   }
+
+   bool Node::isEqual(const Node& otherNode, const EqualIgnores& ignores,
+                      bool dbgit, unsigned debugIndent) const
    {
       std::string indent(debugIndent, char(' '));     // Construct buffer of size debugIndent
-      const std::string my_name(getName());           // Get element names
-      const std::string other_name(otherNode->getName());
+      const std::string& my_name(nameOf(mContext, mNodeNameHandle));   // Get element names
+      const std::string& other_name(nameOf(otherNode.mContext, otherNode.mNodeNameHandle));
 
       if(dbgit) std::cout << indent << "isEqual: me:" << my_name << "  other:" << other_name << std::endl;
 
+      // Different hashes rule out equal subtrees, equal ones may collide
+      if(mHashValid && otherNode.mHashValid && ignores.mNothing &&
+         mHash != otherNode.mHash)
+      {
+         if(dbgit) std::cout << indent << "Different structural hash: not equal.\n";
+         return false;
+      }
+
       // If we are supposed to ignore this element type, then return immediately
-      if( (std::find(ignoreElements.begin(), ignoreElements.end(), my_name) != ignoreElements.end()) &&
-          (std::find(ignoreElements.begin(), ignoreElements.end(), other_name) != ignoreElements.end()))
+      if(ignores.isIgnoredElement(mNodeNameHandle, otherNode.mNodeNameHandle))
       { return true; }
 
       // Check current node's element type (ie. name)
-      if(other_name != my_name)
+      const bool same_name = (mContext == otherNode.mContext) ?
+                             (mNodeNameHandle == otherNode.mNodeNameHandle) :
+                             (my_name == other_name);
+      if(!same_name)
       {
          if(dbgit) std::cout << indent << "Different elt types: not equal.\n";
          return false;
       }
 
+      expand();
+      otherNode.expand();
+
       // Check attributes
-      Attributes& other_attribs = otherNode->attrib();
+      const Attributes& other_attribs = otherNode.mAttributes;
 
       if(other_attribs.size() !=  mAttributes.size())
       {
@@ -504,20 +1558,19 @@ namespace cppdom
       }
 
       // Check attribute values
-      for(Attributes::iterator cur_attrib = other_attribs.begin();
+      for(Attributes::const_iterator cur_attrib = other_attribs.begin();
           cur_attrib != other_attribs.end(); cur_attrib++)
       {
-         std::string attrib_name = (*cur_attrib).first;
-         Attribute attrib_value = (*cur_attrib).second;
+         const std::string& attrib_name = (*cur_attrib).first;
          if(dbgit) std::cout << indent << "Comparing attribute: " << attrib_name << std::endl;
 
          // If not in ignore list
-         if(std::find(ignoreAttribs.begin(), ignoreAttribs.end(), attrib_name)
-                        == ignoreAttribs.end())
+         if(!ignores.isIgnoredAttrib(attrib_name))
          {
             // if (not have attribute) OR attrib != needed
-            if( !mAttributes.has(attrib_name) ||
-                (mAttributes.get(attrib_name) != attrib_value))
+            Attributes::const_iterator mine = mAttributes.find(attrib_name);
+            if( mine == mAttributes.end() ||
+                (mine->second.getString() != (*cur_attrib).second.getString()))
             {
                if(dbgit) std::cout << indent << "Attributes [" << attrib_name << "] are different: not equal.\n";
                return false;
@@ -531,19 +1584,15 @@ namespace cppdom
 
       if(dbgit) std::cout << indent << "Checking cdata.\n";
       // Check cdata
-      if(otherNode->getFullCdata() != getFullCdata())
+      std::string my_scratch, other_scratch;
+      if(otherNode.getFullCdataRef(other_scratch, '\0') != getFullCdataRef(my_scratch, '\0'))
       {
          if(dbgit) std::cout << indent << "Cdata different: not equal\n";
          return false;
       }
 
       // -- Check children -- //
-      NodeList other_children = otherNode->getChildren();
-      /*
-      unsigned num_children = mNodeList.size();
-      unsigned num_other_children = other_children.size();
-      std::cout << "children: me:" << num_children << "  other:" << num_other_children << std::endl;
-      */
+      const NodeList& other_children = otherNode.mNodeList;
       if(mNodeList.size() != other_children.size())
       {
          if(dbgit) std::cout << indent << "Different number of children: not equal\n";
@@ -552,12 +1601,12 @@ namespace cppdom
 
       if(dbgit) std::cout << indent << "Comparing children:\n";
       // Recurse into each element
-      NodeList::iterator my_child, other_child;
+      NodeList::const_iterator my_child, other_child;
       for(my_child = mNodeList.begin(), other_child = other_children.begin();
-          my_child != mNodeList.end(), other_child != other_children.end();
+          my_child != mNodeList.end();
           my_child++, other_child++)
       {
-         if(false == (*my_child)->isEqual((*other_child), ignoreAttribs, ignoreElements, dbgit, debugIndent+3))
+         if(false == (*my_child)->isEqual(**other_child, ignores, dbgit, debugIndent+3))
          {
             if(dbgit) std::cout << indent << "Childrent different: not equal\n";
             return false;
@@ -578,35 +1627,48 @@ namespace cppdom
       return mContext->getTagname(mNodeNameHandle);
    }
 
+   TagNameHandle Node::getNameHandle() const
+   {
+      return mNodeNameHandle;
+   }
+
    Attributes& Node::getAttrMap()
    {
+      expand();
+      invalidateHash();
       return mAttributes;
    }
 
    const Attributes& Node::getAttrMap() const
    {
+      expand();
       return mAttributes;
    }
 
    Attributes& Node::attrib()
    {
+      expand();
+      invalidateHash();
       return mAttributes;
    }
 
    /** Direct access to attribute map. */
    const Attributes& Node::attrib() const
    {
+      expand();
       return mAttributes;
    }
 
 
    Attribute Node::getAttribute(const std::string& name) const
    {
+      expand();
       return mAttributes.get(name);
    }
 
    bool Node::hasAttribute(const std::string& name) const
    {
+      expand();
       return mAttributes.has(name);
    }
 
@@ -616,18 +1678,23 @@ namespace cppdom
    */
    std::string Node::getCdata()
    {
+      expand();
       std::string ret_val;
 
-      if(getType() == xml_nt_cdata)
+      if(hasOwnText(getType()))
       {
-         ret_val = mCdata;
+         appendCdataText(ret_val, mCdata, mCdataBinary);
       }
       else
       {
-         cppdom::NodeList nl = getChildrenPred( cppdom::IsNodeTypePredicate( Node::xml_nt_cdata ));
-         if(!nl.empty())
+         // Walk the children in place, copying no node pointers
+         for(NodeList::const_iterator n=mNodeList.begin(); n!=mNodeList.end(); ++n)
          {
-            ret_val = (*(nl.begin()))->getCdata();
+            if((*n)->getType() == Node::xml_nt_cdata)
+            {
+               appendCdataText(ret_val, (*n)->mCdata, (*n)->mCdataBinary);
+               break;
+            }
          }
       }
       return ret_val;
@@ -637,59 +1704,161 @@ namespace cppdom
    */
    std::string Node::getFullCdata()
    {
-      std::string ret_val;
+      std::string scratch;
+      return getFullCdataRef(scratch, '\0');
+   }
+
 
-      if(getType() == Node::xml_nt_cdata)
+   const std::string& Node::getFullCdataRef(std::string& scratch, char separator) const
+   {
+      expand();
+      if(hasOwnText(getType()))
       {
-         ret_val = mCdata;
+         if(!mCdataBinary)
+         {  return mCdata; }
+         scratch.clear();
+         appendCdataText(scratch, mCdata, true);
+         return scratch;
       }
-      else
+
+      // Bytes have no text to point at, it is made in scratch
+      const std::string* single = &scratch;
+      unsigned count(0);
+      for(NodeList::const_iterator n=mNodeList.begin(); n!=mNodeList.end(); ++n)
       {
-         cppdom::NodeList nl = getChildrenPred( cppdom::IsNodeTypePredicate( Node::xml_nt_cdata ));
-         for(cppdom::NodeList::iterator n=nl.begin(); n!=nl.end(); ++n)
+         if((*n)->getType() == Node::xml_nt_cdata)
          {
-            ret_val += (*n)->getCdata();
+            if(++count == 1)
+            {
+               single = &(*n)->mCdata;
+               if((*n)->mCdataBinary)
+               {
+                  scratch.clear();
+                  appendCdataText(scratch, (*n)->mCdata, true);
+                  single = &scratch;
+               }
+            }
+            else
+            {
+               if(count == 2 && single != &scratch)
+               {  scratch = *single; }
+               if(separator != '\0')
+               {  scratch += separator; }
+               appendCdataText(scratch, (*n)->mCdata, (*n)->mCdataBinary);
+            }
          }
       }
-      return ret_val;
+      return (count > 1) ? scratch : *single;
    }
 
-
    void Node::setType(Node::Type type)
    {
       mNodeType = type;
+      invalidateHash();
    }
 
    void Node::setName(const std::string& name)
    {
+      invalidateHash();
       mNodeNameHandle = mContext->insertTagname(name);
 #ifdef CPPDOM_DEBUG
       mNodeName_debug = name;
 #endif
    }
 
+   void Node::setNameHandle(TagNameHandle handle)
+   {
+      invalidateHash();
+      mNodeNameHandle = handle;
+#ifdef CPPDOM_DEBUG
+      mNodeName_debug = mContext->getTagname(handle);
+#endif
+   }
+
    /** Set the element cdata.
    * If not cdata type, then try to find first cdata.
    * If we don't have a cdata child, then add one and set it
    */
    void Node::setCdata(const std::string& cdata)
    {
-      if(getType() == Node::xml_nt_cdata)
+      if(hasOwnText(getType()))
+      {
+         mCdata = cdata;
+         mCdataBinary = false;
+         invalidateHash();
+      }
+      else
+      {
+         cppdom::NodeList nl = getChildrenPred( cppdom::IsNodeTypePredicate( Node::xml_nt_cdata ));
+         if(!nl.empty())
+         {
+            (*(nl.begin()))->setCdata(cdata);
+         }
+         else  // Create a child
+         {
+            cppdom::NodePtr new_cdata(new cppdom::Node("cdata", getContext()));
+            new_cdata->setType(Node::xml_nt_cdata);
+            new_cdata->setCdata(cdata);
+            addChild(new_cdata);
+         }
+      }
+   }
+
+   bool Node::getCdataBinary(std::vector<unsigned char>& data) const
+   {
+      expand();
+      data.clear();
+      std::vector<const Node*> parts;
+      if(hasOwnText(getType()))
+      {  parts.push_back(this); }
+      else
+      {
+         for(NodeList::const_iterator n=mNodeList.begin(); n!=mNodeList.end(); ++n)
+         {
+            if((*n)->getType() == Node::xml_nt_cdata)
+            {  parts.push_back(n->get()); }
+         }
+      }
+
+      // Text split over several cdata children decodes as one
+      base64::Decoder decoder;
+      for(std::vector<const Node*>::const_iterator p=parts.begin(); p!=parts.end(); ++p)
+      {
+         const std::string& cdata = (*p)->mCdata;
+         if((*p)->mCdataBinary)
+         {
+            if(!decoder.finished())
+            {  return false; }
+            data.insert(data.end(), cdata.begin(), cdata.end());
+         }
+         else if(!decoder.decode(cdata.data(), cdata.data() + cdata.size(), data))
+         {
+            return false;
+         }
+      }
+      return decoder.finished();
+   }
+
+   void Node::setCdataBinary(const void* data, std::size_t size)
+   {
+      if(hasOwnText(getType()))
       {
-         mCdata = cdata;
+         mCdata.assign(static_cast<const char*>(data), size);
+         mCdataBinary = true;
+         invalidateHash();
       }
       else
       {
          cppdom::NodeList nl = getChildrenPred( cppdom::IsNodeTypePredicate( Node::xml_nt_cdata ));
          if(!nl.empty())
          {
-            (*(nl.begin()))->setCdata(cdata);
+            (*(nl.begin()))->setCdataBinary(data, size);
          }
          else  // Create a child
          {
             cppdom::NodePtr new_cdata(new cppdom::Node("cdata", getContext()));
             new_cdata->setType(Node::xml_nt_cdata);
-            new_cdata->setCdata(cdata);
+            new_cdata->setCdataBinary(data, size);
             addChild(new_cdata);
          }
       }
@@ -697,17 +1866,25 @@ namespace cppdom
 
    void Node::setAttribute(const std::string& attr, const Attribute& value)
    {
+      expand();
       // Check for valid input
       if(std::string::npos != attr.find(" "))  // If found space
       {
          throw CPPDOM_ERROR(xml_invalid_argument, "Attempted to use attribute name with a space");
       }
 
+      Document* doc = getIndexedDocument();
+      if (doc != NULL)
+      {  doc->indexNode(*this, false); }
       mAttributes.set(attr, value.getString());
+      if (doc != NULL)
+      {  doc->indexNode(*this, true); }
+      invalidateHash();
    }
 
    void Node::addChild(NodePtr& node)
    {
+      expand();
       // Check for invalid call
       if(node.get() == NULL)
       {
@@ -720,32 +1897,93 @@ namespace cppdom
       }
 
       node->mParent = this;      // Tell the child who their daddy is
+      node->mIndex = unsigned(mNodeList.size());
       mNodeList.push_back(node);
+      invalidateHash();
+      invalidateOrder();
+      node->invalidateOrder();   // its numbers may be those of another tree
+      indexSubtree(*node, true);
    }
 
-   bool Node::removeChild(NodePtr& node)
+   bool Node::removeChild(const NodePtr& node)
    {
-      cppdom::ignore_unused_variable_warning(node);
-      std::cout << "cppdom::Node::removeChild:  not implemented\n";
-      return false;
+      expand();
+      NodeList::iterator iter = std::find(mNodeList.begin(), mNodeList.end(), node);
+      if(iter == mNodeList.end())
+      {  return false; }
+
+      (*iter)->mParent = NULL;
+      return eraseChildren(iter, iter + 1);
    }
 
-   bool Node::removeChild(std::string& childName)
+   bool Node::removeChild(const std::string& childName)
    {
-      cppdom::ignore_unused_variable_warning(childName);
-      std::cout << "cppdom::Node::removeChild:  not implemented\n";
-      return false;
+      expand();
+      NodeList::const_iterator found = findChild(childName, mNodeList.begin());
+      if(found == mNodeList.end())
+      {  return false; }
+
+      NodeList::iterator iter = mNodeList.begin() + (found - mNodeList.begin());
+      (*iter)->mParent = NULL;
+      return eraseChildren(iter, iter + 1);
    }
 
-   bool Node::removeChildren(std::string& childName)
+   namespace
    {
-      cppdom::ignore_unused_variable_warning(childName);
-      std::cout << "cppdom::Node::removeChildren:  not implemented\n";
-      return false;
+      /** matches children by name the way Node::findChild does */
+      class HasNamePredicate
+      {
+      public:
+         HasNamePredicate(const std::string& name, ContextPtr context)
+            : mName(name), mContext(context), mHandle(context->findTagname(name))
+         {}
+
+         bool operator()(const NodePtr& node) const
+         {
+            if (node->getContext().get() == mContext.get())
+            {  return mHandle != -1 && node->getNameHandle() == mHandle; }
+            return node->getName() == mName;
+         }
+
+      private:
+         const std::string& mName;
+         ContextPtr mContext;
+         TagNameHandle mHandle;
+      };
+   }
+
+   bool Node::removeChildren(const std::string& childName)
+   {
+      return removeChildrenIf(HasNamePredicate(childName, mContext));
+   }
+
+   bool Node::eraseChildren(NodeList::iterator first, NodeList::iterator last)
+   {
+      if(first == last)
+      {  return false; }
+
+      Document* doc = getIndexedDocument();
+      if (doc != NULL)
+      {
+         for (NodeList::iterator i = first; i != last; ++i)
+         {  doc->indexTree(**i, false); }
+      }
+      mNodeList.erase(first, last);
+      invalidateHash();
+      invalidateOrder();
+      return true;
    }
 
    NodeList& Node::getChildren()
    {
+      expand();
+      invalidateHash();
+      return mNodeList;
+   }
+
+   const NodeList& Node::getChildren() const
+   {
+      expand();
       return mNodeList;
    }
 
@@ -759,21 +1997,30 @@ namespace cppdom
    // Get children of the given name
    NodePtr Node::getChild(const std::string& name)
    {
-      // possible speedup: first search if a handle to the childname is existing
-      NodeList::const_iterator iter;
+      expand();
+      NodeList::const_iterator iter = findChild(name, mNodeList.begin());
+      return (iter == mNodeList.end()) ? NodePtr() : *iter;
+   }
 
-      // search for first occurance of node
-      for(iter = mNodeList.begin(); iter != mNodeList.end(); ++iter)
+   NodeList::const_iterator Node::findChild(const std::string& name,
+                                            NodeList::const_iterator start) const
+   {
+      // Compare handles, not strings: a name the context has never seen
+      // cannot be the name of any child
+      const TagNameHandle handle = mContext->findTagname(name);
+      NodeList::const_iterator iter;
+      for(iter = start; iter != mNodeList.end(); ++iter)
       {
-         NodePtr np = (*iter);
-         if (np->getName() == name)
+         const Node* child = iter->get();
+         if (child->mContext.get() == mContext.get())
          {
-            return np;
+            if (child->mNodeNameHandle == handle && handle != -1)
+            {  break; }
          }
+         else if (child->mContext->getTagname(child->mNodeNameHandle) == name)
+         {  break; }
       }
-
-      // no valid child found
-      return NodePtr();
+      return iter;
    }
 
    NodePtr Node::getChildPath(const std::string& path)
@@ -784,34 +2031,35 @@ namespace cppdom
       else
       { splitStr(path, "/", std::back_inserter(node_path)); }
 
+      if(node_path.empty())
+      {  return NodePtr(); }
+
       Node*    next_node(this);               // The node we are looking at
-      NodePtr  last_found;                    // The last child we found
+      NodeList::const_iterator last_found;    // The last child we found
 
       for(unsigned i=0;i<node_path.size();++i)
       {
-         last_found = next_node->getChild(node_path[i]);
-         next_node = last_found.get();
-         if(next_node == NULL)              // If didn't find, then return NULL node
+         next_node->expand();
+         last_found = next_node->findChild(node_path[i], next_node->mNodeList.begin());
+         if(last_found == next_node->mNodeList.end())   // If didn't find, then return NULL node
          {  return NodePtr(); }
+         next_node = last_found->get();
       }
 
       // Return the last node found in the list
-      return last_found;
+      return *last_found;
    }
 
    NodeList Node::getChildren(const std::string& name)
    {
+      expand();
       NodeList result(0);
-      NodeList::const_iterator iter;
 
       // search for all occurances of nodename and insert them into the new list
-      for(iter = mNodeList.begin(); iter != mNodeList.end(); ++iter)
+      for(NodeList::const_iterator iter = findChild(name, mNodeList.begin());
+          iter != mNodeList.end(); iter = findChild(name, iter + 1))
       {
-         const std::string node_name = (*iter)->getName();
-         if (node_name == name)
-         {
-            result.push_back(*iter);
-         }
+         result.push_back(*iter);
       }
 
       return result;
@@ -827,28 +2075,410 @@ namespace cppdom
       return mParent;
    }
 
+   bool Node::checkIndex() const
+   {
+      if (mParent == NULL)
+      {  return false; }
+
+      const NodeList& siblings = mParent->mNodeList;
+      if (mIndex < siblings.size() && siblings[mIndex].get() == this)
+      {  return true; }
+
+      // The list was changed as a whole, count it again
+      for (unsigned i = 0; i < siblings.size(); ++i)
+      {  siblings[i]->mIndex = i; }
+      return mIndex < siblings.size() && siblings[mIndex].get() == this;
+   }
+
+   unsigned Node::getIndex() const
+   {
+      return checkIndex() ? mIndex : 0;
+   }
+
+   NodePtr Node::getNextSibling() const
+   {
+      if (!checkIndex() || mIndex + 1 == mParent->mNodeList.size())
+      {  return NodePtr(); }
+      return mParent->mNodeList[mIndex + 1];
+   }
+
+   NodePtr Node::getPrevSibling() const
+   {
+      if (!checkIndex() || mIndex == 0)
+      {  return NodePtr(); }
+      return mParent->mNodeList[mIndex - 1];
+   }
+
+   unsigned Node::getDepth() const
+   {
+      if (mOrder != NULL && mOrder->mValid)
+      {  return mOrder->find(this).mDepth; }
+
+      unsigned depth(0);
+      for (const Node* n = mParent; n != NULL; n = n->mParent)
+      {  ++depth; }
+      return depth;
+   }
+
+   unsigned Node::getPreOrder() const
+   {
+      checkOrder();
+      return mOrder->find(this).mPreOrder;
+   }
+
+   unsigned Node::getPostOrder() const
+   {
+      checkOrder();
+      return mOrder->find(this).mPostOrder;
+   }
+
+   bool Node::isAncestorOf(const Node& node) const
+   {
+      // Nodes of the tree all have its current stamp, others do not
+      checkOrder();
+      if (node.mOrder != mOrder)
+      {  return false; }
+      const OrderStamp::Numbers& ours = mOrder->find(this);
+      const OrderStamp::Numbers& theirs = mOrder->find(&node);
+      return ours.mPreOrder < theirs.mPreOrder && theirs.mPostOrder < ours.mPostOrder;
+   }
+
+   void Node::checkOrder() const
+   {
+      if (mOrder == NULL || !mOrder->mValid)
+      {  numberTree(); }
+   }
+
+   void Node::numberTree() const
+   {
+      const Node* top = this;
+      while (top->mParent != NULL)
+      {  top = top->mParent; }
+
+      OrderStamp* stamp = new OrderStamp;
+      stamp->acquire();
+      std::vector<OrderStamp::Numbers>& numbers = stamp->mNumbers;
+      unsigned post(0);
+
+      // Preorder numbers of the nodes on the way down, with the position
+      // of their next child
+      std::vector<std::pair<unsigned, std::size_t> > path;
+      const Node* node = top;
+      while (node != NULL)
+      {
+         // A lazy node that is not parsed yet has no children to number;
+         // parsing it adds them, which drops these numbers again
+         stamp->acquire();
+         if (node->mOrder != NULL)
+         {  node->mOrder->release(); }
+         node->mOrder = stamp;
+         OrderStamp::Numbers entry;
+         entry.mNode = node;
+         entry.mDepth = unsigned(path.size());
+         entry.mPreOrder = unsigned(numbers.size());
+         entry.mPostOrder = 0;
+         numbers.push_back(entry);
+         path.push_back(std::make_pair(entry.mPreOrder, std::size_t(0)));
+
+         // Go down to the next child, or up until there is one
+         node = NULL;
+         while (node == NULL && !path.empty())
+         {
+            OrderStamp::Numbers& parent = numbers[path.back().first];
+            const std::size_t next = path.back().second;
+            if (next < parent.mNode->mNodeList.size())
+            {
+               node = parent.mNode->mNodeList[next].get();
+               node->mIndex = unsigned(next);
+               ++path.back().second;
+            }
+            else
+            {
+               parent.mPostOrder = post++;
+               path.pop_back();
+            }
+         }
+      }
+      stamp->buildTable();
+      stamp->release();
+   }
+
+   void Node::invalidateOrder()
+   {
+      if (mOrder != NULL)
+      {  mOrder->mValid = false; }
+   }
+
+   Document* Node::getIndexedDocument()
+   {
+      // Nodes are marked when they join an indexed tree, so trees without
+      // indexes are never walked
+      if (!mIndexed)
+      {  return NULL; }
+
+      Node* top = this;
+      while (top->mParent != NULL)
+      {  top = top->mParent; }
+
+      // A marked subtree taken out behind our back has another top
+      if (!top->mIndexed || top->mNodeType != xml_nt_document)
+      {  return NULL; }
+      return static_cast<Document*>(top);
+   }
+
+   void Node::indexSubtree(Node& node, bool add)
+   {
+      Document* doc = getIndexedDocument();
+      if (doc != NULL)
+      {  doc->indexTree(node, add); }
+   }
+
+   void Node::indexContent(bool add, bool descendants)
+   {
+      Document* doc = getIndexedDocument();
+      if (doc == NULL)
+      {  return; }
+
+      doc->indexNode(*this, add);
+      if (descendants)
+      {
+         for (NodeList::iterator i = mNodeList.begin(); i != mNodeList.end(); ++i)
+         {  doc->indexTree(**i, add); }
+      }
+   }
+
    std::string Node::getPath()
    {
-      std::string path(getName());
-      Node* parent = getParent();
-      while (parent != NULL)
+      // Size the path first, then fill it in from the end
+      std::size_t length(0);
+      for (const Node* n = this; n != NULL; n = n->mParent)
+      {  length += nameOf(n->mContext, n->mNodeNameHandle).size() + 1; }
+
+      std::string path(length - 1, '/');
+      for (const Node* n = this; n != NULL; n = n->mParent)
+      {
+         const std::string& name = nameOf(n->mContext, n->mNodeNameHandle);
+         length -= name.size() + 1;
+         path.replace(length, name.size(), name);
+      }
+      return path;
+   }
+
+   NodePathStep::NodePathStep(NodePathStep* parent, TagNameHandle name, unsigned index)
+      : mRefs(0), mParent(parent), mName(name), mIndex(index), mLength(1), mHash(0)
+   {
+      if (mParent != NULL)
+      {
+         mParent->acquire();
+         mLength = mParent->mLength + 1;
+         mHash = mParent->mHash;
+      }
+      hashCombine(mHash, Node::HashValue(name));
+      hashCombine(mHash, Node::HashValue(index));
+   }
+
+   NodePath Node::getNodePath() const
+   {
+      // This node and its ancestors, nearest first
+      std::vector<const Node*> chain;
+      for (const Node* n = this; n != NULL; n = n->mParent)
+      {  chain.push_back(n); }
+
+      // Keep the steps that still match, from the top down; a step made
+      // again makes those of the nodes below it stale in turn
+      NodePathStep* above = NULL;
+      for (std::size_t i = chain.size(); i > 0; --i)
+      {
+         const Node* n = chain[i - 1];
+         const unsigned index = n->getIndex();
+         NodePathStep* step = n->mPathStep;
+         if (step == NULL || step->mParent != above ||
+             step->mName != n->mNodeNameHandle || step->mIndex != index)
+         {
+            step = new NodePathStep(above, n->mNodeNameHandle, index);
+            step->acquire();
+            if (n->mPathStep != NULL)
+            {  n->mPathStep->release(); }
+            n->mPathStep = step;
+         }
+         above = step;
+      }
+      return NodePath(above);
+   }
+
+   NodePath::NodePath()
+      : mLast(NULL)
+   {}
+
+   NodePath::NodePath(NodePathStep* step)
+      : mLast(step)
+   {
+      if (mLast != NULL)
+      {  mLast->acquire(); }
+   }
+
+   NodePath::NodePath(const NodePath& other)
+      : mLast(other.mLast)
+   {
+      if (mLast != NULL)
+      {  mLast->acquire(); }
+   }
+
+   NodePath::~NodePath()
+   {
+      if (mLast != NULL)
+      {  mLast->release(); }
+   }
+
+   NodePath& NodePath::operator=(const NodePath& other)
+   {
+      if (other.mLast != NULL)
+      {  other.mLast->acquire(); }
+      if (mLast != NULL)
+      {  mLast->release(); }
+      mLast = other.mLast;
+      return *this;
+   }
+
+   std::size_t NodePath::getLength() const
+   {
+      return mLast == NULL ? 0 : mLast->mLength;
+   }
+
+   TagNameHandle NodePath::getNameHandle(std::size_t i) const
+   {
+      return mLast->at(i)->mName;
+   }
+
+   unsigned NodePath::getIndex(std::size_t i) const
+   {
+      return mLast->at(i)->mIndex;
+   }
+
+   void NodePath::push(TagNameHandle name, unsigned index)
+   {
+      NodePathStep* step = new NodePathStep(mLast, name, index);
+      step->acquire();
+      if (mLast != NULL)
+      {  mLast->release(); }
+      mLast = step;
+   }
+
+   void NodePath::clear()
+   {
+      if (mLast != NULL)
+      {  mLast->release(); }
+      mLast = NULL;
+   }
+
+   Node::HashValue NodePath::getHash() const
+   {
+      return mLast == NULL ? 0 : mLast->mHash;
+   }
+
+   std::string NodePath::getString(const Context& context, bool indices) const
+   {
+      // The steps from the top down, and the size of the path
+      std::vector<const NodePathStep*> steps(getLength());
+      std::size_t length(0);
+      for (const NodePathStep* step = mLast; step != NULL; step = step->mParent)
       {
-         path = parent->getName() + "/" + path;
-         parent = parent->getParent();
+         steps[step->mLength - 1] = step;
+         length += context.getTagname(step->mName).size() + 1;
+         if (indices)
+         {  length += 12; }
+      }
+
+      std::string path;
+      path.reserve(length);
+      for (std::size_t i = 0; i < steps.size(); ++i)
+      {
+         if (i != 0)
+         {  path += '/'; }
+         path += context.getTagname(steps[i]->mName);
+         if (indices)
+         {
+            char buf[16];
+            std::sprintf(buf, "[%u]", steps[i]->mIndex);
+            path += buf;
+         }
       }
       return path;
    }
 
+   bool NodePath::operator==(const NodePath& other) const
+   {
+      if (getHash() != other.getHash() || getLength() != other.getLength())
+      {  return false; }
+
+      // Paths of one tree share their steps from the first common one up
+      const NodePathStep* a = mLast;
+      const NodePathStep* b = other.mLast;
+      for (; a != b; a = a->mParent, b = b->mParent)
+      {
+         if (a->mName != b->mName || a->mIndex != b->mIndex)
+         {  return false; }
+      }
+      return true;
+   }
+
+   bool NodePath::operator<(const NodePath& other) const
+   {
+      // Go up to the steps at the same depth, then to their first
+      // common ancestor; the steps just below it decide
+      const NodePathStep* a = mLast;
+      const NodePathStep* b = other.mLast;
+      const std::size_t length_a = getLength();
+      const std::size_t length_b = other.getLength();
+      for (std::size_t n = length_a; n > length_b; --n)
+      {  a = a->mParent; }
+      for (std::size_t n = length_b; n > length_a; --n)
+      {  b = b->mParent; }
+
+      const NodePathStep* diff_a = NULL;
+      const NodePathStep* diff_b = NULL;
+      for (; a != b; a = a->mParent, b = b->mParent)
+      {
+         if (a->mName != b->mName || a->mIndex != b->mIndex)
+         {
+            diff_a = a;
+            diff_b = b;
+         }
+      }
+      if (diff_a != NULL)
+      {
+         if (diff_a->mIndex != diff_b->mIndex)
+         {  return diff_a->mIndex < diff_b->mIndex; }
+         return diff_a->mName < diff_b->mName;
+      }
+      return length_a < length_b;
+   }
+
    /** \exception throws cppdom::Error when a streaming or parsing error occur */
    void Node::load(std::istream& in, ContextPtr& context)
    {
-      Parser parser(in, context->getLocation());
+      load(in, context, context->getLocation());
+   }
+
+   /** \exception throws cppdom::Error when a streaming or parsing error occur */
+   void Node::load(std::istream& in, ContextPtr& context, Location& location)
+   {
+      invalidateHash();
+      dropLazy();
+
+      // The parser sets our attributes directly, the children it adds are
+      // indexed by addChild
+      indexContent(false, false);
+      Parser parser(in, location);
       parser.parseNode(*this, context);
+      indexContent(true, false);
    }
 
    /** \exception throws cppdom::Error when a streaming or parsing error occur */
    void Node::save(std::ostream& out, int indent, bool doIndent, bool doNewline)
    {
+      expand();
+
       // output indendation spaces
       if(doIndent)
       {
@@ -857,7 +2487,13 @@ namespace cppdom
       }
 
       // output cdata
-      if (mNodeType == xml_nt_cdata)
+      if (mNodeType == xml_nt_cdata && mCdataBinary)
+      {
+         base64::encode(reinterpret_cast<const unsigned char*>(mCdata.data()), mCdata.size(), out);
+         if(doNewline)
+            out << std::endl;
+      }
+      else if (mNodeType == xml_nt_cdata)
       {
          if(textNeedsXmlEscaping(mCdata, true))
          {
@@ -870,6 +2506,21 @@ namespace cppdom
          if(doNewline)
             out << std::endl;
       }
+      else if (mNodeType == xml_nt_comment)
+      {
+         out << "<!--" << getCdata() << "-->";
+         if(doNewline)
+            out << std::endl;
+      }
+      else if (mNodeType == xml_nt_pi)
+      {
+         out << "<?" << mContext->getTagname(mNodeNameHandle);
+         if(!mCdata.empty())
+            out << ' ' << getCdata();
+         out << "?>";
+         if(doNewline)
+            out << std::endl;
+      }
       else
       {
          // output tag name
@@ -978,7 +2629,16 @@ namespace cppdom
    /** \exception throws cppdom::Error when a streaming or parsing error occur */
    void Document::load(std::istream& in, ContextPtr& context)
    {
-      Parser parser(in, context->getLocation());
+      load(in, context, context->getLocation());
+   }
+
+   /** \exception throws cppdom::Error when a streaming or parsing error occur */
+   void Document::load(std::istream& in, ContextPtr& context, Location& location)
+   {
+      invalidateHash();
+      for (std::vector<AttributeIndex>::iterator i = mIndexes.begin(); i != mIndexes.end(); ++i)
+      {  i->mEntries.clear(); }
+      Parser parser(in, location);
       parser.parseDocument(*this, context);
    }
 
@@ -1020,7 +2680,7 @@ namespace cppdom
       (*mNodeList.begin())->save(out, 0, doIndent, doNewline);
    }
 
-   void Document::loadFile(const std::string& filename) throw(Error)
+   void Document::loadFile(const std::string& filename)
    {
       std::ifstream in;
       in.open(filename.c_str(), std::ios::in);
@@ -1088,4 +2748,140 @@ namespace cppdom
       out.close();
    }
 
+   void Document::buildIndex(const std::string& attribute)
+   {
+      if (findIndex(attribute) == NULL)
+      {  mIndexes.push_back(AttributeIndex(attribute)); }
+      rebuildIndexes();
+   }
+
+   void Document::dropIndex(const std::string& attribute)
+   {
+      for (std::vector<AttributeIndex>::iterator i = mIndexes.begin(); i != mIndexes.end(); ++i)
+      {
+         if (i->mAttribute == attribute)
+         {
+            mIndexes.erase(i);
+            if (mIndexes.empty())
+            {  indexTree(*this, false); }
+            return;
+         }
+      }
+   }
+
+   bool Document::hasIndex(const std::string& attribute) const
+   {
+      return findIndex(attribute) != NULL;
+   }
+
+   NodePtr Document::findByAttribute(const std::string& attribute, const std::string& value) const
+   {
+      const AttributeIndex* index = findIndex(attribute);
+      if (index == NULL)
+      {
+         throw CPPDOM_ERROR(xml_invalid_operation, "Attempted to look up an attribute without an index");
+      }
+
+      std::pair<AttributeIndexMap_t::const_iterator, AttributeIndexMap_t::const_iterator> range =
+         index->mEntries.equal_range(value);
+      for (AttributeIndexMap_t::const_iterator e = range.first; e != range.second; ++e)
+      {
+         if (holdsEntry(*e->second, attribute, value))
+         {  return e->second; }
+      }
+      return NodePtr();
+   }
+
+   NodePtr Document::findById(const std::string& value) const
+   {
+      return findByAttribute("id", value);
+   }
+
+   const Document::AttributeIndex* Document::findIndex(const std::string& attribute) const
+   {
+      for (std::vector<AttributeIndex>::const_iterator i = mIndexes.begin(); i != mIndexes.end(); ++i)
+      {
+         if (i->mAttribute == attribute)
+         {  return &*i; }
+      }
+      return NULL;
+   }
+
+   bool Document::holdsEntry(const Node& node, const std::string& attribute,
+                             const std::string& value) const
+   {
+      Attributes::const_iterator attr = node.mAttributes.find(attribute);
+      if (attr == node.mAttributes.end() || attr->second.getString() != value)
+      {  return false; }
+
+      // Every node on the way up must still be a child of the next
+      const Node* n = &node;
+      for (; n->mParent != NULL; n = n->mParent)
+      {
+         if (!n->checkIndex())
+         {  return false; }
+      }
+      return n == this;
+   }
+
+   void Document::indexNode(Node& node, bool add)
+   {
+      if (node.mAttributes.empty())
+      {  return; }
+
+      // The entries hold the node, which only its parent can give out
+      if (add && !node.checkIndex())
+      {  return; }
+
+      for (std::vector<AttributeIndex>::iterator i = mIndexes.begin(); i != mIndexes.end(); ++i)
+      {
+         Attributes::const_iterator attr = node.mAttributes.find(i->mAttribute);
+         if (attr == node.mAttributes.end())
+         {  continue; }
+
+         const std::string& value = attr->second.getString();
+         if (add)
+         {
+            i->mEntries.insert(std::make_pair(value, node.mParent->mNodeList[node.mIndex]));
+            continue;
+         }
+
+         std::pair<AttributeIndexMap_t::iterator, AttributeIndexMap_t::iterator> range =
+            i->mEntries.equal_range(value);
+         for (AttributeIndexMap_t::iterator e = range.first; e != range.second; ++e)
+         {
+            if (e->second.get() == &node)
+            {
+               i->mEntries.erase(e);
+               break;
+            }
+         }
+      }
+   }
+
+   void Document::indexTree(Node& node, bool add)
+   {
+      std::vector<Node*> pending(1, &node);
+      while (!pending.empty())
+      {
+         Node* n = pending.back();
+         pending.pop_back();
+         n->expand();
+         n->mIndexed = add;
+         indexNode(*n, add);
+         for (NodeList::const_iterator c = n->mNodeList.begin(); c != n->mNodeList.end(); ++c)
+         {  pending.push_back(c->get()); }
+      }
+   }
+
+   void Document::rebuildIndexes()
+   {
+      if (mIndexes.empty())
+      {  return; }
+
+      for (std::vector<AttributeIndex>::iterator i = mIndexes.begin(); i != mIndexes.end(); ++i)
+      {  i->mEntries.clear(); }
+      indexTree(*this, true);
+   }
+
 }
@@ -61,6 +61,8 @@
 #include <sstream>
 #include <vector>
 #include <iostream>
+#include <cctype>
+#include <utility>
 
 
 // ---- TYPE DEFS for CPPDOM --- //
@@ -70,6 +72,12 @@ namespace cppdom
    typedef int TagNameHandle;
 }
 
+// the index maps below hold node smart pointers, see shared_ptr.h
+namespace cppdom_boost
+{
+   template<typename T> class shared_ptr;
+}
+
 #define CPPDOM_USE_HASH_MAP 1
 
 // Use fastest map available
@@ -90,6 +98,9 @@ namespace cppdom
 {
    typedef std::tr1::unordered_map<TagNameHandle,std::string>   TagNameMap_t;
    typedef std::tr1::unordered_map<std::string, TagNameHandle>  NameToTagMap_t;
+
+   class Node;
+   typedef std::tr1::unordered_multimap<std::string, cppdom_boost::shared_ptr<Node> >  AttributeIndexMap_t;
 }
 
 #  elif defined(__GNUC__) && (__GNUC__ >= 3)
@@ -109,6 +120,9 @@ namespace cppdom
 
    typedef std::hash_map<TagNameHandle,std::string>   TagNameMap_t;
    typedef std::hash_map<std::string, TagNameHandle, HashString>  NameToTagMap_t;
+
+   class Node;
+   typedef std::hash_multimap<std::string, cppdom_boost::shared_ptr<Node>, HashString>  AttributeIndexMap_t;
 }
 #  else
 #    undef CPPDOM_USE_HASH_MAP
@@ -123,11 +137,15 @@ namespace cppdom
 {
    typedef std::map<TagNameHandle,std::string>   TagNameMap_t;
    typedef std::map<std::string, TagNameHandle>  NameToTagMap_t;
+
+   class Node;
+   typedef std::multimap<std::string, cppdom_boost::shared_ptr<Node> >  AttributeIndexMap_t;
 }
 #endif // #if defined(CPPDOM_USE_HASH_MAP)
 
 #include "config.h"
 #include "shared_ptr.h"   // the boost::shared_ptr class
+#include "threads.h"       // atomics of the value caches
 
 
 
@@ -156,6 +174,147 @@ namespace cppdom
    // Add escaping to xml text
    CPPDOM_EXPORT(std::string) addXmlEscaping(const std::string& data, bool isCdata);
 
+   /** @name Attribute value conversion
+    * Used by Attribute::getValue() and Attribute::setValue(). Integers,
+    * floating point numbers and bool convert without string streams and
+    * independent of the locale; other types use their stream operators.
+    * bool reads "1", "0", "true" and "false" and writes "1" or "0".
+    * Numbers are written like a default std::ostream would write them.
+    */
+   //@{
+   /**
+    * Converts text to value. Surrounding whitespace is ignored; anything
+    * else that is not part of the value is an error.
+    * @return false (and value unchanged) if text is not a valid value
+    */
+   template<class T>
+   bool parseValue(const std::string& text, T& value)
+   {
+      std::istringstream iss(text);
+      T t;
+      iss >> t;
+      if (iss.fail() || !(iss >> std::ws).eof())
+      {  return false; }
+      value = t;
+      return true;
+   }
+
+   inline bool parseValue(const std::string& text, std::string& value)
+   {
+      value = text;
+      return true;
+   }
+
+   CPPDOM_EXPORT(bool) parseValue(const std::string& text, bool& value);
+   CPPDOM_EXPORT(bool) parseValue(const std::string& text, short& value);
+   CPPDOM_EXPORT(bool) parseValue(const std::string& text, unsigned short& value);
+   CPPDOM_EXPORT(bool) parseValue(const std::string& text, int& value);
+   CPPDOM_EXPORT(bool) parseValue(const std::string& text, unsigned int& value);
+   CPPDOM_EXPORT(bool) parseValue(const std::string& text, long& value);
+   CPPDOM_EXPORT(bool) parseValue(const std::string& text, unsigned long& value);
+#ifdef CPPDOM_HAS_LONG_LONG
+   CPPDOM_EXPORT(bool) parseValue(const std::string& text, long long& value);
+   CPPDOM_EXPORT(bool) parseValue(const std::string& text, unsigned long long& value);
+#endif
+   CPPDOM_EXPORT(bool) parseValue(const std::string& text, float& value);
+   CPPDOM_EXPORT(bool) parseValue(const std::string& text, double& value);
+
+   /** Sets text to the string form of value. */
+   template<class T>
+   void formatValue(std::string& text, const T& value)
+   {
+      std::ostringstream oss;
+      oss << value;
+      text = oss.str();
+   }
+
+   inline void formatValue(std::string& text, const std::string& value)
+   {
+      text = value;
+   }
+
+   CPPDOM_EXPORT(void) formatValue(std::string& text, bool value);
+   CPPDOM_EXPORT(void) formatValue(std::string& text, short value);
+   CPPDOM_EXPORT(void) formatValue(std::string& text, unsigned short value);
+   CPPDOM_EXPORT(void) formatValue(std::string& text, int value);
+   CPPDOM_EXPORT(void) formatValue(std::string& text, unsigned int value);
+   CPPDOM_EXPORT(void) formatValue(std::string& text, long value);
+   CPPDOM_EXPORT(void) formatValue(std::string& text, unsigned long value);
+#ifdef CPPDOM_HAS_LONG_LONG
+   CPPDOM_EXPORT(void) formatValue(std::string& text, long long value);
+   CPPDOM_EXPORT(void) formatValue(std::string& text, unsigned long long value);
+#endif
+   CPPDOM_EXPORT(void) formatValue(std::string& text, float value);
+   CPPDOM_EXPORT(void) formatValue(std::string& text, double value);
+
+   /**
+    * Converts whitespace separated values, such as "1.0 2.0 3.0".
+    * values is cleared first, so a reused vector does not reallocate.
+    * @return false if an element is not a valid T. values then holds the
+    *         elements before it.
+    */
+   template<class T>
+   bool parseArray(const std::string& text, std::vector<T>& values)
+   {
+      values.clear();
+      std::istringstream iss(text);
+      T t;
+      while (!(iss >> std::ws).eof())
+      {
+         if (!(iss >> t) || !(iss.eof() || std::isspace(iss.peek())))
+         {  return false; }
+         values.push_back(t);
+      }
+      return true;
+   }
+
+   CPPDOM_EXPORT(bool) parseArray(const std::string& text, std::vector<short>& values);
+   CPPDOM_EXPORT(bool) parseArray(const std::string& text, std::vector<unsigned short>& values);
+   CPPDOM_EXPORT(bool) parseArray(const std::string& text, std::vector<int>& values);
+   CPPDOM_EXPORT(bool) parseArray(const std::string& text, std::vector<unsigned int>& values);
+   CPPDOM_EXPORT(bool) parseArray(const std::string& text, std::vector<long>& values);
+   CPPDOM_EXPORT(bool) parseArray(const std::string& text, std::vector<unsigned long>& values);
+#ifdef CPPDOM_HAS_LONG_LONG
+   CPPDOM_EXPORT(bool) parseArray(const std::string& text, std::vector<long long>& values);
+   CPPDOM_EXPORT(bool) parseArray(const std::string& text, std::vector<unsigned long long>& values);
+#endif
+   CPPDOM_EXPORT(bool) parseArray(const std::string& text, std::vector<float>& values);
+   CPPDOM_EXPORT(bool) parseArray(const std::string& text, std::vector<double>& values);
+
+   /** Sets text to the count values separated by single spaces. */
+   template<class T>
+   void formatArray(std::string& text, const T* values, std::size_t count)
+   {
+      std::ostringstream oss;
+      for (std::size_t i = 0; i < count; ++i)
+      {
+         if (i != 0)
+         {  oss << ' '; }
+         oss << values[i];
+      }
+      text = oss.str();
+   }
+
+   CPPDOM_EXPORT(void) formatArray(std::string& text, const short* values, std::size_t count);
+   CPPDOM_EXPORT(void) formatArray(std::string& text, const unsigned short* values, std::size_t count);
+   CPPDOM_EXPORT(void) formatArray(std::string& text, const int* values, std::size_t count);
+   CPPDOM_EXPORT(void) formatArray(std::string& text, const unsigned int* values, std::size_t count);
+   CPPDOM_EXPORT(void) formatArray(std::string& text, const long* values, std::size_t count);
+   CPPDOM_EXPORT(void) formatArray(std::string& text, const unsigned long* values, std::size_t count);
+#ifdef CPPDOM_HAS_LONG_LONG
+   CPPDOM_EXPORT(void) formatArray(std::string& text, const long long* values, std::size_t count);
+   CPPDOM_EXPORT(void) formatArray(std::string& text, const unsigned long long* values, std::size_t count);
+#endif
+   CPPDOM_EXPORT(void) formatArray(std::string& text, const float* values, std::size_t count);
+   CPPDOM_EXPORT(void) formatArray(std::string& text, const double* values, std::size_t count);
+
+   template<class T>
+   void formatArray(std::string& text, const std::vector<T>& values)
+   {
+      formatArray(text, values.empty() ? (const T*)0 : &values[0], values.size());
+   }
+   //@}
+
    /** Method to split string base on seperator.
     *
     * If separator does not exist in string, then just return that string in the output.
@@ -204,6 +363,8 @@ namespace cppdom
       xml_filename_invalid,
       xml_file_access,
       xml_escaping_failure,         /**< Problem with escaping */
+      xml_invalid_binary_format,    /**< binary document image is malformed or foreign */
+      xml_invalid_base64,           /**< text that should be base64 is not */
 
       xml_dummy                     /**< dummy error code */
    };
@@ -216,6 +377,14 @@ namespace cppdom
    class Document;
    typedef cppdom_boost::shared_ptr<cppdom::Document> DocumentPtr;
 
+   class BinaryDocument;
+   class FrozenDocument;
+   class LazySource;
+   class NodePath;
+   struct NodePathStep;
+   typedef cppdom_boost::shared_ptr<cppdom::FrozenDocument> FrozenDocumentPtr;
+   namespace binary { class TreeBuilder; }
+
 
    /** list of node smart pointer */
    typedef std::vector<NodePtr> NodeList;
@@ -256,6 +425,7 @@ namespace cppdom
       ErrorCode   mErrorCode;
       std::string mLocalDesc; /**< Local description of the error */
       std::string mLocation;  /**< The location text */
+      std::string mWhat;      /**< The text returned by what() */
    };
 
 
@@ -285,6 +455,9 @@ namespace cppdom
       /** reset location */
       void reset();
 
+      /** moves to the given position, used when parsing starts mid-stream */
+      void set(int line, int pos);
+
    protected:
       int mLine;
       int mPos;
@@ -295,13 +468,22 @@ namespace cppdom
    /** smart pointer for Context */
    typedef cppdom_boost::shared_ptr<class Context> ContextPtr;
 
+   class TagTable;
+
    /** smart pointer to the event handler */
    typedef cppdom_boost::shared_ptr<class EventHandler> EventHandlerPtr;
 
+   /** smart pointer to an element filter */
+   typedef cppdom_boost::shared_ptr<class ElementFilter> ElementFilterPtr;
+
    /**
     * xml parsing context class.
     * the class is the parsing context for the parsed xml document.
     * the class has a tagname lookup table and an entity map
+    * tag names may be looked up and inserted by any number of threads at
+    * once, so one context can be shared by documents parsed in parallel;
+    * such parses should each pass their own Location to load()
+    * (not with CPPDOM_NO_THREADS, see threads.h)
     */
    class CPPDOM_CLASS Context
    {
@@ -312,11 +494,17 @@ namespace cppdom
       virtual ~Context();
 
       /** returns the tagname by the tagname handle */
-      std::string getTagname(TagNameHandle handle);
+      const std::string& getTagname(TagNameHandle handle) const;
+
+      /** returns the handle of a known tag name, -1 when the name was never inserted */
+      TagNameHandle findTagname(const std::string& tagname) const;
 
       /** inserts a tag name and returns a tag name handle to the string */
       TagNameHandle insertTagname(const std::string& tagname);
 
+      /** insertTagname() for a name that is not held in a string */
+      TagNameHandle insertTagname(const char* tagname, std::size_t length);
+
       /** returns the current location in the xml stream */
       Location& getLocation();
 
@@ -332,22 +520,118 @@ namespace cppdom
       bool hasEventHandler() const;
       //@}
 
+      /** what the parser keeps of the whitespace in the text of elements */
+      enum WhitespaceMode
+      {
+         xml_ws_trim_leading,  /**< drops leading whitespace, and so whitespace-only text (default) */
+         xml_ws_drop_blank,    /**< drops whitespace-only text, keeps other text as it is */
+         xml_ws_trim,          /**< drops leading and trailing whitespace */
+         xml_ws_preserve       /**< keeps all text as it is, whitespace-only text too */
+      };
+
+      /** @name parsing options */
+      //@{
+      /**
+       * sets how whitespace in text is handled. the tokenizer skips the
+       * dropped whitespace, it never ends up in a string or a cdata node.
+       */
+      void setWhitespaceMode(WhitespaceMode mode);
+
+      /** returns how whitespace in text is handled */
+      WhitespaceMode getWhitespaceMode() const;
+
+      /**
+       * keeps comments inside the root element as xml_nt_comment nodes.
+       * off by default, comments are skipped.
+       */
+      void setKeepComments(bool keep);
+
+      /** returns if comments are kept */
+      bool getKeepComments() const;
+
+      /**
+       * keeps processing instructions inside the root element as xml_nt_pi
+       * nodes. off by default, they are skipped. the ones before the root
+       * element always go to the document's pi list.
+       */
+      void setKeepProcessingInstructions(bool keep);
+
+      /** returns if processing instructions are kept */
+      bool getKeepProcessingInstructions() const;
+
+      /**
+       * decodes the text of the named elements as base64 while parsing.
+       * their cdata nodes keep the bytes (see Node::getCdataBinary), the
+       * text is not kept. text that is not base64 is a parse error.
+       */
+      void addBase64Element(const std::string& tagname);
+
+      /** returns if the text of the element is decoded while parsing */
+      bool isBase64Element(TagNameHandle handle) const;
+
+      /**
+       * parses only the elements the filter keeps. the ones it rejects are
+       * skipped with their content by a scan that only balances the tags:
+       * nothing in them is tokenized, decoded or allocated, and their
+       * tag names are not checked. NULL keeps all elements (the default).
+       * The filter must keep the root element, loading throws
+       * cppdom::Error when it does not.
+       */
+      void setElementFilter(ElementFilterPtr filter);
+
+      /** returns the element filter, NULL if there is none */
+      const ElementFilterPtr& getElementFilter() const;
+      //@}
+
+   private:
+      Context(const Context&);
+      Context& operator=(const Context&);
+
    protected:
       bool              mInit;            /**< indicates if init_context() was already called */
-      int               mNextHandle;      /**< next available tagname handle */
-      TagNameMap_t      mTagToName;       /**< matches TagNameHandles to the real std::string's */
-      NameToTagMap_t    mNameToTag;       /**< Map name to tag for inserting. */
+      TagTable*         mTagTable;        /**< tag name <-> handle interning */
       Location          mLocation;        /**< location of the xml input stream */
       bool              mHandleEvents;    /**< indicates if the event handler is used */
       EventHandlerPtr   mEventHandler;    /**< current parsing event handler */
+      bool              mKeepComments;    /**< keep comments as nodes */
+      bool              mKeepPis;         /**< keep processing instructions as nodes */
+      WhitespaceMode    mWhitespaceMode;  /**< whitespace handling of text */
+      std::vector<TagNameHandle> mBase64Elements;  /**< elements with base64 text */
+      ElementFilterPtr  mElementFilter;   /**< elements to parse, NULL for all */
    };
    
 
+   /**
+    * Tags the value types an Attribute keeps a parsed copy of.
+    * 0 for types that are parsed on every read.
+    */
+   template<class T> struct AttributeCacheType { enum { value = 0 }; };
+   template<> struct AttributeCacheType<bool>           { enum { value = 1 }; };
+   template<> struct AttributeCacheType<short>          { enum { value = 2 }; };
+   template<> struct AttributeCacheType<unsigned short> { enum { value = 3 }; };
+   template<> struct AttributeCacheType<int>            { enum { value = 4 }; };
+   template<> struct AttributeCacheType<unsigned int>   { enum { value = 5 }; };
+   template<> struct AttributeCacheType<long>           { enum { value = 6 }; };
+   template<> struct AttributeCacheType<unsigned long>  { enum { value = 7 }; };
+#ifdef CPPDOM_HAS_LONG_LONG
+   template<> struct AttributeCacheType<long long>          { enum { value = 8 }; };
+   template<> struct AttributeCacheType<unsigned long long> { enum { value = 9 }; };
+#endif
+   template<> struct AttributeCacheType<float>          { enum { value = 10 }; };
+   template<> struct AttributeCacheType<double>         { enum { value = 11 }; };
+
    /**
     * XML attribute class.
     * Just wraps a string (this is really just and attribute VALUE)
     * This is just meant to be a "magic" class to provide some syntactic
     * sugar related to autoconversions and get<value>() usefullness.
+    *
+    * The first successful getValue() as a number or bool keeps the parsed
+    * value, so later reads as the same type skip the parsing. Reads as
+    * another type parse the string as usual. The string stays the
+    * canonical value (it is what Node::save() writes); every write through
+    * setValue() or assignment drops the parsed copy. Filling the cache is
+    * safe while other threads read the same attribute.
     */
    class CPPDOM_CLASS Attribute
    {
@@ -356,6 +640,30 @@ namespace cppdom
       Attribute(const Attribute& attr);
       Attribute(const std::string& val);
 
+      Attribute& operator=(const Attribute& attr);
+
+#ifdef CPPDOM_HAS_RVALUE_REFERENCES
+      // Inline, so that they do not depend on how the library was built
+      Attribute(Attribute&& attr)
+         : mData(std::move(attr.mData))
+      {
+         copyCache(attr);
+         attr.mCache.mType.store(0);
+      }
+
+      Attribute& operator=(Attribute&& attr)
+      {
+         if (this != &attr)
+         {
+            mData = std::move(attr.mData);
+            mCache.mType.store(0);
+            copyCache(attr);
+            attr.mCache.mType.store(0);
+         }
+         return *this;
+      }
+#endif
+
 #ifndef CPPDOM_NO_MEMBER_TEMPLATES
       template<class T>
       explicit Attribute(const T& val)
@@ -369,25 +677,56 @@ namespace cppdom
 #ifndef CPPDOM_NO_MEMBER_TEMPLATES
       /**
        * Set mData to the string value of val
-       * @note Requires a stream operation of type T
+       * @note Types without a formatValue() overload need a stream operator
        */
       template<class T>
       void setValue(const T& val)
       {
-         std::ostringstream oss;
-         oss << val;
-         mData = oss.str();
+         formatValue(mData, val);
+         mCache.mType.store(0);
       }
 
+      /**
+       * Returns the value converted to T. A value that is not a valid T is
+       * read the way operator>> reads it: its leading part, so "1.5" gives 1
+       * as an int, or T() if there is none.
+       * @see tryGetValue, which rejects such values
+       */
       template<class T>
       T getValue() const
       {
-         T t;
-         std::istringstream iss(mData);
-         iss >> t;
+         T t = T();
+         if (!tryGetValue(t))
+         {
+            std::istringstream iss(mData);
+            iss >> t;
+         }
          return t;
       }
 
+      /**
+       * Converts the value to T.
+       * @return false (and value unchanged) if it is not a valid T
+       */
+      template<class T>
+      bool tryGetValue(T& value) const
+      {
+         const int type = AttributeCacheType<T>::value;
+         if (type != 0 && loadCache(type, &value, sizeof(T)))
+         {
+            return true;
+         }
+         if (!parseValue(mData, value))
+         {
+            return false;
+         }
+         if (type != 0)
+         {
+            storeCache(type, &value, sizeof(T));
+         }
+         return true;
+      }
+
       // Specializations of getValue<T> placed inline for Visual Studio 7.
       // MIPSpro and GCC do not handle this. They get out-of-line
       // specializations, found below.
@@ -418,7 +757,39 @@ namespace cppdom
       }
 
    protected:
+      /** copies the cached value into value if it is of the given type */
+      bool loadCache(int type, void* value, std::size_t size) const;
+
+      /** caches value unless a value is cached already */
+      void storeCache(int type, const void* value, std::size_t size) const;
+
+      /** takes over the cached value of attr, if it has one */
+      void copyCache(const Attribute& attr);
+
+      /** parsed copy of mData */
+      struct Cache
+      {
+         Cache()
+            : mType(0)
+         {}
+
+         threads::Atomic<long> mType;    /**< AttributeCacheType, 0 if empty, -1 while written */
+         union
+         {
+            double mDouble;
+            long   mLong;
+#ifdef CPPDOM_HAS_LONG_LONG
+            long long mLongLong;
+#endif
+         } mValue;
+
+      private:
+         Cache(const Cache&);
+         Cache& operator=(const Cache&);
+      };
+
       std::string mData;
+      mutable Cache mCache;
    };
 
 #ifndef CPPDOM_NO_MEMBER_TEMPLATES
@@ -449,6 +820,21 @@ namespace cppdom
             /** ctor */
       Attributes();
 
+      Attributes(const Attributes& attribs);
+      Attributes& operator=(const Attributes& attribs);
+
+#ifdef CPPDOM_HAS_RVALUE_REFERENCES
+      Attributes(Attributes&& attribs)
+         : std::map<std::string, Attribute>(std::move(attribs))
+      {}
+
+      Attributes& operator=(Attributes&& attribs)
+      {
+         std::map<std::string, Attribute>::operator=(std::move(attribs));
+         return *this;
+      }
+#endif
+
       /**
        * Get the named attribute.
        * @returns empty string "" if not found, else the value.
@@ -474,8 +860,23 @@ namespace cppdom
    * name - The element name of the node
    * type - The type of the node. see NodeType
    * children - Child elements of the node
-   * cdata - the cdata content if of type cdata
+   * cdata - the cdata content if of type cdata, the text if of type comment or pi
    *
+   * Threads: once a document is no longer modified, any number of threads
+   * may read it at the same time through the query methods (getName,
+   * getChild, getChildPath, getChildren, getAttribute, getCdata, ...).
+   * Readers only look up tag names and NodePtr copies use atomic counts.
+   * Modifying a node while other threads read the document is not safe.
+   * Neither are the methods that fill a cache on first use: getHash,
+   * getDepth, getPreOrder, getPostOrder, isAncestorOf and getNodePath.
+   * getIndex, getNextSibling and getPrevSibling belong to them after a
+   * child list was edited through the non-const getChildren(), as their
+   * first call renumbers that list. Call them from one thread, or once
+   * before sharing the document. A document that keeps structural hashes
+   * is read through const references, since the non-const getChildren()
+   * and attrib() drop the hashes.
+   * This holds for C++98 builds as well; only a library built with
+   * CPPDOM_NO_THREADS is single-threaded (see threads.h).
    */
    class CPPDOM_CLASS Node
    {
@@ -486,10 +887,16 @@ namespace cppdom
          xml_nt_node,      /**< normal node, can contain subnodes */
          xml_nt_leaf,      /**< a leaf node, which contains no further nodes, eg. <img/> */
          xml_nt_document,  /**< document root node */
-         xml_nt_cdata      /**< cdata node, which only contains char data */
+         xml_nt_cdata,     /**< cdata node, which only contains char data */
+         xml_nt_comment,   /**< comment, the cdata holds its text */
+         xml_nt_pi         /**< processing instruction, named by its target; the cdata holds its data */
       };
 
       friend class Parser;
+      friend class Patcher;
+      friend class binary::TreeBuilder;
+      friend class LazySource;
+      friend class Document;
    protected:
       /** Default Constructor */
       Node();
@@ -501,8 +908,24 @@ namespace cppdom
       /** Construct a node with a given name */
       explicit Node(std::string nodeName, ContextPtr ctx);
 
+      /**
+       * Copy constructor.  The copy shares the children of node rather than
+       * copying them; use clone() for an independent copy of a subtree.
+       */
       Node(const Node& node);
 
+#ifdef CPPDOM_HAS_RVALUE_REFERENCES
+      /**
+       * Move constructor.  Takes over the content and the children of node,
+       * which is left empty.  The new node has no parent.
+       */
+      Node(Node&& node)
+         : mNodeNameHandle(-1), mIndex(0), mNodeType(xml_nt_node), mCdataBinary(false)
+         , mHashValid(false), mIndexed(false), mParent(NULL), mHash(0), mLazySource(NULL)
+         , mLazyIndex(0), mOrder(NULL), mPathStep(NULL)
+      {  takeContent(node); }
+#endif
+
       ~Node();
 
       /** Create a node. */
@@ -515,9 +938,37 @@ namespace cppdom
       /** assign operator */
       Node& operator=(const Node& node);
 
+#ifdef CPPDOM_HAS_RVALUE_REFERENCES
+      /**
+       * Move assignment.  Takes over the content and the children of node,
+       * which is left empty.  This node keeps its place in the tree.
+       */
+      Node& operator=(Node&& node)
+      {
+         if (this != &node)
+         {  takeContent(node); }
+         return *this;
+      }
+#endif
+
+      /**
+       * Returns a copy of this node that shares nothing with it.
+       *
+       * @param deep     if true, the children are cloned as well; otherwise
+       *                 the copy has no children.
+       * @param context  context of the copy, which may differ from ours;
+       *                 our own context if NULL.
+       * @note The copy has no parent.  A deep copy keeps the structural
+       *       hash of the original.
+       */
+      NodePtr clone(bool deep = true, ContextPtr context = ContextPtr()) const;
+
       /** Returns true if the nodes are equal
       * @param ignoreAttribs - Attributes to ignore in the comparison
       * @param ignoreElements - Elements to ignore in the comparison
+      * @note When nothing is ignored, subtrees that both have a structural
+      *       hash (see getHash) and differ in it are unequal without being
+      *       compared. Equal hashes are still compared.
       */
       bool isEqual(NodePtr otherNode, const std::vector<std::string>& ignoreAttribs,
                    const std::vector<std::string>& ignoreElements,
@@ -529,10 +980,47 @@ namespace cppdom
          return isEqual(otherNode, empty_strings, empty_strings );
       }
 
+      /** @name Structural hash */
+      //@{
+#ifdef CPPDOM_HAS_LONG_LONG
+      typedef unsigned long long HashValue;
+#else
+      typedef unsigned long HashValue;
+#endif
+
+      /**
+       * Returns a hash of the subtree: the names, attributes and cdata of
+       * this node and its descendants. Subtrees that isEqual() considers
+       * equal have the same hash, whatever their contexts, so it can be
+       * used to find duplicates.
+       *
+       * The hash is computed on first use and kept by every node of the
+       * subtree until it changes. Changes made through setName, setType,
+       * setCdata, setAttribute, addChild, load and assignment drop the
+       * kept hashes, and so do the non-const attrib(), getAttrMap() and
+       * getChildren(). Changes made later through a reference they
+       * returned earlier are not seen; call invalidateHash() on the
+       * changed node after making them.
+       *
+       * @note Not safe to call while other threads use the subtree.
+       */
+      HashValue getHash() const;
+
+      /** Returns true if the node keeps a structural hash. */
+      bool hasHash() const;
+
+      /** Drops the structural hash of this node and its ancestors. */
+      void invalidateHash();
+      //@}
+
       /** Returns the local name of the node (the element name) */
       std::string getName();
+      /** Returns the handle of the node name in the context's tagname table */
+      TagNameHandle getNameHandle() const;
       /** set the node name */
       void setName(const std::string& name);
+      /** set the node name by a handle from the node's context */
+      void setNameHandle(TagNameHandle handle);
 
       /** @name Type information */
       //@{
@@ -547,6 +1035,10 @@ namespace cppdom
       { return getType() == xml_nt_document;}
       bool isCData()
       { return getType() == xml_nt_cdata;}
+      bool isComment()
+      { return getType() == xml_nt_comment;}
+      bool isPi()
+      { return getType() == xml_nt_pi;}
 
       /** sets new nodetype */
       void setType(Node::Type type);
@@ -589,6 +1081,38 @@ namespace cppdom
          setAttribute(attr, Attribute(value));
       }
 
+#ifndef CPPDOM_NO_MEMBER_TEMPLATES
+      /**
+       * Reads an attribute holding whitespace separated values, such as
+       * "1.0 2.0 3.0", straight from the stored text into values.
+       *
+       * @return false if the attribute does not exist (values is then
+       *         empty) or an element is not a valid T.
+       * @see parseArray
+       */
+      template<class T>
+      bool getAttributeArray(const std::string& name, std::vector<T>& values) const
+      {
+         expand();
+         Attributes::const_iterator i = mAttributes.find(name);
+         if (i == mAttributes.end())
+         {
+            values.clear();
+            return false;
+         }
+         return parseArray(i->second.getString(), values);
+      }
+
+      /** Sets an attribute to the values separated by single spaces. */
+      template<class T>
+      void setAttributeArray(const std::string& name, const std::vector<T>& values)
+      {
+         std::string text;
+         formatArray(text, values);
+         setAttribute(name, Attribute(text));
+      }
+#endif // ! CPPDOM_NO_MEMBER_TEMPLATES
+
       /** Direct access to attribute map. */
       Attributes& attrib();
 
@@ -626,6 +1150,9 @@ namespace cppdom
       /** returns a list of the nodes children */
       NodeList& getChildren();
 
+      /** returns a list of the nodes children, keeping the structural hash */
+      const NodeList& getChildren() const;
+
       /**
        * Returns a list of all children (one level deep) with local name of childName
        * \note currently no path-like childname can be passed, like in e.g. msxml
@@ -644,6 +1171,7 @@ namespace cppdom
       template<class Predicate>
       NodeList getChildrenPred(Predicate pred)
       {
+         expand();
          NodeList result(0);
          NodeList::const_iterator iter;
 
@@ -666,22 +1194,139 @@ namespace cppdom
       Node* getParent() const;
 
       /**
-       * Returns the full path of this node.
+       * Returns the full path of this node, the names of its ancestors and
+       * its own separated by '/'.
        */
       std::string getPath();
 
+      /**
+       * Returns the path of this node as name handles and child positions.
+       * Each node keeps its last step, which refers to the step of its
+       * parent, so the paths of a tree share their common prefixes. Only
+       * the steps of nodes renamed or moved since the last call are made
+       * again; the others are checked in O(depth). A returned path does not
+       * change with the tree.
+       *
+       * @note Not safe to call while other threads use the tree.
+       */
+      NodePath getNodePath() const;
+
       void addChild(NodePtr& node);
-      bool removeChild(NodePtr& node);
-      bool removeChild(std::string& childName);
-      bool removeChildren(std::string& childName);
+
+      /**
+       * Removes the given node from our children.  The removed node is left
+       * without a parent.
+       *
+       * @return true if the node was one of our children.
+       */
+      bool removeChild(const NodePtr& node);
+
+      /**
+       * Removes the first child with the given name.
+       *
+       * @return true if such a child was found.
+       */
+      bool removeChild(const std::string& childName);
+
+      /**
+       * Removes all children with the given name in one pass over the list.
+       *
+       * @return true if any child was removed.
+       */
+      bool removeChildren(const std::string& childName);
+
+      /**
+       * Removes all children that pass the given STL predicate, compacting
+       * the child list in a single pass.  The predicate is called once for
+       * each child, in order.  Removed children are left without a parent.
+       *
+       * @return true if any child was removed.
+       */
+      template<class Predicate>
+      bool removeChildrenIf(Predicate pred)
+      {
+         expand();
+         NodeList::iterator kept = mNodeList.begin();
+         NodeList::iterator iter = mNodeList.begin();
+         try
+         {
+            for(; iter != mNodeList.end(); ++iter)
+            {
+               if (pred(*iter))
+               {
+                  (*iter)->mParent = NULL;
+               }
+               else
+               {
+                  if (kept != iter)
+                  {  kept->swap(*iter); }
+                  ++kept;
+               }
+            }
+         }
+         catch(...)
+         {
+            // Everything between kept and iter has been removed already
+            eraseChildren(kept, iter);
+            throw;
+         }
+         return eraseChildren(kept, mNodeList.end());
+      }
 
       //@}
 
+      /** @name Siblings and document order */
+      //@{
+      /**
+       * Returns the position of the node among the children of its parent,
+       * 0 without a parent. The node keeps it, so this is O(1) unless the
+       * child list changed as a whole; it is then counted again once.
+       * @note That recount writes to the siblings, see the thread notes
+       *       of Node.
+       */
+      unsigned getIndex() const;
+
+      /** Returns the next child of our parent, NULL for the last one. */
+      NodePtr getNextSibling() const;
+
+      /** Returns the previous child of our parent, NULL for the first one. */
+      NodePtr getPrevSibling() const;
+
+      /**
+       * Returns the number of ancestors. O(1) while the tree is numbered
+       * (see getPreOrder), otherwise the ancestors are counted.
+       */
+      unsigned getDepth() const;
+
+      /**
+       * Returns the position of the node in a preorder walk of its tree,
+       * the tree of its topmost ancestor. The numbers of the whole tree
+       * are computed on first use and kept until a child is added or
+       * removed anywhere in it. Lazily loaded nodes that are not parsed
+       * yet count as leaves; parsing one adds children, so the tree is
+       * numbered again on the next use. Changes made through the reference
+       * returned by getChildren() are not seen.
+       *
+       * @note Not safe to call while other threads use the tree.
+       */
+      unsigned getPreOrder() const;
+
+      /** Returns the position of the node in a postorder walk of its tree. */
+      unsigned getPostOrder() const;
+
+      /**
+       * Returns true if this node is a proper ancestor of node. O(1) with
+       * the numbers of getPreOrder.
+       */
+      bool isAncestorOf(const Node& node) const;
+      //@}
+
       /** @name CData methods */
       //@{
       /**
        * returns cdata string
        * @note: For node type "cdata", this returns the local cdata.
+       *        Comment and pi nodes return their text.
        *        For other nodes, this attempts to find the first child cdata
        *        node and returns its data.
        */
@@ -696,10 +1341,54 @@ namespace cppdom
 
       /** Sets the node cdata.
       * @post For cdata type nodes, this sets the contained cdata
+      *       For comment and pi nodes, this sets their text.
       *       For other types, this sets the cdata of the first cdata node.
       *       If none exists, then one is created called "cdata".
       */
       void setCdata(const std::string& cdata);
+
+#ifndef CPPDOM_NO_MEMBER_TEMPLATES
+      /**
+       * Reads the full cdata (see getFullCdata) as whitespace separated
+       * values. Separate cdata children (split by a comment, say) never run
+       * into one value. A single cdata child is parsed in place, without a
+       * copy.
+       *
+       * @return false if an element is not a valid T.
+       * @see parseArray
+       */
+      template<class T>
+      bool getCdataArray(std::vector<T>& values) const
+      {
+         std::string scratch;
+         return parseArray(getFullCdataRef(scratch, ' '), values);
+      }
+
+      /** Sets the cdata (see setCdata) to the values separated by spaces. */
+      template<class T>
+      void setCdataArray(const std::vector<T>& values)
+      {
+         std::string text;
+         formatArray(text, values);
+         setCdata(text);
+      }
+#endif // ! CPPDOM_NO_MEMBER_TEMPLATES
+
+      /**
+       * Decodes the full cdata (see getFullCdata) as base64 into data.
+       * Cdata set by setCdataBinary or decoded while parsing (see
+       * Context::addBase64Element) is copied without decoding.
+       *
+       * @return false if the text is not base64.
+       */
+      bool getCdataBinary(std::vector<unsigned char>& data) const;
+
+      /**
+       * Sets the cdata (see setCdata) to the base64 text of size bytes.
+       * The node keeps the bytes and makes the text only when it is asked
+       * for; save() encodes them straight into the stream.
+       */
+      void setCdataBinary(const void* data, std::size_t size);
       //@}
 
 
@@ -708,6 +1397,9 @@ namespace cppdom
       /** loads xml node from input stream */
       void load(std::istream& in, ContextPtr& context);
 
+      /** loads xml node from input stream, tracking the position in location */
+      void load(std::istream& in, ContextPtr& context, Location& location);
+
       /** saves node to xml output stream
       * @param indent - The amount to indent
       * @doIndent - If true, then indent the output
@@ -720,17 +1412,164 @@ namespace cppdom
       ContextPtr getContext();
 
    protected:
+      /** parses the content of a lazily loaded node (see lazy.h) before it is used */
+      void expand() const
+      {
+         if (mLazySource != NULL)
+         {  expandLazy(); }
+      }
+
+      /** parses the content of the node from mLazySource */
+      void expandLazy() const;
+
+      /** forgets the unparsed content, for content that is replaced as a whole */
+      void dropLazy();
+
+      /**
+       * Takes over the content and the children of node, leaving it empty;
+       * the moves are inline and built on this, whatever the language
+       * level of the library.
+       */
+      void takeContent(Node& node);
+
+      /** returns the document of our tree if it has attribute indexes, else NULL */
+      Document* getIndexedDocument();
+
+      /**
+       * Adds or removes the entries of node and its descendants in the
+       * attribute indexes of our document, for node joining or leaving
+       * our tree.
+       */
+      void indexSubtree(Node& node, bool add);
+
+      /**
+       * Adds or removes the index entries of our attributes, and those of
+       * our descendants if descendants is true, for content replaced while
+       * we keep our place in the tree.
+       */
+      void indexContent(bool add, bool descendants);
+
+      /** document order numbers of a tree, shared by its nodes */
+      struct OrderStamp;
+
+      /** returns true if mIndex is our position in the children of mParent */
+      bool checkIndex() const;
+
+      /** numbers the tree unless its numbers are up to date */
+      void checkOrder() const;
+
+      /** gives every node of the tree of our topmost ancestor its numbers */
+      void numberTree() const;
+
+      /** drops the numbers of the tree, for a change of its structure */
+      void invalidateOrder();
+
+      /** returns the first child at or after start with the given name */
+      NodeList::const_iterator findChild(const std::string& name,
+                                         NodeList::const_iterator start) const;
+
+      /** erases the removed children in [first, last) from the child list */
+      bool eraseChildren(NodeList::iterator first, NodeList::iterator last);
+
+      /**
+       * Returns the full cdata, referring to the node's own text where there
+       * is only one piece of it and building it in scratch otherwise.
+       * @param separator  put between the pieces unless it is '\0'
+       */
+      const std::string& getFullCdataRef(std::string& scratch, char separator) const;
+
+      /** ignore lists of isEqual() resolved for fast lookup */
+      struct EqualIgnores;
+
+      /** isEqual() with the ignore lists resolved */
+      bool isEqual(const Node& other, const EqualIgnores& ignores,
+                   bool dbgit, unsigned debugIndent) const;
+
+      // The small members fill the padding after mNodeNameHandle and mNodeType
       TagNameHandle  mNodeNameHandle;  /**< handle to the real tag name */
+      mutable unsigned mIndex;         /**< position in the children of mParent, checked on use */
 
 //#ifdef CPPDOM_DEBUG
       std::string    mNodeName_debug;  /**< The node name for debugging */
 //#endif
       ContextPtr     mContext;         /**< smart pointer to the context class */
       Node::Type     mNodeType;        /**< The type of the node */
+      bool           mCdataBinary;     /**< mCdata holds bytes, the text is their base64 */
+      mutable bool   mHashValid;       /**< mHash is up to date */
+      bool           mIndexed;         /**< in the tree of a Document with attribute indexes */
       Attributes     mAttributes;      /**< Attributes of the element */
       std::string    mCdata;           /**< Character data (if there is any) */
       NodeList       mNodeList;        /**< stl list with subnodes */
       Node*          mParent;          /**< Our parent */
+      mutable HashValue mHash;         /**< structural hash, see getHash() */
+      mutable LazySource* mLazySource; /**< unparsed content of the node, NULL once parsed */
+      std::size_t    mLazyIndex;       /**< element of the node in mLazySource */
+      mutable OrderStamp* mOrder;      /**< numbering of the tree, holds our numbers; or NULL */
+      mutable NodePathStep* mPathStep; /**< last step of the kept path, checked on use */
+   };
+
+
+   /**
+    * Path of a node from its topmost ancestor: for each node on the way its
+    * name handle and its position among the children of its parent. The
+    * positions tell apart siblings of the same name. Paths are compared and
+    * hashed without looking up names, so only paths of nodes sharing a
+    * context may be compared.
+    */
+   class CPPDOM_CLASS NodePath
+   {
+   public:
+      NodePath();
+      NodePath(const NodePath& other);
+      ~NodePath();
+      NodePath& operator=(const NodePath& other);
+
+      /** Returns the number of nodes on the path. */
+      std::size_t getLength() const;
+
+      /** Returns the name handle of the node at depth i, O(length - i). */
+      TagNameHandle getNameHandle(std::size_t i) const;
+
+      /** Returns the position of the node at depth i in its parent, O(length - i). */
+      unsigned getIndex(std::size_t i) const;
+
+      /** Adds a node below the last one; copies of the path do not change. */
+      void push(TagNameHandle name, unsigned index);
+
+      /** Removes all the nodes. */
+      void clear();
+
+      /** Returns a hash of the names and positions, kept up to date by push. */
+      Node::HashValue getHash() const;
+
+      /**
+       * Returns the path as names separated by '/', built in one pass.
+       * @param indices  adds the position to each name, as in "a[0]/b[2]"
+       */
+      std::string getString(const Context& context, bool indices = false) const;
+
+      bool operator==(const NodePath& other) const;
+
+      bool operator!=(const NodePath& other) const
+      {  return !(*this == other); }
+
+      /** orders paths by their nodes, for sorted containers */
+      bool operator<(const NodePath& other) const;
+
+   private:
+      friend class Node;
+
+      /** takes a reference to step, which may be NULL */
+      explicit NodePath(NodePathStep* step);
+
+      NodePathStep* mLast;  /**< last node, refers to those above; NULL if empty */
+   };
+
+   /** hash function object for keying hashed containers by NodePath */
+   struct NodePathHash
+   {
+      std::size_t operator()(const NodePath& path) const
+      {  return std::size_t(path.getHash()); }
    };
 
 
@@ -747,6 +1586,7 @@ namespace cppdom
    class CPPDOM_CLASS Document: public Node
    {
       friend class Parser;
+      friend class Node;
    public:
       Document();
 
@@ -767,6 +1607,12 @@ namespace cppdom
       /** loads xml Document (node) from input stream */
       void load(std::istream& in, ContextPtr& context);
 
+      /**
+       * loads xml Document (node) from input stream, tracking the position
+       * in location instead of the one of the context
+       */
+      void load(std::istream& in, ContextPtr& context, Location& location);
+
       /** saves node to xml output stream
       * @param doIndent - If true, then indent the output.
       * @param doNewline - If true, then use newlines in the output.
@@ -776,7 +1622,7 @@ namespace cppdom
       /**
        * \exception throws cppdom::Error when the file name is invalid.
        */
-      void loadFile(const std::string& filename) throw(Error);
+      void loadFile(const std::string& filename);
       void loadFileChecked(const std::string& filename);
 
       /** Save the document to the given filename.
@@ -784,6 +1630,70 @@ namespace cppdom
       */
       void saveFile(std::string filename);
 
+      /** @name binary snapshots (see binary.h) */
+      //@{
+      /** writes the document as a compact binary image */
+      void saveBinary(std::ostream& out);
+
+      /** writes the document as a compact binary image to the given file */
+      void saveBinaryFile(const std::string& filename);
+
+      /**
+       * replaces the content of the document with the one of a binary image
+       * \exception throws cppdom::Error when the image is malformed
+       */
+      void loadBinary(std::istream& in);
+
+      /** replaces the content of the document with the one of a mapped image */
+      void loadBinary(const BinaryDocument& image);
+
+      /**
+       * maps a binary image file and loads it
+       * \exception throws cppdom::Error when the file is invalid
+       */
+      void loadBinaryFile(const std::string& filename);
+
+      /**
+       * Returns an immutable, flattened copy of the document that can be
+       * queried (also concurrently) much faster than the node tree.
+       * @see FrozenDocument
+       */
+      FrozenDocumentPtr freeze();
+      //@}
+
+      /** @name attribute indexes */
+      //@{
+      /**
+       * Indexes the elements of the document by the value of the given
+       * attribute, replacing the index it already has for it. The index is
+       * kept up to date by setAttribute, addChild, removeChild and the
+       * other removals of children, assignment, patch, load and loadBinary.
+       * Changes made through attrib() or getChildren() are not seen; call
+       * buildIndex again after them. The indexes of a copy of the document
+       * find nothing, since the copy only shares the elements of the
+       * original.
+       */
+      void buildIndex(const std::string& attribute);
+
+      /** drops the index of the given attribute */
+      void dropIndex(const std::string& attribute);
+
+      /** returns true if the document has an index for the given attribute */
+      bool hasIndex(const std::string& attribute) const;
+
+      /**
+       * Returns the element whose attribute has the given value, NULL if
+       * there is none; one of them if several have it. O(depth) for the
+       * check that the element still has the value and is still in the
+       * document, which skips entries left behind by unseen changes.
+       * \exception throws cppdom::Error when the attribute has no index
+       */
+      NodePtr findByAttribute(const std::string& attribute, const std::string& value) const;
+
+      /** findByAttribute for the attribute "id" */
+      NodePtr findById(const std::string& value) const;
+      //@}
+
 
    protected:
       /** node list of parsed processing instructions */
@@ -791,6 +1701,35 @@ namespace cppdom
 
       /** node list of document type definition rules */
       NodeList mDtdRules;
+
+      /** elements by the value of one attribute */
+      struct AttributeIndex
+      {
+         explicit AttributeIndex(const std::string& attribute)
+            : mAttribute(attribute)
+         {}
+
+         std::string mAttribute;        /**< the indexed attribute */
+         AttributeIndexMap_t mEntries;  /**< value to element */
+      };
+
+      /** returns the index of the attribute, NULL if there is none */
+      const AttributeIndex* findIndex(const std::string& attribute) const;
+
+      /** returns true if node has the value for attribute and is in our tree */
+      bool holdsEntry(const Node& node, const std::string& attribute,
+                      const std::string& value) const;
+
+      /** adds or removes the entries of node in all indexes; its parent or the caller must hold it */
+      void indexNode(Node& node, bool add);
+
+      /** adds or removes the entries of node and its descendants, marking them as indexed or not */
+      void indexTree(Node& node, bool add);
+
+      /** fills all indexes again from the whole document */
+      void rebuildIndexes();
+
+      std::vector<AttributeIndex> mIndexes;  /**< see buildIndex */
    };
 
    /** Interface for xml parsing event handler */
@@ -828,6 +1767,43 @@ namespace cppdom
       { cppdom::ignore_unused_variable_warning(cdata); }
    };
 
+   /** Decides which elements are parsed, see Context::setElementFilter */
+   class CPPDOM_CLASS ElementFilter
+   {
+   public:
+      virtual ~ElementFilter() {}
+
+      /**
+       * called when the name of an element has been read.
+       * @param path     handles of the names of the element and of its
+       *                 ancestors, the root element first; the depth of
+       *                 the element is path.size()
+       * @param context  context the handles belong to (see Context::getTagname)
+       * @return false to skip the element and everything in it; the
+       *         root element (path.size() == 1) cannot be skipped
+       */
+      virtual bool keepElement(const std::vector<TagNameHandle>& path, const Context& context) = 0;
+   };
+
+   /**
+    * Keeps the elements on the given paths: their ancestors, themselves
+    * and all their content. The ancestors keep their text, their other
+    * child elements are skipped.
+    */
+   class CPPDOM_CLASS PathFilter : public ElementFilter
+   {
+   public:
+      PathFilter();
+
+      /** adds a path of element names from the root, such as "config/render" */
+      void addPath(const std::string& path);
+
+      virtual bool keepElement(const std::vector<TagNameHandle>& path, const Context& context);
+
+   protected:
+      std::vector<std::vector<std::string> > mPaths;  /**< names along each path */
+   };
+
 
    // ----------------------------------- //
    /** @name Helper methods */
@@ -836,6 +1812,7 @@ namespace cppdom
     * @param fromNode   Node to read data from.
     * @param toNode     Node to merge data onto.
     * @post All elements and attributes in fromNode will exist in toNode.
+    * @see merge.h for matching by key attributes and other policies
     */
    CPPDOM_EXPORT(void) merge(NodePtr fromNode, NodePtr toNode);
    //@}
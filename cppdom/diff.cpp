@@ -0,0 +1,826 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file diff.cpp
+
+  edit scripts between two trees
+
+*/
+
+#include <algorithm>
+#include <utility>
+
+#include <cppdom/diff.h>
+
+namespace cppdom
+{
+   // Edit methods
+
+   Edit::Edit(Type type, const Path& path)
+      : mType(type), mPath(path), mIndex(0), mTarget(0)
+   {}
+
+   Edit Edit::insertNode(const Path& parent, unsigned index, NodePtr node)
+   {
+      Edit edit(xml_edit_insert, parent);
+      edit.mIndex = index;
+      edit.mNode = node;
+      return edit;
+   }
+
+   Edit Edit::deleteNode(const Path& parent, unsigned index)
+   {
+      Edit edit(xml_edit_delete, parent);
+      edit.mIndex = index;
+      return edit;
+   }
+
+   Edit Edit::moveNode(const Path& parent, unsigned index, unsigned target)
+   {
+      Edit edit(xml_edit_move, parent);
+      edit.mIndex = index;
+      edit.mTarget = target;
+      return edit;
+   }
+
+   Edit Edit::replaceNode(const Path& path, NodePtr node)
+   {
+      Edit edit(xml_edit_replace, path);
+      edit.mNode = node;
+      return edit;
+   }
+
+   Edit Edit::setAttribute(const Path& path, const std::string& name,
+                           const std::string& value)
+   {
+      Edit edit(xml_edit_set_attribute, path);
+      edit.mName = name;
+      edit.mValue = value;
+      return edit;
+   }
+
+   Edit Edit::removeAttribute(const Path& path, const std::string& name)
+   {
+      Edit edit(xml_edit_remove_attribute, path);
+      edit.mName = name;
+      return edit;
+   }
+
+   Edit Edit::setCdata(const Path& path, const std::string& cdata)
+   {
+      Edit edit(xml_edit_set_cdata, path);
+      edit.mValue = cdata;
+      return edit;
+   }
+
+   Edit::Type Edit::getType() const
+   {
+      return mType;
+   }
+
+   const Edit::Path& Edit::getPath() const
+   {
+      return mPath;
+   }
+
+   unsigned Edit::getIndex() const
+   {
+      return mIndex;
+   }
+
+   unsigned Edit::getTarget() const
+   {
+      return mTarget;
+   }
+
+   const std::string& Edit::getName() const
+   {
+      return mName;
+   }
+
+   const std::string& Edit::getValue() const
+   {
+      return mValue;
+   }
+
+   NodePtr Edit::getNode() const
+   {
+      return mNode;
+   }
+
+
+   namespace
+   {
+      const std::string& nameOf(const NodePtr& node)
+      {
+         return node->getContext()->getTagname(node->getNameHandle());
+      }
+
+      /** cdata, comment and pi nodes are compared by their text */
+      bool hasText(const NodePtr& node)
+      {
+         const Node::Type type = node->getType();
+         return type == Node::xml_nt_cdata || type == Node::xml_nt_comment ||
+                type == Node::xml_nt_pi;
+      }
+
+
+      /** order of a child list under edit, as indices into a pool of nodes
+       *
+       * The indices are kept in blocks of a bounded size so that inserting
+       * or erasing at a position costs about the square root of the length
+       * rather than the length, which keeps long runs of moves affordable.
+       */
+      class ChildOrder
+      {
+      public:
+         explicit ChildOrder(unsigned count)
+            : mSize(count)
+         {
+            for (unsigned i = 0; i < count; i += BlockSize)
+            {
+               mBlocks.push_back(std::vector<unsigned>());
+               std::vector<unsigned>& block = mBlocks.back();
+               for (unsigned j = i; j < count && j < i + BlockSize; ++j)
+               {  block.push_back(j); }
+            }
+            if (mBlocks.empty())
+            {  mBlocks.push_back(std::vector<unsigned>()); }
+         }
+
+         unsigned size() const
+         {
+            return mSize;
+         }
+
+         unsigned erase(unsigned pos)
+         {
+            unsigned b = locate(pos);
+            std::vector<unsigned>& block = mBlocks[b];
+            unsigned value = block[pos];
+            block.erase(block.begin() + pos);
+            if (block.empty() && mBlocks.size() > 1)
+            {  mBlocks.erase(mBlocks.begin() + b); }
+            --mSize;
+            return value;
+         }
+
+         void insert(unsigned pos, unsigned value)
+         {
+            unsigned b = (pos == mSize) ? unsigned(mBlocks.size() - 1) : locate(pos);
+            if (pos == mSize)
+            {  pos = unsigned(mBlocks[b].size()); }
+            std::vector<unsigned>& block = mBlocks[b];
+            block.insert(block.begin() + pos, value);
+            if (block.size() > 2 * BlockSize)
+            {
+               std::vector<unsigned> tail(block.begin() + BlockSize, block.end());
+               block.resize(BlockSize);
+               mBlocks.insert(mBlocks.begin() + b + 1, tail);
+            }
+            ++mSize;
+         }
+
+         void values(std::vector<unsigned>& out) const
+         {
+            out.clear();
+            out.reserve(mSize);
+            for (unsigned b = 0; b < mBlocks.size(); ++b)
+            {  out.insert(out.end(), mBlocks[b].begin(), mBlocks[b].end()); }
+         }
+
+      private:
+         enum { BlockSize = 256 };
+
+         /** block holding pos, leaving pos as the offset within it */
+         unsigned locate(unsigned& pos) const
+         {
+            unsigned b = 0;
+            while (pos >= mBlocks[b].size())
+            {
+               pos -= unsigned(mBlocks[b].size());
+               ++b;
+            }
+            return b;
+         }
+
+         std::vector<std::vector<unsigned> > mBlocks;
+         unsigned mSize;
+      };
+
+      bool isChildEdit(const Edit& edit)
+      {
+         return edit.getType() == Edit::xml_edit_insert ||
+                edit.getType() == Edit::xml_edit_delete ||
+                edit.getType() == Edit::xml_edit_move;
+      }
+   }
+
+   /** changes to nodes that the public Node interface does not offer */
+   class Patcher
+   {
+   public:
+      /** applies a run of insert, delete and move edits to the children of parent
+       *
+       * Edits up to a failing one stay applied, as with the other edits.
+       */
+      static void applyChildEdits(Node& parent, EditScript::const_iterator first,
+                                  EditScript::const_iterator last)
+      {
+         parent.expand();
+         NodeList pool(parent.mNodeList);
+         ChildOrder order(unsigned(pool.size()));
+         bool inserted = false;
+         try
+         {
+            for (EditScript::const_iterator e = first; e != last; ++e)
+            {
+               switch (e->getType())
+               {
+               case Edit::xml_edit_insert:
+                  if (e->getIndex() > order.size() || e->getNode().get() == NULL)
+                  {  throw CPPDOM_ERROR(xml_invalid_argument, "Insert edit does not fit the tree"); }
+                  pool.push_back(e->getNode()->clone(true, parent.getContext()));
+                  order.insert(e->getIndex(), unsigned(pool.size() - 1));
+                  inserted = true;
+                  break;
+
+               case Edit::xml_edit_delete:
+                  if (e->getIndex() >= order.size())
+                  {  throw CPPDOM_ERROR(xml_invalid_argument, "Delete edit does not fit the tree"); }
+                  order.erase(e->getIndex());
+                  break;
+
+               default:
+                  if (e->getIndex() >= order.size() || e->getTarget() >= order.size())
+                  {  throw CPPDOM_ERROR(xml_invalid_argument, "Move edit does not fit the tree"); }
+                  order.insert(e->getTarget(), order.erase(e->getIndex()));
+                  break;
+               }
+            }
+         }
+         catch (...)
+         {
+            setChildren(parent, pool, order, inserted);
+            throw;
+         }
+         setChildren(parent, pool, order, inserted);
+      }
+
+      /** gives node the content of source, leaving its place in the tree */
+      static void replaceContent(Node& node, Node& source)
+      {
+         node.dropLazy();
+         node.indexContent(false, true);
+         for (NodeList::iterator i = node.mNodeList.begin(); i != node.mNodeList.end(); ++i)
+         {  (*i)->mParent = NULL; }
+         node.mNodeList.swap(source.mNodeList);
+         for (NodeList::iterator i = node.mNodeList.begin(); i != node.mNodeList.end(); ++i)
+         {
+            (*i)->mParent = &node;
+            (*i)->mIndex = unsigned(i - node.mNodeList.begin());
+         }
+         node.mNodeNameHandle = source.mNodeNameHandle;
+         node.mNodeType = source.mNodeType;
+         node.mAttributes.swap(source.mAttributes);
+         node.mCdata.swap(source.mCdata);
+         std::swap(node.mCdataBinary, source.mCdataBinary);
+         node.invalidateHash();
+         node.invalidateOrder();
+         node.indexContent(true, true);
+      }
+
+      /** removes an attribute of node, keeping the indexes of its document */
+      static void removeAttribute(Node& node, const std::string& name)
+      {
+         node.indexContent(false, false);
+         node.mAttributes.erase(name);
+         node.indexContent(true, false);
+         node.invalidateHash();
+      }
+
+      /** drops the kept structural hashes of node and all its descendants */
+      static void dropHashes(Node& node)
+      {
+         node.invalidateHash();
+         std::vector<Node*> pending(1, &node);
+         while (!pending.empty())
+         {
+            Node* n = pending.back();
+            pending.pop_back();
+            n->mHashValid = false;
+            for (NodeList::iterator i = n->mNodeList.begin(); i != n->mNodeList.end(); ++i)
+            {  pending.push_back(i->get()); }
+         }
+      }
+
+   private:
+      static void setChildren(Node& parent, const NodeList& pool, const ChildOrder& order,
+                              bool inserted)
+      {
+         std::vector<unsigned> indices;
+         order.values(indices);
+         NodeList children;
+         children.reserve(indices.size());
+         for (NodeList::iterator i = parent.mNodeList.begin(); i != parent.mNodeList.end(); ++i)
+         {  (*i)->mParent = NULL; }
+         for (std::vector<unsigned>::const_iterator i = indices.begin(); i != indices.end(); ++i)
+         {
+            children.push_back(pool[*i]);
+            children.back()->mParent = &parent;
+            children.back()->mIndex = unsigned(children.size() - 1);
+         }
+         // a leaf is saved without its children
+         if (inserted && parent.mNodeType == Node::xml_nt_leaf)
+         {  parent.mNodeType = Node::xml_nt_node; }
+         parent.mNodeList.swap(children);
+         parent.invalidateHash();
+         parent.invalidateOrder();
+
+         // The pool starts with the old children, now in children; the
+         // indexes drop those that left and take those that came
+         std::vector<bool> placed(pool.size(), false);
+         for (std::vector<unsigned>::const_iterator i = indices.begin(); i != indices.end(); ++i)
+         {  placed[*i] = true; }
+         for (std::size_t i = 0; i < pool.size(); ++i)
+         {
+            if (placed[i] != (i < children.size()))
+            {  parent.indexSubtree(*pool[i], placed[i]); }
+         }
+      }
+   };
+
+   namespace
+   {
+      /** children of a node that are still to be matched, by some key */
+      template<class Key>
+      class MatchIndex
+      {
+      public:
+         void add(const Key& key, unsigned index)
+         {  mEntries.push_back(Entry(key, index)); }
+
+         void build()
+         {
+            std::sort(mEntries.begin(), mEntries.end());
+            mNext.resize(mEntries.size());
+            for (std::size_t i = 0; i < mNext.size(); ++i)
+            {  mNext[i] = i; }
+         }
+
+         /**
+          * Takes the first index (in document order) not taken yet for key.
+          * @return false if there is none
+          */
+         bool take(const Key& key, unsigned& index)
+         {
+            typename std::vector<Entry>::iterator group =
+               std::lower_bound(mEntries.begin(), mEntries.end(), Entry(key, 0));
+            if (group == mEntries.end() || !(group->first == key))
+            {  return false; }
+
+            std::size_t& next = mNext[group - mEntries.begin()];
+            if (next == mEntries.size() || !(mEntries[next].first == key))
+            {  return false; }
+            index = mEntries[next].second;
+            ++next;
+            return true;
+         }
+
+      private:
+         typedef std::pair<Key, unsigned> Entry;
+
+         std::vector<Entry>         mEntries;
+         std::vector<std::size_t>   mNext;    /**< next entry to take, per group */
+      };
+
+      /** what matches children that are not identical: cdata-ness and name */
+      struct NameKey
+      {
+         NameKey(bool cdata, const std::string* name)
+            : mCdata(cdata), mName(name)
+         {}
+
+         bool operator<(const NameKey& rhs) const
+         {
+            if (mCdata != rhs.mCdata)
+            {  return mCdata < rhs.mCdata; }
+            return *mName < *rhs.mName;
+         }
+
+         bool operator==(const NameKey& rhs) const
+         {  return mCdata == rhs.mCdata && *mName == *rhs.mName; }
+
+         bool               mCdata;
+         const std::string* mName;
+      };
+
+      /**
+       * Marks the elements of the longest increasing subsequence of values
+       * (patience sorting).
+       */
+      std::vector<bool> longestIncreasing(const std::vector<unsigned>& values)
+      {
+         std::vector<std::size_t> tails;      // index of the smallest tail of each length
+         std::vector<std::size_t> previous(values.size());
+         for (std::size_t i = 0; i < values.size(); ++i)
+         {
+            std::size_t lo = 0, hi = tails.size();
+            while (lo < hi)
+            {
+               const std::size_t mid = (lo + hi) / 2;
+               if (values[tails[mid]] < values[i])
+               {  lo = mid + 1; }
+               else
+               {  hi = mid; }
+            }
+            previous[i] = (lo > 0) ? tails[lo - 1] : values.size();
+            if (lo == tails.size())
+            {  tails.push_back(i); }
+            else
+            {  tails[lo] = i; }
+         }
+
+         std::vector<bool> in_sequence(values.size(), false);
+         if (!tails.empty())
+         {
+            for (std::size_t i = tails.back(); i != values.size(); i = previous[i])
+            {  in_sequence[i] = true; }
+         }
+         return in_sequence;
+      }
+
+      /** orders the children of a node while diffChildren() rearranges them */
+      struct SortKey
+      {
+         SortKey(unsigned anchor, unsigned stationary, unsigned index)
+            : mAnchor(anchor), mStationary(stationary), mIndex(index)
+         {}
+
+         bool operator<(const SortKey& rhs) const
+         {
+            if (mAnchor != rhs.mAnchor)
+            {  return mAnchor < rhs.mAnchor; }
+            if (mStationary != rhs.mStationary)
+            {  return mStationary < rhs.mStationary; }
+            return mIndex < rhs.mIndex;
+         }
+
+         unsigned mAnchor;       /**< a index of the child, or of the one it is placed before */
+         unsigned mStationary;   /**< 1 while a child is where it was in a */
+         unsigned mIndex;        /**< b index of a placed child */
+      };
+
+      /** counts the present keys in front of a key (a Fenwick tree) */
+      class PositionCounter
+      {
+      public:
+         explicit PositionCounter(std::vector<SortKey>& keys)
+            : mKeys(keys), mCounts(keys.size() + 1, 0)
+         {
+            std::sort(mKeys.begin(), mKeys.end());
+         }
+
+         void add(const SortKey& key)
+         {  update(key, 1); }
+
+         void remove(const SortKey& key)
+         {  update(key, -1); }
+
+         /** number of present keys before key */
+         unsigned rank(const SortKey& key) const
+         {
+            int count = 0;
+            for (std::size_t i = slot(key); i > 0; i -= i & (~i + 1))
+            {  count += mCounts[i]; }
+            return unsigned(count);
+         }
+
+      private:
+         std::size_t slot(const SortKey& key) const
+         {  return std::lower_bound(mKeys.begin(), mKeys.end(), key) - mKeys.begin(); }
+
+         void update(const SortKey& key, int delta)
+         {
+            for (std::size_t i = slot(key) + 1; i < mCounts.size(); i += i & (~i + 1))
+            {  mCounts[i] += delta; }
+         }
+
+         std::vector<SortKey>& mKeys;
+         std::vector<int>      mCounts;
+      };
+
+      class Differ
+      {
+      public:
+         explicit Differ(EditScript& script)
+            : mScript(script)
+         {}
+
+         /** a and b have the same name and are both have text (cdata, comment, pi) or both not */
+         void diffNodes(const NodePtr& a, const NodePtr& b, Edit::Path& path)
+         {
+            if (a->getHash() == b->getHash() && a->isEqual(b))
+            {  return; }
+
+            const Node& const_a = *a;
+            const Node& const_b = *b;
+            diffAttributes(const_a.attrib(), const_b.attrib(), path);
+            if (hasText(a))
+            {
+               const std::string cdata(b->getCdata());
+               if (a->getCdata() != cdata)
+               {  mScript.push_back(Edit::setCdata(path, cdata)); }
+            }
+            diffChildren(a, b, path);
+         }
+
+      private:
+         void diffAttributes(const Attributes& a, const Attributes& b, const Edit::Path& path)
+         {
+            // both maps are sorted by name
+            Attributes::const_iterator i = a.begin(), j = b.begin();
+            while (i != a.end() || j != b.end())
+            {
+               if (j == b.end() || (i != a.end() && i->first < j->first))
+               {
+                  mScript.push_back(Edit::removeAttribute(path, i->first));
+                  ++i;
+               }
+               else if (i == a.end() || j->first < i->first)
+               {
+                  mScript.push_back(Edit::setAttribute(path, j->first, j->second.getString()));
+                  ++j;
+               }
+               else
+               {
+                  if (i->second.getString() != j->second.getString())
+                  {  mScript.push_back(Edit::setAttribute(path, j->first, j->second.getString())); }
+                  ++i;
+                  ++j;
+               }
+            }
+         }
+
+         void diffChildren(const NodePtr& a, const NodePtr& b, Edit::Path& path)
+         {
+            const NodeList& a_children = static_cast<const Node&>(*a).getChildren();
+            const NodeList& b_children = static_cast<const Node&>(*b).getChildren();
+            const unsigned na = unsigned(a_children.size());
+            const unsigned nb = unsigned(b_children.size());
+            const unsigned none = na;
+
+            std::vector<unsigned> match(nb, none);    // a child matched to each b child
+            std::vector<bool> identical(nb, false);
+            std::vector<bool> a_used(na, false);
+
+            // Identical subtrees first, the hash finds them and a comparison
+            // rules out collisions
+            MatchIndex<Node::HashValue> by_hash;
+            for (unsigned i = 0; i < na; ++i)
+            {  by_hash.add(a_children[i]->getHash(), i); }
+            by_hash.build();
+            for (unsigned j = 0; j < nb; ++j)
+            {
+               unsigned i;
+               if (by_hash.take(b_children[j]->getHash(), i) &&
+                   a_children[i]->isEqual(b_children[j]))
+               {
+                  match[j] = i;
+                  identical[j] = true;
+                  a_used[i] = true;
+               }
+            }
+
+            // Then the rest by name, in order
+            MatchIndex<NameKey> by_name;
+            for (unsigned i = 0; i < na; ++i)
+            {
+               if (!a_used[i])
+               {  by_name.add(NameKey(hasText(a_children[i]), &nameOf(a_children[i])), i); }
+            }
+            by_name.build();
+            for (unsigned j = 0; j < nb; ++j)
+            {
+               unsigned i;
+               if (match[j] == none &&
+                   by_name.take(NameKey(hasText(b_children[j]), &nameOf(b_children[j])), i))
+               {
+                  match[j] = i;
+                  a_used[i] = true;
+               }
+            }
+
+            // Delete the unmatched, from the back so the indices stay valid
+            for (unsigned i = na; i-- > 0; )
+            {
+               if (!a_used[i])
+               {  mScript.push_back(Edit::deleteNode(path, i)); }
+            }
+
+            // The matched children that keep their order stay; the others
+            // are moved, and new ones inserted, right to left in front of
+            // the child that follows them in b.
+            std::vector<unsigned> order;              // a index of each matched b child
+            for (unsigned j = 0; j < nb; ++j)
+            {
+               if (match[j] != none)
+               {  order.push_back(match[j]); }
+            }
+            const std::vector<bool> stays = longestIncreasing(order);
+
+            // A child placed in front of the next one ends up in front of
+            // the first staying child after it in b (or at the end), and
+            // behind the children placed there before it. Together with
+            // the original order of the children not moved yet, that
+            // gives every child a fixed sort key, so positions can be
+            // counted in a Fenwick tree instead of searched for.
+            std::vector<unsigned> terminator(nb + 1, na);
+            std::vector<bool> b_stays(nb, false);
+            {
+               std::size_t m = 0;
+               for (unsigned j = 0; j < nb; ++j)
+               {
+                  if (match[j] != none)
+                  {  b_stays[j] = stays[m++]; }
+               }
+               for (unsigned j = nb; j-- > 0; )
+               {  terminator[j] = b_stays[j] ? match[j] : terminator[j + 1]; }
+            }
+
+            std::vector<SortKey> keys;
+            for (unsigned i = 0; i < na; ++i)
+            {
+               if (a_used[i])
+               {  keys.push_back(SortKey(i, 1, 0)); }
+            }
+            for (unsigned j = 0; j < nb; ++j)
+            {
+               if (!b_stays[j])
+               {  keys.push_back(SortKey(terminator[j + 1], 0, j)); }
+            }
+            PositionCounter positions(keys);
+            for (unsigned i = 0; i < na; ++i)
+            {
+               if (a_used[i])
+               {  positions.add(SortKey(i, 1, 0)); }
+            }
+
+            for (unsigned j = nb; j-- > 0; )
+            {
+               if (b_stays[j])
+               {  continue; }
+
+               const SortKey placed(terminator[j + 1], 0, j);
+               if (match[j] != none)
+               {
+                  const SortKey original(match[j], 1, 0);
+                  const unsigned from = positions.rank(original);
+                  positions.remove(original);
+                  const unsigned to = positions.rank(placed);
+                  positions.add(placed);
+                  mScript.push_back(Edit::moveNode(path, from, to));
+               }
+               else
+               {
+                  const unsigned to = positions.rank(placed);
+                  positions.add(placed);
+                  mScript.push_back(Edit::insertNode(path, to, b_children[j]->clone()));
+               }
+            }
+
+            // The children are in b's order now, compare the changed ones
+            for (unsigned j = 0; j < nb; ++j)
+            {
+               if (match[j] != none && !identical[j])
+               {
+                  path.push_back(j);
+                  diffNodes(a_children[match[j]], b_children[j], path);
+                  path.pop_back();
+               }
+            }
+         }
+
+         EditScript& mScript;
+      };
+
+      /** the node a path leads to from root */
+      NodePtr resolve(const NodePtr& root, const Edit::Path& path)
+      {
+         NodePtr node = root;
+         for (Edit::Path::const_iterator i = path.begin(); i != path.end(); ++i)
+         {
+            NodeList& children = node->getChildren();
+            if (*i >= children.size())
+            {  throw CPPDOM_ERROR(xml_invalid_argument, "Edit path does not fit the tree"); }
+            node = children[*i];
+         }
+         return node;
+      }
+   }
+
+   EditScript diff(NodePtr a, NodePtr b)
+   {
+      // Kept hashes may predate edits made through references
+      Patcher::dropHashes(*a);
+      Patcher::dropHashes(*b);
+
+      EditScript script;
+      Edit::Path path;
+      if (hasText(a) != hasText(b) || nameOf(a) != nameOf(b))
+      {
+         script.push_back(Edit::replaceNode(path, b->clone()));
+      }
+      else
+      {
+         Differ differ(script);
+         differ.diffNodes(a, b, path);
+      }
+      return script;
+   }
+
+   void patch(NodePtr tree, const EditScript& script)
+   {
+      EditScript::const_iterator e = script.begin();
+      while (e != script.end())
+      {
+         NodePtr node = resolve(tree, e->getPath());
+
+         // consecutive changes to one child list are applied together
+         if (isChildEdit(*e))
+         {
+            EditScript::const_iterator last = e;
+            while (last != script.end() && isChildEdit(*last) && last->getPath() == e->getPath())
+            {  ++last; }
+            Patcher::applyChildEdits(*node, e, last);
+            e = last;
+            continue;
+         }
+
+         switch (e->getType())
+         {
+         case Edit::xml_edit_replace:
+            {
+               if (e->getNode().get() == NULL)
+               {  throw CPPDOM_ERROR(xml_invalid_argument, "Replace edit without a node"); }
+               NodePtr copy = e->getNode()->clone(true, node->getContext());
+               Patcher::replaceContent(*node, *copy);
+            }
+            break;
+
+         case Edit::xml_edit_set_attribute:
+            node->setAttribute(e->getName(), Attribute(e->getValue()));
+            break;
+
+         case Edit::xml_edit_remove_attribute:
+            Patcher::removeAttribute(*node, e->getName());
+            break;
+
+         case Edit::xml_edit_set_cdata:
+            if (!hasText(node))
+            {  throw CPPDOM_ERROR(xml_invalid_argument, "Cdata edit of a node that is not cdata"); }
+            node->setCdata(e->getValue());
+            break;
+
+         default:
+            throw CPPDOM_ERROR(xml_invalid_argument, "Unknown edit type");
+         }
+         ++e;
+      }
+   }
+}
@@ -0,0 +1,155 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file diff.h
+
+  edit scripts between two trees
+
+*/
+
+// prevent multiple includes
+#ifndef CPPDOM_DIFF_H
+#define CPPDOM_DIFF_H
+
+// needed includes
+#include <string>
+#include <vector>
+
+#include <cppdom/cppdom.h>
+
+// namespace declaration
+namespace cppdom
+{
+   /**
+    * One step of an edit script made by diff().
+    *
+    * Nodes are addressed by the indices of the children leading to them
+    * from the root the script applies to; an empty path is the root. The
+    * path is taken when the edit is applied, after the edits before it.
+    */
+   class CPPDOM_CLASS Edit
+   {
+   public:
+      /** kinds of edits */
+      enum Type
+      {
+         xml_edit_insert,           /**< inserts getNode() as child getIndex() */
+         xml_edit_delete,           /**< removes child getIndex() */
+         xml_edit_move,             /**< moves child getIndex() to getTarget() */
+         xml_edit_replace,          /**< replaces the node by getNode() */
+         xml_edit_set_attribute,    /**< sets attribute getName() to getValue() */
+         xml_edit_remove_attribute, /**< removes attribute getName() */
+         xml_edit_set_cdata         /**< sets the text of a cdata, comment or pi node to getValue() */
+      };
+
+      typedef std::vector<unsigned> Path;
+
+      /** @name creation */
+      //@{
+      static Edit insertNode(const Path& parent, unsigned index, NodePtr node);
+      static Edit deleteNode(const Path& parent, unsigned index);
+      /** target is the index of the child after the move */
+      static Edit moveNode(const Path& parent, unsigned index, unsigned target);
+      static Edit replaceNode(const Path& path, NodePtr node);
+      static Edit setAttribute(const Path& path, const std::string& name,
+                               const std::string& value);
+      static Edit removeAttribute(const Path& path, const std::string& name);
+      static Edit setCdata(const Path& path, const std::string& cdata);
+      //@}
+
+      Type getType() const;
+
+      /** the node edited, the parent for insert, delete and move */
+      const Path& getPath() const;
+
+      /** the child inserted, deleted or moved */
+      unsigned getIndex() const;
+
+      /** where a moved child ends up */
+      unsigned getTarget() const;
+
+      /** the attribute name */
+      const std::string& getName() const;
+
+      /** the attribute value or cdata text */
+      const std::string& getValue() const;
+
+      /** the subtree inserted or replacing a node */
+      NodePtr getNode() const;
+
+   protected:
+      Edit(Type type, const Path& path);
+
+      Type        mType;
+      Path        mPath;
+      unsigned    mIndex;
+      unsigned    mTarget;
+      std::string mName;
+      std::string mValue;
+      NodePtr     mNode;
+   };
+
+   typedef std::vector<Edit> EditScript;
+
+   /**
+    * Returns the edits that turn the tree a into the tree b.
+    *
+    * Children are matched by their structural hash first (see
+    * Node::getHash), confirmed by comparing them, so unchanged subtrees
+    * produce no edits and moved ones become single move edits. Remaining children are matched
+    * by name, in order, and compared recursively; the rest are deleted
+    * or inserted. Subtrees that are inserted are copies, the script does
+    * not refer to b.
+    *
+    * @note Computes the structural hashes of both trees afresh, dropping
+    *       any they kept, and keeps them.
+    */
+   CPPDOM_EXPORT(EditScript) diff(NodePtr a, NodePtr b);
+
+   /**
+    * Applies an edit script to a tree, turning a tree equal to the one
+    * the script was made from into one equal to its target. Inserted
+    * subtrees are copied into the context of the tree.
+    *
+    * \exception throws cppdom::Error with xml_invalid_argument when an
+    *            edit does not fit the tree; the edits before it stay applied
+    */
+   CPPDOM_EXPORT(void) patch(NodePtr tree, const EditScript& script);
+}
+
+#endif
@@ -29,14 +29,16 @@ public:
     * @example  int value = opts.getValue<int>("group/mine/option");
     * @param option  Option identifier of same form as for getOptionString.
     * @return  If option does not exist, throws error.
-    * @note Requires a stream operation of type T
+    * @note Uses cppdom::parseValue, so T needs a stream operator unless it
+    *       is a number or bool. A value that is not a valid T is read the
+    *       way operator>> reads it, like Attribute::getValue.
     */
    template<class T>
    T getValue(std::string option, const T defaultVal = T())
    {
       T t = defaultVal;
       std::string str_val = getOptionString(option);
-      if(!str_val.empty())
+      if(!str_val.empty() && !cppdom::parseValue(str_val, t))
       {
          std::istringstream iss(str_val);
          iss >> t;
@@ -56,14 +58,14 @@ public:
 
    /**
     * Set mData to the string value of val
-    * @note Requires a stream operation of type T
+    * @note Uses cppdom::formatValue, so T needs a stream operator unless it
+    *       is a number or bool
     */
    template<class T>
    void setValue(std::string option, const T& val)
    {
-      std::ostringstream oss;
-      oss << val;
-      std::string str_val = oss.str();
+      std::string str_val;
+      cppdom::formatValue(str_val, val);
       setOptionString(option, str_val);
    }
 
@@ -0,0 +1,341 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/*! \file lazy.cpp
+
+  loading documents whose nodes are parsed when they are first used
+
+*/
+
+// needed includes
+#include <cstring>
+#include <fstream>
+
+#include <cppdom/lazy.h>
+#include <cppdom/memscan.h>
+#include <cppdom/xmlparser.h>
+
+// namespace declaration
+namespace cppdom
+{
+   namespace
+   {
+      using scan::ChunkStreamBuf;
+      using scan::isNameEnd;
+      using scan::skipPast;
+      using scan::findTagEnd;
+
+      inline bool isSpace(char c)
+      {
+         return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+      }
+
+      /** keeps a source alive while it is being loaded */
+      class SourceRef
+      {
+      public:
+         explicit SourceRef(LazySource* source)
+            : mSource(source)
+         {  mSource->acquire(); }
+
+         ~SourceRef()
+         {  mSource->release(); }
+
+         LazySource* operator->() const
+         {  return mSource; }
+
+      private:
+         SourceRef(const SourceRef&);
+         SourceRef& operator=(const SourceRef&);
+
+         LazySource* mSource;
+      };
+   }
+
+   // LazySource methods
+
+   LazySource::LazySource()
+      : mRefs(0)
+   {}
+
+   void LazySource::acquire()
+   {
+      mRefs.fetchAdd(1);
+   }
+
+   void LazySource::release()
+   {
+      if (mRefs.fetchAdd(-1) == 1)
+      {  delete this; }
+   }
+
+   std::string& LazySource::getText()
+   {
+      return mText;
+   }
+
+   const std::vector<LazySource::Element>& LazySource::getElements() const
+   {
+      return mElements;
+   }
+
+   bool LazySource::isLeaf(const Element& element) const
+   {
+      return mText[element.mTagEnd - 1] == '/';
+   }
+
+   const char* LazySource::nameEnd(std::size_t begin) const
+   {
+      const char* name = mText.data() + begin + 1;
+      const char* end = mText.data() + mText.size();
+      while (name < end && !isNameEnd(*name))
+      {  ++name; }
+      return name;
+   }
+
+   bool LazySource::hasAttributes(const Element& element) const
+   {
+      const char* p = nameEnd(element.mBegin);
+      const char* tag_end = mText.data() + element.mTagEnd;
+      while (p != tag_end && (isSpace(*p) || *p == '/'))
+      {  ++p; }
+      return p != tag_end;
+   }
+
+   std::string LazySource::getName(const Element& element) const
+   {
+      return std::string(mText.data() + element.mBegin + 1, nameEnd(element.mBegin));
+   }
+
+   bool LazySource::scan()
+   {
+      mElements.clear();
+      const char* begin = mText.data();
+      const char* end = begin + mText.size();
+      std::vector<std::size_t> open;   // indices of the unclosed elements
+      const char* p = begin;
+      while (true)
+      {
+         p = static_cast<const char*>(std::memchr(p, '<', end - p));
+         if (p == NULL || end - p < 2)
+         {  return false; }
+
+         if (p[1] == '?')
+         {  p = skipPast(p + 2, end, "?>"); }
+         else if (p[1] == '!' && end - p >= 4 && p[2] == '-' && p[3] == '-')
+         {  p = skipPast(p + 4, end, "-->"); }
+         else if (p[1] == '!' && end - p >= 9 && std::memcmp(p + 2, "[CDATA[", 7) == 0)
+         {  p = skipPast(p + 9, end, "]]>"); }
+         else if (p[1] == '!')
+         {
+            // Doctype or other declaration; must be in the prolog
+            if (!open.empty() || !mElements.empty())
+            {  return false; }
+            p = skipPast(p + 2, end, ">");
+         }
+         else if (p[1] == '/')
+         {
+            const char* tag_end = findTagEnd(p, end);
+            if (tag_end == NULL || open.empty())
+            {  return false; }
+
+            Element& element = mElements[open.back()];
+            const char* name = begin + element.mBegin + 1;
+            const std::size_t name_length = nameEnd(element.mBegin) - name;
+            if (std::size_t(tag_end - p) < name_length + 2 ||
+                std::memcmp(p + 2, name, name_length) != 0 ||
+                !isNameEnd(p[2 + name_length]))
+            {  return false; }
+
+            element.mContentEnd = p - begin;
+            element.mEnd = tag_end + 1 - begin;
+            element.mNext = mElements.size();
+            open.pop_back();
+            if (open.empty())
+            {  return true; }
+            p = tag_end + 1;
+         }
+         else
+         {
+            const char* tag_end = findTagEnd(p, end);
+            if (tag_end == NULL || isNameEnd(p[1]) || (open.empty() && !mElements.empty()))
+            {  return false; }
+
+            Element element;
+            element.mBegin = p - begin;
+            element.mTagEnd = tag_end - begin;
+            element.mContentEnd = element.mEnd = tag_end + 1 - begin;
+            element.mNext = mElements.size() + 1;
+            mElements.push_back(element);
+            if (tag_end[-1] != '/')
+            {  open.push_back(mElements.size() - 1); }
+            else if (open.empty())
+            {  return true; }
+            p = tag_end + 1;
+         }
+
+         if (p == NULL)
+         {  return false; }
+      }
+   }
+
+   void LazySource::attach(Node& node, std::size_t index)
+   {
+      acquire();
+      node.dropLazy();
+      node.mLazySource = this;
+      node.mLazyIndex = index;
+   }
+
+   void LazySource::expand(Node& node, std::size_t index)
+   {
+      const Element& element = mElements[index];
+      const bool leaf = isLeaf(element);
+      ContextPtr context = node.getContext();
+
+      // The start tag of the root was parsed with the prolog
+      if (index != 0 && hasAttributes(element))
+      {
+         ChunkStreamBuf buf(mText.data() + element.mBegin, mText.data() + element.mTagEnd + 1,
+                            leaf ? std::string() : "</" + getName(element) + ">");
+         std::istream in(&buf);
+         Location location;
+         Parser parser(in, location);
+         Node tag(context);
+         parser.parseNode(tag, context);
+         node.mAttributes.swap(tag.mAttributes);
+         node.invalidateHash();
+      }
+      if (leaf)
+      {  return; }
+
+      std::size_t gap = element.mTagEnd;
+      for (std::size_t c = index + 1; c < element.mNext; c = mElements[c].mNext)
+      {
+         const Element& child = mElements[c];
+         parseText(node, gap, child.mBegin);
+
+         const char* name = mText.data() + child.mBegin + 1;
+         NodePtr child_node(new Node(context));
+         child_node->setNameHandle(context->insertTagname(name, nameEnd(child.mBegin) - name));
+         if (isLeaf(child))
+         {  child_node->setType(Node::xml_nt_leaf); }
+         if (!isLeaf(child) || hasAttributes(child))
+         {  attach(*child_node, c); }
+         node.addChild(child_node);
+         gap = child.mEnd - 1;
+      }
+      parseText(node, gap, element.mContentEnd);
+   }
+
+   void LazySource::parseText(Node& node, std::size_t from, std::size_t to)
+   {
+      ContextPtr context = node.getContext();
+      const char* first = mText.data() + from + 1;
+      const char* last = mText.data() + to;
+
+      // Indentation makes no nodes unless whitespace is preserved
+      if (context->getWhitespaceMode() != Context::xml_ws_preserve)
+      {
+         while (first != last && isSpace(*first))
+         {  ++first; }
+         if (first == last)
+         {  return; }
+      }
+
+      // "</" ends the content like the end tag of node would
+      ChunkStreamBuf buf(mText.data() + from, last, "</");
+      std::istream in(&buf);
+      Location location;
+      Parser parser(in, location);
+      Node holder(context);
+      holder.setNameHandle(node.getNameHandle());
+      parser.parseContent(holder, context);
+
+      NodeList nodes;
+      nodes.swap(holder.mNodeList);
+      for (NodeList::iterator n = nodes.begin(); n != nodes.end(); ++n)
+      {  node.addChild(*n); }
+   }
+
+   void loadLazy(Document& doc, std::istream& in, ContextPtr& context, Location& location)
+   {
+      SourceRef source(new LazySource);
+      std::string& text = source->getText();
+      {
+         char block[64 * 1024];
+         while (in.read(block, sizeof(block)) || in.gcount() > 0)
+         {  text.append(block, std::size_t(in.gcount())); }
+      }
+      location.reset();
+
+      const bool scanned = !context->hasEventHandler() && context->getElementFilter().get() == NULL &&
+                           !text.empty() && source->scan();
+      if (!scanned)
+      {
+         ChunkStreamBuf buf(text.data(), text.data() + text.size(), "");
+         std::istream whole(&buf);
+         doc.load(whole, context, location);
+         return;
+      }
+
+      // Parse the prolog and the start tag of the root
+      const LazySource::Element& root = source->getElements()[0];
+      const bool leaf = source->isLeaf(root);
+      {
+         ChunkStreamBuf buf(text.data(), text.data() + root.mTagEnd + 1,
+                            leaf ? std::string() : "</" + source->getName(root) + ">");
+         std::istream prolog(&buf);
+         doc.load(prolog, context, location);
+      }
+      if (!leaf)
+      {  source->attach(*doc.getChildren().back(), 0); }
+   }
+
+   void loadFileLazy(Document& doc, const std::string& filename)
+   {
+      std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+      if (!in.good())
+      {
+         throw CPPDOM_ERROR(xml_filename_invalid, "Filename passed to loadFileLazy was invalid");
+      }
+
+      ContextPtr context = doc.getContext();
+      loadLazy(doc, in, context, context->getLocation());
+   }
+}
@@ -0,0 +1,158 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file lazy.h
+
+  loading documents whose nodes are parsed when they are first used
+
+*/
+
+// prevent multiple includes
+#ifndef CPPDOM_LAZY_H
+#define CPPDOM_LAZY_H
+
+// needed includes
+#include <string>
+#include <vector>
+
+#include <cppdom/cppdom.h>
+#include <cppdom/threads.h>
+
+// namespace declaration
+namespace cppdom
+{
+   /**
+    * Loads a document lazily.
+    *
+    * A structural skim of the input records where each element starts and
+    * ends; it matches start and end tags but decodes neither attributes
+    * nor text. A node is parsed when its attributes, cdata or children are
+    * first used, and then only the node itself: its child elements stay
+    * unparsed until they are used in turn. Loading is little more than
+    * reading the input, and memory grows with the part of the document
+    * that is touched.
+    *
+    * The input is kept in memory while any node is still unparsed. Tags
+    * that do not match are reported by the load; other errors inside an
+    * element are thrown by the accessor that parses it. Input the skim
+    * does not understand, and contexts with an event handler or an
+    * element filter, are loaded like Document::load does.
+    *
+    * @param location   receives the position of a parse error in the prolog
+    * @note Parsing changes the node even through const accessors, so a
+    *       lazily loaded document must not be used by several threads at
+    *       once until it is parsed.
+    * \exception throws cppdom::Error when a streaming or parsing error occur
+    */
+   CPPDOM_EXPORT(void) loadLazy(Document& doc, std::istream& in, ContextPtr& context,
+                                Location& location);
+
+   /**
+    * Loads a file with loadLazy(), using the context of the document.
+    * \exception throws cppdom::Error when the file name is invalid
+    *            or a parsing error occurs
+    */
+   CPPDOM_EXPORT(void) loadFileLazy(Document& doc, const std::string& filename);
+
+   /**
+    * The text of a lazily loaded document and the elements found in it,
+    * shared by its unparsed nodes.
+    */
+   class CPPDOM_CLASS LazySource
+   {
+   public:
+      /** one element of the text, by offsets into it */
+      struct Element
+      {
+         std::size_t mBegin;       /**< offset of the '<' of the start tag */
+         std::size_t mTagEnd;      /**< offset of the '>' of the start tag */
+         std::size_t mContentEnd;  /**< offset of the '<' of the end tag */
+         std::size_t mEnd;         /**< offset after the end tag */
+         std::size_t mNext;        /**< index of the first element after the subtree */
+      };
+
+      LazySource();
+
+      /** the text is kept until the last reference is released */
+      void acquire();
+      void release();
+
+      /** returns the text, for filling before scan() */
+      std::string& getText();
+
+      /**
+       * Finds the elements of the text. Returns false for anything it does
+       * not understand, which the parser then reports.
+       */
+      bool scan();
+
+      /** returns the elements, the root element first */
+      const std::vector<Element>& getElements() const;
+
+      /** returns true if the element is an empty element tag */
+      bool isLeaf(const Element& element) const;
+
+      /** returns true if the start tag of an element has attributes */
+      bool hasAttributes(const Element& element) const;
+
+      /** returns the name of an element */
+      std::string getName(const Element& element) const;
+
+      /** makes node parse the content of element index when it is used */
+      void attach(Node& node, std::size_t index);
+
+      /**
+       * Parses the attributes and the content of element index into node.
+       * Child elements become unparsed nodes of their own.
+       */
+      void expand(Node& node, std::size_t index);
+
+   private:
+      /** adds the nodes for the text between the tags at from and to */
+      void parseText(Node& node, std::size_t from, std::size_t to);
+
+      /** returns the end of the name of the tag at begin */
+      const char* nameEnd(std::size_t begin) const;
+
+      std::string          mText;      /**< the document */
+      std::vector<Element> mElements;  /**< elements in document order */
+      threads::Atomic<long> mRefs;     /**< nodes and loaders using the text */
+   };
+}
+
+#endif
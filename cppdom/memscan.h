@@ -0,0 +1,130 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file memscan.h
+
+  helpers for reading markup that is held in memory, shared by the
+  parallel and the lazy loaders
+
+*/
+
+// prevent multiple includes
+#ifndef CPPDOM_MEMSCAN_H
+#define CPPDOM_MEMSCAN_H
+
+// needed includes
+#include <cstring>
+#include <streambuf>
+#include <string>
+
+// namespace declaration
+namespace cppdom
+{
+   namespace scan
+   {
+      /** reads a block of memory followed by a short terminating string */
+      class ChunkStreamBuf : public std::streambuf
+      {
+      public:
+         ChunkStreamBuf(const char* begin, const char* end, const std::string& terminator)
+            : mTerminator(terminator), mInTerminator(false)
+         {
+            char* b = const_cast<char*>(begin);
+            setg(b, b, const_cast<char*>(end));
+         }
+
+      protected:
+         virtual int_type underflow()
+         {
+            if (gptr() < egptr())
+            {  return traits_type::to_int_type(*gptr()); }
+            if (mInTerminator || mTerminator.empty())
+            {  return traits_type::eof(); }
+
+            mInTerminator = true;
+            char* b = const_cast<char*>(mTerminator.data());
+            setg(b, b, b + mTerminator.size());
+            return traits_type::to_int_type(*gptr());
+         }
+
+      private:
+         std::string mTerminator;
+         bool        mInTerminator;
+      };
+
+      inline bool isNameEnd(char c)
+      {
+         return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '/' || c == '>';
+      }
+
+      /** returns the position after the first occurrence of str, or NULL */
+      inline const char* skipPast(const char* p, const char* end, const char* str)
+      {
+         const std::size_t len = std::strlen(str);
+         while (p != NULL && std::size_t(end - p) >= len)
+         {
+            p = static_cast<const char*>(std::memchr(p, str[0], end - p));
+            if (p == NULL || std::size_t(end - p) < len)
+            {  return NULL; }
+            if (std::memcmp(p, str, len) == 0)
+            {  return p + len; }
+            ++p;
+         }
+         return NULL;
+      }
+
+      /** returns the '>' ending the tag at p, honouring quoted values */
+      inline const char* findTagEnd(const char* p, const char* end)
+      {
+         for (; p < end; ++p)
+         {
+            if (*p == '>')
+            {  return p; }
+            if (*p == '"' || *p == '\'')
+            {
+               p = static_cast<const char*>(std::memchr(p + 1, *p, end - p - 1));
+               if (p == NULL)
+               {  return NULL; }
+            }
+         }
+         return NULL;
+      }
+   }
+}
+
+#endif
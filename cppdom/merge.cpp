@@ -0,0 +1,353 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file merge.cpp
+
+  merging overlays onto trees
+
+*/
+
+#include <vector>
+
+#include <cppdom/merge.h>
+
+namespace cppdom
+{
+   // MergeOptions methods
+
+   MergeOptions::MergeOptions()
+      : mPolicy(xml_merge_override)
+   {}
+
+   void MergeOptions::setPolicy(Policy policy)
+   {
+      mPolicy = policy;
+   }
+
+   void MergeOptions::setPolicy(const std::string& elementName, Policy policy)
+   {
+      mPolicies[elementName] = policy;
+   }
+
+   MergeOptions::Policy MergeOptions::getPolicy(const std::string& elementName) const
+   {
+      std::map<std::string, Policy>::const_iterator iter = mPolicies.find(elementName);
+      return (iter == mPolicies.end()) ? mPolicy : iter->second;
+   }
+
+   void MergeOptions::setKey(const std::string& attribName)
+   {
+      mKey = attribName;
+   }
+
+   void MergeOptions::setKey(const std::string& elementName, const std::string& attribName)
+   {
+      mKeys[elementName] = attribName;
+   }
+
+   const std::string& MergeOptions::getKey(const std::string& elementName) const
+   {
+      std::map<std::string, std::string>::const_iterator iter = mKeys.find(elementName);
+      return (iter == mKeys.end()) ? mKey : iter->second;
+   }
+
+   namespace
+   {
+      const unsigned none = ~0u;
+
+      /** cdata, comment and pi nodes carry text instead of children */
+      bool hasText(const Node& node)
+      {
+         const Node::Type type = node.getType();
+         return type == Node::xml_nt_cdata || type == Node::xml_nt_comment ||
+                type == Node::xml_nt_pi;
+      }
+
+      /** FNV-1a */
+      unsigned long hashString(const std::string& str, unsigned long hash)
+      {
+         for (std::string::const_iterator c = str.begin(); c != str.end(); ++c)
+         {
+            hash ^= static_cast<unsigned char>(*c);
+            hash *= 16777619UL;
+         }
+         return hash;
+      }
+
+      /** the options as they apply to one tag name */
+      struct Rule
+      {
+         Rule()
+            : mKnown(false), mPolicy(MergeOptions::xml_merge_override), mKey(NULL)
+            , mNameHash(0)
+         {}
+
+         bool                  mKnown;
+         MergeOptions::Policy  mPolicy;
+         const std::string*    mKey;       /**< NULL when matched by name only */
+         unsigned long         mNameHash;
+      };
+
+      /** rules of the tag names of one context, looked up once per name */
+      class RuleCache
+      {
+      public:
+         explicit RuleCache(const MergeOptions& options)
+            : mOptions(options)
+         {}
+
+         const Rule& get(Node& node)
+         {
+            ContextPtr context = node.getContext();
+            if (context.get() != mContext.get())
+            {
+               mContext = context;
+               mRules.clear();
+            }
+
+            const TagNameHandle handle = node.getNameHandle();
+            Rule* rule = &mScratch;
+            if (handle >= 0)
+            {
+               if (std::size_t(handle) >= mRules.size())
+               {  mRules.resize(handle + 1); }
+               rule = &mRules[handle];
+            }
+            else
+            {  mScratch.mKnown = false; }
+
+            if (!rule->mKnown)
+            {
+               const std::string& name = context->getTagname(handle);
+               const std::string& key = mOptions.getKey(name);
+               rule->mPolicy = mOptions.getPolicy(name);
+               rule->mKey = key.empty() ? NULL : &key;
+               rule->mNameHash = hashString(name, 2166136261UL);
+               rule->mKnown = true;
+            }
+            return *rule;
+         }
+
+      private:
+         const MergeOptions& mOptions;
+         ContextPtr          mContext;
+         std::vector<Rule>   mRules;     /**< by tag name handle */
+         Rule                mScratch;
+      };
+
+      /** what matches a child of one tree with a child of the other */
+      struct Identity
+      {
+         Node*              mNode;
+         const std::string* mKeyValue;   /**< NULL when there is no key */
+         unsigned long      mHash;
+      };
+
+      class Merger
+      {
+      public:
+         explicit Merger(const MergeOptions& options)
+            : mFromRules(options), mToRules(options)
+         {}
+
+         void mergeNode(Node& from, Node& to, MergeOptions::Policy policy)
+         {
+            mergeAttributes(from, to, policy);
+
+            if (hasText(from) && from.getType() == to.getType() &&
+                policy != MergeOptions::xml_merge_keep && from.getCdata() != to.getCdata())
+            {  to.setCdata(from.getCdata()); }
+
+            NodeList& from_children = from.getChildren();
+            if (from_children.empty())
+            {  return; }
+
+            std::vector<unsigned> match(from_children.size(), none);
+            if (policy != MergeOptions::xml_merge_append)
+            {  matchChildren(from_children, to.getChildren(), match); }
+
+            for (std::size_t j = 0; j < from_children.size(); ++j)
+            {
+               Node& child = *from_children[j];
+               if (match[j] != none)
+               {
+                  Node& target = *to.getChildren()[match[j]];
+                  // text merges as its parent does
+                  const MergeOptions::Policy child_policy = hasText(child)
+                                                          ? policy : mFromRules.get(child).mPolicy;
+                  mergeNode(child, target, child_policy);
+               }
+               else
+               {
+                  NodePtr copy = child.clone(true, to.getContext());
+                  if (to.getType() == Node::xml_nt_leaf)
+                  {  to.setType(Node::xml_nt_node); }
+                  to.addChild(copy);
+               }
+            }
+         }
+
+      private:
+         void mergeAttributes(Node& from, Node& to, MergeOptions::Policy policy)
+         {
+            Attributes& from_attribs = from.attrib();
+            Attributes& to_attribs = to.attrib();
+            for (Attributes::const_iterator a = from_attribs.begin(); a != from_attribs.end(); ++a)
+            {
+               Attributes::iterator existing = to_attribs.find(a->first);
+               if (existing == to_attribs.end())
+               {  to.setAttribute(a->first, a->second); }
+               else if (policy != MergeOptions::xml_merge_keep &&
+                        existing->second.getString() != a->second.getString())
+               {  to.setAttribute(a->first, a->second); }
+            }
+         }
+
+         Identity identify(Node& node, RuleCache& rules)
+         {
+            const Rule& rule = rules.get(node);
+            Identity id;
+            id.mNode = &node;
+            id.mKeyValue = NULL;
+            id.mHash = rule.mNameHash;
+            if (hasText(node))
+            {  id.mHash = ~id.mHash; }
+            else if (rule.mKey != NULL)
+            {
+               Attributes& attribs = node.attrib();
+               Attributes::const_iterator key = attribs.find(*rule.mKey);
+               if (key != attribs.end())
+               {
+                  id.mKeyValue = &key->second.getString();
+                  id.mHash = hashString(*id.mKeyValue, id.mHash ^ 0x5bd1e995UL);
+               }
+            }
+            return id;
+         }
+
+         static bool sameIdentity(const Identity& a, const Identity& b)
+         {
+            if (a.mHash != b.mHash ||
+                hasText(*a.mNode) != hasText(*b.mNode) ||
+                (a.mKeyValue == NULL) != (b.mKeyValue == NULL))
+            {  return false; }
+            if (a.mKeyValue != NULL && *a.mKeyValue != *b.mKeyValue)
+            {  return false; }
+
+            ContextPtr a_context = a.mNode->getContext();
+            ContextPtr b_context = b.mNode->getContext();
+            if (a_context.get() == b_context.get())
+            {  return a.mNode->getNameHandle() == b.mNode->getNameHandle(); }
+            return a_context->getTagname(a.mNode->getNameHandle()) ==
+                   b_context->getTagname(b.mNode->getNameHandle());
+         }
+
+         /**
+          * Finds the child of to for each child of from, in one pass over
+          * each list. Children of to with the same identity are chained in
+          * order behind the first of them, which is kept in an open
+          * addressing table.
+          */
+         void matchChildren(NodeList& from, NodeList& to, std::vector<unsigned>& match)
+         {
+            const unsigned count = unsigned(to.size());
+            if (count == 0)
+            {  return; }
+
+            std::size_t table_size = 16;
+            while (table_size < 2 * std::size_t(count))
+            {  table_size *= 2; }
+            const std::size_t mask = table_size - 1;
+
+            std::vector<Identity> ids(count);
+            std::vector<unsigned> table(table_size, none);
+            std::vector<unsigned> next(count, none);     // next with the same identity
+            std::vector<unsigned> last(count, none);     // by first: last of the chain
+            std::vector<unsigned> cursor(count, none);   // by first: next one unmatched
+
+            for (unsigned i = 0; i < count; ++i)
+            {
+               ids[i] = identify(*to[i], mToRules);
+               std::size_t slot = ids[i].mHash & mask;
+               while (table[slot] != none && !sameIdentity(ids[table[slot]], ids[i]))
+               {  slot = (slot + 1) & mask; }
+
+               const unsigned first = table[slot];
+               if (first == none)
+               {
+                  table[slot] = i;
+                  cursor[i] = i;
+               }
+               else
+               {  next[last[first]] = i; }
+               last[first == none ? i : first] = i;
+            }
+
+            for (std::size_t j = 0; j < from.size(); ++j)
+            {
+               const Identity id = identify(*from[j], mFromRules);
+               std::size_t slot = id.mHash & mask;
+               while (table[slot] != none && !sameIdentity(ids[table[slot]], id))
+               {  slot = (slot + 1) & mask; }
+
+               const unsigned first = table[slot];
+               if (first != none && cursor[first] != none)
+               {
+                  match[j] = cursor[first];
+                  cursor[first] = next[cursor[first]];
+               }
+            }
+         }
+
+         RuleCache mFromRules;
+         RuleCache mToRules;
+      };
+   }
+
+   void merge(NodePtr fromNode, NodePtr toNode, const MergeOptions& options)
+   {
+      Merger merger(options);
+      RuleCache rules(options);
+      merger.mergeNode(*fromNode, *toNode, rules.get(*toNode).mPolicy);
+   }
+
+   void merge(NodePtr fromNode, NodePtr toNode)
+   {
+      merge(fromNode, toNode, MergeOptions());
+   }
+}
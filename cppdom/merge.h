@@ -0,0 +1,123 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file merge.h
+
+  merging overlays onto trees
+
+*/
+
+// prevent multiple includes
+#ifndef CPPDOM_MERGE_H
+#define CPPDOM_MERGE_H
+
+// needed includes
+#include <string>
+#include <map>
+
+#include <cppdom/cppdom.h>
+
+// namespace declaration
+namespace cppdom
+{
+   /**
+    * How merge() matches the children of the two trees and which values win.
+    *
+    * Children are matched by identity: their name and, if a key attribute is
+    * set for the name, the value of that attribute. Children with the same
+    * identity are matched in the order they appear. Cdata children are
+    * matched in order as well.
+    */
+   class CPPDOM_CLASS MergeOptions
+   {
+   public:
+      /** what happens to an element that exists in both trees */
+      enum Policy
+      {
+         xml_merge_override,  /**< values of the overlay replace existing ones */
+         xml_merge_keep,      /**< existing values stay, missing ones are added */
+         xml_merge_append     /**< children of the overlay are added, not matched */
+      };
+
+      /** override everything, match by name only */
+      MergeOptions();
+
+      /** sets the policy of elements without a policy of their own */
+      void setPolicy(Policy policy);
+
+      /** sets the policy of the elements with the given name */
+      void setPolicy(const std::string& elementName, Policy policy);
+
+      Policy getPolicy(const std::string& elementName) const;
+
+      /** sets the key attribute of elements without a key of their own */
+      void setKey(const std::string& attribName);
+
+      /**
+       * Sets the key attribute of the elements with the given name.
+       * An empty name matches these elements by name only.
+       */
+      void setKey(const std::string& elementName, const std::string& attribName);
+
+      /** the key attribute of the elements with the given name, may be empty */
+      const std::string& getKey(const std::string& elementName) const;
+
+   protected:
+      Policy                             mPolicy;
+      std::string                        mKey;
+      std::map<std::string, Policy>      mPolicies;
+      std::map<std::string, std::string> mKeys;
+   };
+
+   /**
+    * Merges the overlay fromNode onto toNode.
+    *
+    * Attributes of fromNode are set on toNode as the policy of toNode says.
+    * Each child of fromNode is merged onto the child of toNode with the same
+    * identity, or a copy of it is appended to toNode when there is none or
+    * the policy is xml_merge_append. Cdata children merge as their parent
+    * does. Each level costs time linear in its number of children.
+    *
+    * @param fromNode   Node to read data from.
+    * @param toNode     Node to merge data onto.
+    * @param options    Matching and policies.
+    */
+   CPPDOM_EXPORT(void) merge(NodePtr fromNode, NodePtr toNode, const MergeOptions& options);
+}
+
+#endif
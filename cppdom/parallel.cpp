@@ -0,0 +1,439 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/*! \file parallel.cpp
+
+  loading many documents at once on several threads
+
+*/
+
+// needed includes
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <cppdom/memscan.h>
+#include <cppdom/parallel.h>
+#include <cppdom/workpool.h>
+#include <cppdom/xmlparser.h>
+
+// namespace declaration
+namespace cppdom
+{
+   // LoadResult methods
+
+   LoadResult::LoadResult()
+      : mError(xml_unknown)
+   {}
+
+   bool LoadResult::isOk() const
+   {
+      return mDocument.get() != NULL;
+   }
+
+   const std::string& LoadResult::getFilename() const
+   {
+      return mFilename;
+   }
+
+   DocumentPtr LoadResult::getDocument() const
+   {
+      return mDocument;
+   }
+
+   ErrorCode LoadResult::getError() const
+   {
+      return mError;
+   }
+
+   const std::string& LoadResult::getErrorString() const
+   {
+      return mErrorString;
+   }
+
+   const Location& LoadResult::getLocation() const
+   {
+      return mLocation;
+   }
+
+   /** loads one file into its slot of the result list */
+   class ParallelLoadTask : public threads::Task
+   {
+   public:
+      ParallelLoadTask(const std::vector<std::string>& filenames,
+                       LoadResultList& results, ContextPtr context)
+         : mFilenames(filenames), mResults(results), mContext(context)
+      {}
+
+      virtual void run(std::size_t index)
+      {
+         LoadResult& result = mResults[index];
+         result.mFilename = mFilenames[index];
+         try
+         {
+            std::ifstream in(result.mFilename.c_str(), std::ios::in);
+            if (!in.good())
+            {
+               throw CPPDOM_ERROR(xml_filename_invalid, "Filename passed to loadDocumentsParallel was invalid");
+            }
+
+            ContextPtr context = (mContext.get() != NULL) ? mContext : ContextPtr(new Context);
+            DocumentPtr doc(new Document(context));
+            doc->load(in, context, result.mLocation);
+            result.mDocument = doc;
+         }
+         catch (Error& e)
+         {
+            result.mError = e.getError();
+            result.mErrorString = e.getString();
+         }
+         catch (std::exception& e)
+         {
+            result.mError = xml_unknown;
+            result.mErrorString = e.what();
+         }
+      }
+
+   private:
+      const std::vector<std::string>&  mFilenames;
+      LoadResultList&                  mResults;
+      ContextPtr                       mContext;
+   };
+
+   LoadResultList loadDocumentsParallel(const std::vector<std::string>& filenames,
+                                        unsigned numThreads, ContextPtr context)
+   {
+      LoadResultList results(filenames.size());
+      ParallelLoadTask task(filenames, results, context);
+      threads::runTasks(task, results.size(), numThreads);
+      return results;
+   }
+
+   // Single document parallel parsing
+
+   namespace
+   {
+      using scan::ChunkStreamBuf;
+      using scan::isNameEnd;
+      using scan::skipPast;
+      using scan::findTagEnd;
+
+      /** chunks smaller than this are not worth a thread */
+      const std::size_t minChunkBytes = 16 * 1024;
+
+      /** chunks per thread, so stealing can even out uneven children */
+      const std::size_t chunksPerThread = 4;
+
+      /** what the pre-scan found out about a document */
+      struct Structure
+      {
+         std::string                mRootName;       /**< name of the root element */
+         std::size_t                mRootStartEnd;   /**< offset of the '>' ending the root start tag */
+         std::size_t                mContentEnd;     /**< offset of the '<' of the root end tag */
+         std::vector<std::size_t>   mSplits;         /**< offsets of the '>' ending root children */
+      };
+
+      /**
+       * finds the boundaries of the root children with a raw scan over the
+       * markup. returns false for anything it does not understand; the
+       * sequential parser then decides what is wrong with the input
+       */
+      bool scanStructure(const char* begin, const char* end, Structure& out)
+      {
+         int depth(0);
+         const char* p = begin;
+         while (true)
+         {
+            p = static_cast<const char*>(std::memchr(p, '<', end - p));
+            if (p == NULL || end - p < 2)
+            {  return false; }
+
+            if (p[1] == '?')
+            {  p = skipPast(p + 2, end, "?>"); }
+            else if (p[1] == '!' && end - p >= 4 && p[2] == '-' && p[3] == '-')
+            {  p = skipPast(p + 4, end, "-->"); }
+            else if (p[1] == '!' && end - p >= 9 && std::memcmp(p + 2, "[CDATA[", 7) == 0)
+            {  p = skipPast(p + 9, end, "]]>"); }
+            else if (p[1] == '!')
+            {
+               // Doctype or other declaration; must be in the prolog
+               if (depth != 0)
+               {  return false; }
+               p = skipPast(p + 2, end, ">");
+            }
+            else if (p[1] == '/')
+            {
+               const char* tag_end = findTagEnd(p, end);
+               if (tag_end == NULL || depth < 1)
+               {  return false; }
+               if (depth == 1)
+               {
+                  const char* name = p + 2;
+                  while (name < tag_end && (*name == ' ' || *name == '\t'))
+                  {  ++name; }
+                  const char* name_end = name;
+                  while (name_end < tag_end && !isNameEnd(*name_end))
+                  {  ++name_end; }
+                  if (std::string(name, name_end) != out.mRootName)
+                  {  return false; }
+                  out.mContentEnd = p - begin;
+                  return true;
+               }
+               --depth;
+               if (depth == 1)
+               {  out.mSplits.push_back(tag_end - begin); }
+               p = tag_end + 1;
+            }
+            else
+            {
+               const char* tag_end = findTagEnd(p, end);
+               if (tag_end == NULL)
+               {  return false; }
+               const bool empty_tag = (tag_end[-1] == '/');
+               if (depth == 0)
+               {
+                  if (empty_tag)
+                  {  return false; }
+                  const char* name_end = p + 1;
+                  while (name_end < tag_end && !isNameEnd(*name_end))
+                  {  ++name_end; }
+                  out.mRootName.assign(p + 1, name_end);
+                  out.mRootStartEnd = tag_end - begin;
+                  depth = 1;
+               }
+               else if (empty_tag)
+               {
+                  if (depth == 1)
+                  {  out.mSplits.push_back(tag_end - begin); }
+               }
+               else
+               {
+                  ++depth;
+               }
+               p = tag_end + 1;
+            }
+
+            if (p == NULL)
+            {  return false; }
+         }
+      }
+
+      /** one run of root children parsed by a worker */
+      struct Chunk
+      {
+         Chunk()
+            : mBegin(0), mEnd(0), mFailed(false), mError(xml_unknown, "", "")
+         {}
+
+         std::size_t    mBegin;     /**< offset of the leading '>' */
+         std::size_t    mEnd;       /**< offset after the last byte */
+         Location       mLocation;  /**< starts at mBegin, ends where parsing stopped */
+         NodeList       mNodes;     /**< the parsed children */
+         bool           mFailed;    /**< true if parsing threw */
+         Error          mError;     /**< the error thrown */
+      };
+
+      class ChunkParseTask : public threads::Task
+      {
+      public:
+         ChunkParseTask(const std::string& buffer, std::vector<Chunk>& chunks, ContextPtr& context)
+            : mBuffer(buffer), mChunks(chunks), mContext(context)
+         {}
+
+         virtual void run(std::size_t index)
+         {
+            Chunk& chunk = mChunks[index];
+            try
+            {
+               // "</" makes the last parseNode() stop like at the root end tag
+               ChunkStreamBuf buf(mBuffer.data() + chunk.mBegin, mBuffer.data() + chunk.mEnd, "</");
+               std::istream in(&buf);
+               Parser parser(in, chunk.mLocation);
+
+               Node holder(mContext);
+               parser.parseContent(holder, mContext);
+               chunk.mNodes.swap(holder.getChildren());
+            }
+            catch (Error& e)
+            {
+               chunk.mFailed = true;
+               chunk.mError = e;
+            }
+            catch (std::exception&)
+            {
+               chunk.mFailed = true;
+               chunk.mError = CPPDOM_ERROR(xml_unknown, "Exception while parsing a document chunk");
+            }
+         }
+
+      private:
+         const std::string&   mBuffer;
+         std::vector<Chunk>&  mChunks;
+         ContextPtr&          mContext;
+      };
+
+      /** sets loc to where the tokenizer would be before reading buffer[offset] */
+      void locate(const std::string& buffer, std::size_t from, std::size_t offset,
+                  int& line, std::size_t& lineStart, Location& loc)
+      {
+         const char* b = buffer.data();
+         for (const char* p = b + from;
+              (p = static_cast<const char*>(std::memchr(p, '\n', offset - (p - b)))) != NULL; ++p)
+         {
+            ++line;
+            lineStart = (p - b) + 1;
+         }
+         // The tokenizer counts from 0 on the first line and from 1 after a newline
+         const int pos = int(offset - lineStart) + (line > 0 ? 1 : 0);
+         loc.set(line, pos);
+      }
+   }
+
+   void loadParallel(Document& doc, std::istream& in, ContextPtr& context,
+                     Location& location, unsigned numThreads)
+   {
+      // One thread gains nothing from the copy and the pre-scan
+      if (0 == numThreads)
+      {  numThreads = threads::defaultThreadCount(); }
+      if (1 == numThreads)
+      {
+         location.reset();
+         doc.load(in, context, location);
+         return;
+      }
+
+      std::string buffer;
+      {
+         char block[64 * 1024];
+         while (in.read(block, sizeof(block)) || in.gcount() > 0)
+         {  buffer.append(block, std::size_t(in.gcount())); }
+      }
+      location.reset();
+
+      // A document needs room for two chunks before it is worth scanning
+      Structure structure;
+      const bool scanned = !context->hasEventHandler() && context->getElementFilter().get() == NULL &&
+                           buffer.size() >= minChunkBytes + minChunkBytes / 2 &&
+                           scanStructure(buffer.data(), buffer.data() + buffer.size(), structure);
+
+      // Group the children into chunks of about equal size
+      std::vector<Chunk> chunks;
+      if (scanned)
+      {
+         const std::size_t content_size = structure.mContentEnd - structure.mRootStartEnd;
+         const std::size_t target = std::max(minChunkBytes, content_size / (numThreads * chunksPerThread) + 1);
+
+         chunks.resize(1);
+         chunks[0].mBegin = structure.mRootStartEnd;
+         for (std::size_t s = 0; s < structure.mSplits.size(); ++s)
+         {
+            const std::size_t split = structure.mSplits[s];
+            if (split - chunks.back().mBegin >= target && structure.mContentEnd - split >= target / 2)
+            {
+               // The '>' ends one chunk and starts the next
+               chunks.back().mEnd = split + 1;
+               chunks.push_back(Chunk());
+               chunks.back().mBegin = split;
+            }
+         }
+         chunks.back().mEnd = structure.mContentEnd;
+      }
+
+      if (chunks.size() < 2)
+      {
+         ChunkStreamBuf buf(buffer.data(), buffer.data() + buffer.size(), "");
+         std::istream whole(&buf);
+         doc.load(whole, context, location);
+         return;
+      }
+
+      // Parse the prolog and an empty root element sequentially
+      {
+         ChunkStreamBuf buf(buffer.data(), buffer.data() + structure.mRootStartEnd + 1,
+                            "</" + structure.mRootName + ">");
+         std::istream prolog(&buf);
+         doc.load(prolog, context, location);
+      }
+      NodePtr root = doc.getChildren().back();
+
+      int line(0);
+      std::size_t line_start(0), counted(0);
+      for (std::size_t c = 0; c < chunks.size(); ++c)
+      {
+         locate(buffer, counted, chunks[c].mBegin, line, line_start, chunks[c].mLocation);
+         counted = chunks[c].mBegin;
+      }
+
+      ChunkParseTask task(buffer, chunks, context);
+      threads::runTasks(task, chunks.size(), numThreads);
+
+      // Report the first error in document order
+      for (std::size_t c = 0; c < chunks.size(); ++c)
+      {
+         if (chunks[c].mFailed)
+         {
+            location = chunks[c].mLocation;
+            throw chunks[c].mError;
+         }
+      }
+
+      for (std::size_t c = 0; c < chunks.size(); ++c)
+      {
+         NodeList& nodes = chunks[c].mNodes;
+         for (NodeList::iterator n = nodes.begin(); n != nodes.end(); ++n)
+         {  root->addChild(*n); }
+      }
+
+      // The end tag was already checked by the scan
+      int end_line(line);
+      std::size_t end_line_start(line_start);
+      locate(buffer, counted, structure.mContentEnd, end_line, end_line_start, location);
+   }
+
+   void loadFileParallel(Document& doc, const std::string& filename, unsigned numThreads)
+   {
+      std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+      if (!in.good())
+      {
+         throw CPPDOM_ERROR(xml_filename_invalid, "Filename passed to loadFileParallel was invalid");
+      }
+
+      ContextPtr context = doc.getContext();
+      loadParallel(doc, in, context, context->getLocation(), numThreads);
+   }
+}
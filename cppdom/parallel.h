@@ -0,0 +1,135 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file parallel.h
+
+  loading many documents at once on several threads
+
+*/
+
+// prevent multiple includes
+#ifndef CPPDOM_PARALLEL_H
+#define CPPDOM_PARALLEL_H
+
+// needed includes
+#include <string>
+#include <vector>
+
+#include <cppdom/cppdom.h>
+
+// namespace declaration
+namespace cppdom
+{
+   /** outcome of loading one file with loadDocumentsParallel() */
+   class CPPDOM_CLASS LoadResult
+   {
+   public:
+      LoadResult();
+
+      /** returns true if the file was loaded */
+      bool isOk() const;
+
+      /** returns the name of the file */
+      const std::string& getFilename() const;
+
+      /** returns the document, NULL if loading failed */
+      DocumentPtr getDocument() const;
+
+      /** returns the error code, xml_unknown if the file was loaded */
+      ErrorCode getError() const;
+
+      /** returns the text of the error, empty if the file was loaded */
+      const std::string& getErrorString() const;
+
+      /** returns the position in the file where parsing stopped */
+      const Location& getLocation() const;
+
+   protected:
+      friend class ParallelLoadTask;
+
+      std::string    mFilename;     /**< name of the file */
+      DocumentPtr    mDocument;     /**< the loaded document */
+      ErrorCode      mError;        /**< error code of a failed load */
+      std::string    mErrorString;  /**< text of the error */
+      Location       mLocation;     /**< parse position of this file */
+   };
+
+   typedef std::vector<LoadResult> LoadResultList;
+
+   /**
+    * Loads many xml files using a work stealing pool of threads.
+    * One failing file does not stop the others; check each result.
+    *
+    * @param filenames     the files to load
+    * @param numThreads    threads to use, 0 for one per core
+    * @param context       context shared by all documents, or NULL to give
+    *                      every document a context of its own
+    * @return one result per file, in the order of filenames
+    */
+   CPPDOM_EXPORT(LoadResultList) loadDocumentsParallel(const std::vector<std::string>& filenames,
+                                                       unsigned numThreads = 0,
+                                                       ContextPtr context = ContextPtr());
+
+   /**
+    * Loads one large document using several threads.
+    *
+    * A structural pre-scan finds where the children of the root element
+    * start and end. Runs of those children are then parsed concurrently
+    * and added to the root in document order. The result is the same as
+    * Document::load; documents the pre-scan does not understand, and
+    * contexts with an event handler or an element filter, are parsed
+    * sequentially. So are documents too small to split. With one thread
+    * the stream goes straight to Document::load.
+    *
+    * @param location   receives the position of a parse error
+    * @param numThreads threads to use, 0 for one per core
+    * \exception throws cppdom::Error when a streaming or parsing error occur
+    */
+   CPPDOM_EXPORT(void) loadParallel(Document& doc, std::istream& in, ContextPtr& context,
+                                    Location& location, unsigned numThreads = 0);
+
+   /**
+    * Loads a file with loadParallel(), using the context of the document.
+    * \exception throws cppdom::Error when the file name is invalid
+    *            or a parsing error occurs
+    */
+   CPPDOM_EXPORT(void) loadFileParallel(Document& doc, const std::string& filename,
+                                        unsigned numThreads = 0);
+}
+
+#endif
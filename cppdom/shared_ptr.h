@@ -43,6 +43,10 @@
   the boost::shared_ptr<T> is a reference counting smart pointer.
   read the copyright notice below
 
+  the reference count is a cppdom::threads::Atomic, so copies of one
+  pointer may be made and destroyed in several threads at once. define
+  CPPDOM_SHARED_PTR_NO_THREADS to get the old plain counter.
+
 */
 
 // prevent multiple includes
@@ -63,6 +67,8 @@
 #include <algorithm>          // for std::swap
 #include <functional>         // for std::less
 
+#include <cppdom/threads.h>
+
 //! namespace of the boost library
 namespace cppdom_boost {
 
@@ -90,6 +96,21 @@ template<typename T> struct shared_deleter
 
 struct dynamic_cast_tag {};
 
+// reference count updates, atomic unless threads are switched off
+#if defined(CPPDOM_SHARED_PTR_NO_THREADS)
+typedef long shared_count;
+inline long load_count(const shared_count* pn) { return *pn; }
+inline void store_count(shared_count* pn, long n) { *pn = n; }
+inline void atomic_increment(shared_count* pn) { ++*pn; }
+inline long atomic_decrement(shared_count* pn) { return --*pn; }
+#else
+typedef cppdom::threads::Atomic<long> shared_count;
+inline long load_count(const shared_count* pn) { return pn->load(); }
+inline void store_count(shared_count* pn, long n) { pn->store(n); }
+inline void atomic_increment(shared_count* pn) { pn->fetchAdd(1); }
+inline long atomic_decrement(shared_count* pn) { return pn->fetchAdd(-1) - 1; }
+#endif
+
 template<class T> struct shared_ptr_traits
 {
 	typedef T & reference;
@@ -114,11 +135,11 @@ template<typename T> class shared_ptr {
    typedef T element_type;
 
    explicit shared_ptr(T* p =0) : px(p) {
-      try { pn = new long(1); }  // fix: prevent leak if new throws
+      try { pn = new detail::shared_count(1); }  // fix: prevent leak if new throws
       catch (...) { delete p; throw; } 
    }
 
-   shared_ptr(const shared_ptr& r) : px(r.px) { ++*(pn = r.pn); }  // never throws
+   shared_ptr(const shared_ptr& r) : px(r.px) { detail::atomic_increment(pn = r.pn); }  // never throws
 
    ~shared_ptr() { dispose(); }
 
@@ -130,12 +151,12 @@ template<typename T> class shared_ptr {
 #if !defined( BOOST_NO_MEMBER_TEMPLATES )
    template<typename Y>
       shared_ptr(const shared_ptr<Y>& r) : px(r.px) {  // never throws 
-         ++*(pn = r.pn); 
+         detail::atomic_increment(pn = r.pn);
       }
 
    template<typename Y>
       shared_ptr(std::auto_ptr<Y>& r) { 
-         pn = new long(1); // may throw
+         pn = new detail::shared_count(1); // may throw
          px = r.release(); // fix: moved here to stop leak if new throws
       } 
 
@@ -148,10 +169,10 @@ template<typename T> class shared_ptr {
    template<typename Y>
       shared_ptr& operator=(std::auto_ptr<Y>& r) {
          // code choice driven by guarantee of "no effect if new throws"
-         if (*pn == 1) { delete px; }
+         if (detail::load_count(pn) == 1) { delete px; }
          else { // allocate new reference counter
-           long * tmp = new long(1); // may throw
-           --*pn; // only decrement once danger of new throwing is past
+           detail::shared_count * tmp = new detail::shared_count(1); // may throw
+           detail::atomic_decrement(pn); // only decrement once danger of new throwing is past
            pn = tmp;
          } // allocate new reference counter
          px = r.release(); // fix: moved here so doesn't leak if new throws 
@@ -159,16 +180,16 @@ template<typename T> class shared_ptr {
       }
 #else
       shared_ptr(std::auto_ptr<T>& r) { 
-         pn = new long(1); // may throw
+         pn = new detail::shared_count(1); // may throw
          px = r.release(); // fix: moved here to stop leak if new throws
       } 
 
       shared_ptr& operator=(std::auto_ptr<T>& r) {
          // code choice driven by guarantee of "no effect if new throws"
-         if (*pn == 1) { delete px; }
+         if (detail::load_count(pn) == 1) { delete px; }
          else { // allocate new reference counter
-           long * tmp = new long(1); // may throw
-           --*pn; // only decrement once danger of new throwing is past
+           detail::shared_count * tmp = new detail::shared_count(1); // may throw
+           detail::atomic_decrement(pn); // only decrement once danger of new throwing is past
            pn = tmp;
          } // allocate new reference counter
          px = r.release(); // fix: moved here so doesn't leak if new throws 
@@ -178,16 +199,16 @@ template<typename T> class shared_ptr {
 
    void reset(T* p=0) {
       if ( px == p ) return;  // fix: self-assignment safe
-      if (--*pn == 0) { delete px; }
+      if (detail::atomic_decrement(pn) == 0) { delete px; }
       else { // allocate new reference counter
-        try { pn = new long; }  // fix: prevent leak if new throws
+        try { pn = new detail::shared_count; }  // fix: prevent leak if new throws
         catch (...) {
-          ++*pn;  // undo effect of --*pn above to meet effects guarantee 
+          detail::atomic_increment(pn);  // undo effect of the decrement above to meet effects guarantee 
           delete p;
           throw;
         } // catch
       } // allocate new reference counter
-      *pn = 1;
+      detail::store_count(pn, 1);
       px = p;
    } // reset
 
@@ -199,8 +220,8 @@ template<typename T> class shared_ptr {
    operator T*() const           { return px; }  // never throws 
  #endif
 
-   long use_count() const        { return *pn; }  // never throws
-   bool unique() const           { return *pn == 1; }  // never throws
+   long use_count() const        { return detail::load_count(pn); }  // never throws
+   bool unique() const           { return detail::load_count(pn) == 1; }  // never throws
 
    void swap(shared_ptr<T>& other)  // never throws
      { std::swap(px,other.px); std::swap(pn,other.pn); }
@@ -213,20 +234,20 @@ template<typename T> class shared_ptr {
 #endif
 
    T*     px;     // contained pointer
-   long*  pn;     // ptr to reference counter
+   detail::shared_count*  pn;     // ptr to reference counter
 
 // Don't split this line into two; that causes problems for some GCC 2.95.2 builds
 #if !defined( BOOST_NO_MEMBER_TEMPLATES ) && !defined( BOOST_NO_MEMBER_TEMPLATE_FRIENDS )
    template<typename Y> friend class shared_ptr;
 #endif
 
-   void dispose() { if (--*pn == 0) { delete px; delete pn; } }
+   void dispose() { if (detail::atomic_decrement(pn) == 0) { delete px; delete pn; } }
 
-   void share(T* rpx, long* rpn) {
+   void share(T* rpx, detail::shared_count* rpn) {
       if (pn != rpn) {
          dispose();
          px = rpx;
-         ++*(pn = rpn);
+         detail::atomic_increment(pn = rpn);
       }
    } // share
 };  // shared_ptr
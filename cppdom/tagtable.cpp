@@ -0,0 +1,223 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/*! \file tagtable.cpp
+
+  concurrent tag name interning table
+
+*/
+
+// needed includes
+#include <cppdom/tagtable.h>
+
+// namespace declaration
+namespace cppdom
+{
+   TagTable::Slots::Slots(unsigned size)
+      : mMask(size - 1), mHandles(new threads::Atomic<int>[size])
+   {}
+
+   TagTable::Slots::~Slots()
+   {
+      delete [] mHandles;
+   }
+
+   TagTable::Shard::Shard()
+      : mSlots(new Slots(16)), mCount(0)
+   {}
+
+   TagTable::TagTable()
+      : mNextHandle(0)
+   {}
+
+   TagTable::~TagTable()
+   {
+      const TagNameHandle count = mNextHandle.load();
+      for (TagNameHandle h = 0; h < count; ++h)
+      {  delete getName(h); }
+
+      for (unsigned s = 0; s < numSegments; ++s)
+      {  delete [] mSegments[s].load(); }
+
+      for (unsigned i = 0; i < numShards; ++i)
+      {
+         delete mShards[i].mSlots.load();
+         for (unsigned r = 0; r < mShards[i].mRetired.size(); ++r)
+         {  delete mShards[i].mRetired[r]; }
+      }
+   }
+
+   unsigned TagTable::segmentOf(TagNameHandle handle, unsigned& offset)
+   {
+      // Segment s starts at handle firstSegmentSize * (2^s - 1)
+      unsigned v = unsigned(handle) / firstSegmentSize + 1;
+      unsigned segment(0);
+      while (v >>= 1)
+      {  ++segment; }
+      offset = unsigned(handle) - firstSegmentSize * ((1u << segment) - 1);
+      return segment;
+   }
+
+   const std::string* TagTable::getName(TagNameHandle handle) const
+   {
+      if (handle < 0)
+      {  return NULL; }
+
+      unsigned offset;
+      const unsigned segment = segmentOf(handle, offset);
+      if (segment >= numSegments)
+      {  return NULL; }
+
+      const NameSlot* names = mSegments[segment].load();
+      return (NULL == names) ? NULL : names[offset].load();
+   }
+
+   TagTable::NameSlot& TagTable::nameSlot(TagNameHandle handle)
+   {
+      unsigned offset;
+      const unsigned segment = segmentOf(handle, offset);
+      if (segment >= numSegments)
+      {
+         throw CPPDOM_ERROR(xml_invalid_operation, "Too many tag names in one context");
+      }
+
+      NameSlot* names = mSegments[segment].load();
+      if (NULL == names)
+      {
+         // Inserts in other shards may race for the same new segment
+         NameSlot* fresh = new NameSlot[firstSegmentSize << segment];
+         if (mSegments[segment].compareExchange(names, fresh))
+         {  names = fresh; }
+         else
+         {  delete [] fresh; }
+      }
+      return names[offset];
+   }
+
+   unsigned TagTable::hashName(const char* name, std::size_t length)
+   {
+      // FNV-1a
+      unsigned hash = 2166136261u;
+      for (std::size_t i = 0; i < length; ++i)
+      {
+         hash ^= (unsigned char)name[i];
+         hash *= 16777619u;
+      }
+      return hash;
+   }
+
+   TagNameHandle TagTable::findIn(const Slots& slots, unsigned hash,
+                                  const char* name, std::size_t length) const
+   {
+      // The low bits picked the shard, probe with the others
+      for (unsigned i = (hash / numShards) & slots.mMask; ; i = (i + 1) & slots.mMask)
+      {
+         const int value = slots.mHandles[i].load();
+         if (0 == value)
+         {  return -1; }
+         const std::string& known = *getName(value - 1);
+         if (known.size() == length && 0 == known.compare(0, length, name, length))
+         {  return value - 1; }
+      }
+   }
+
+   void TagTable::addTo(Slots& slots, unsigned hash, TagNameHandle handle)
+   {
+      unsigned i = (hash / numShards) & slots.mMask;
+      while (slots.mHandles[i].load() != 0)
+      {  i = (i + 1) & slots.mMask; }
+      slots.mHandles[i].store(handle + 1);
+   }
+
+   TagNameHandle TagTable::find(const std::string& name) const
+   {
+      const unsigned hash = hashName(name.data(), name.size());
+      const Shard& shard = mShards[hash & (numShards - 1)];
+      return findIn(*shard.mSlots.load(), hash, name.data(), name.size());
+   }
+
+   TagNameHandle TagTable::insert(const std::string& name)
+   {
+      return insert(name.data(), name.size());
+   }
+
+   TagNameHandle TagTable::insert(const char* name, std::size_t length)
+   {
+      const unsigned hash = hashName(name, length);
+      Shard& shard = mShards[hash & (numShards - 1)];
+
+      // Known names are the common case and take no lock
+      TagNameHandle handle = findIn(*shard.mSlots.load(), hash, name, length);
+      if (-1 != handle)
+      {  return handle; }
+
+      threads::ScopedLock lock(shard.mMutex);
+      Slots* slots = shard.mSlots.load();
+      handle = findIn(*slots, hash, name, length);
+      if (-1 != handle)
+      {  return handle; }
+
+      // Publish the name before the handle becomes findable
+      handle = mNextHandle.fetchAdd(1);
+      nameSlot(handle).store(new std::string(name, length));
+
+      // Keep the table at most half full so probes stay short and end
+      if ((shard.mCount + 1) * 2 > slots->mMask + 1)
+      {
+         Slots* bigger = new Slots((slots->mMask + 1) * 2);
+         for (unsigned i = 0; i <= slots->mMask; ++i)
+         {
+            const int value = slots->mHandles[i].load();
+            if (0 != value)
+            {
+               const std::string& known = *getName(value - 1);
+               addTo(*bigger, hashName(known.data(), known.size()), value - 1);
+            }
+         }
+         addTo(*bigger, hash, handle);
+         shard.mSlots.store(bigger);
+         shard.mRetired.push_back(slots);
+      }
+      else
+      {
+         addTo(*slots, hash, handle);
+      }
+      ++shard.mCount;
+      return handle;
+   }
+}
@@ -0,0 +1,128 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file tagtable.h
+
+  concurrent tag name interning table used by Context
+
+  Handle -> name reads and name -> handle lookups never lock. Names live in
+  segments that never move once allocated, so a handle stays valid and its
+  string stays at the same address for the life of the table. Inserts are
+  spread over shards, each with its own lock and open addressing table.
+*/
+
+// prevent multiple includes
+#ifndef CPPDOM_TAGTABLE_H
+#define CPPDOM_TAGTABLE_H
+
+// needed includes
+#include <string>
+#include <vector>
+
+#include <cppdom/cppdom.h>
+#include <cppdom/threads.h>
+
+// namespace declaration
+namespace cppdom
+{
+   /** interns tag names; all methods may be called concurrently */
+   class TagTable
+   {
+   public:
+      TagTable();
+      ~TagTable();
+
+      /** returns the name of a handle, NULL when the handle is unknown */
+      const std::string* getName(TagNameHandle handle) const;
+
+      /** returns the handle of a name, -1 when the name is unknown */
+      TagNameHandle find(const std::string& name) const;
+
+      /** returns the handle of a name, adding the name if needed */
+      TagNameHandle insert(const std::string& name);
+
+      /** insert() for a name that is not held in a string */
+      TagNameHandle insert(const char* name, std::size_t length);
+
+   private:
+      TagTable(const TagTable&);
+      TagTable& operator=(const TagTable&);
+
+      typedef threads::Atomic<const std::string*> NameSlot;
+
+      /** open addressing table of handle + 1 values, 0 marks a free slot */
+      struct Slots
+      {
+         explicit Slots(unsigned size);
+         ~Slots();
+
+         unsigned                   mMask;      /**< size - 1, size is a power of two */
+         threads::Atomic<int>*      mHandles;   /**< the slots */
+      };
+
+      struct Shard
+      {
+         Shard();
+
+         threads::Mutex             mMutex;     /**< serializes inserts */
+         threads::Atomic<Slots*>    mSlots;     /**< current table, read without locking */
+         unsigned                   mCount;     /**< names in the table */
+         std::vector<Slots*>        mRetired;   /**< outgrown tables readers may still use */
+      };
+
+      enum
+      {
+         firstSegmentSize = 64,     /**< segment s holds firstSegmentSize << s names */
+         numSegments = 25,          /**< 64 * (2^25 - 1) names, handles past them are invalid */
+         numShards = 16             /**< must be a power of two */
+      };
+
+      static unsigned segmentOf(TagNameHandle handle, unsigned& offset);
+      static unsigned hashName(const char* name, std::size_t length);
+      TagNameHandle findIn(const Slots& slots, unsigned hash,
+                           const char* name, std::size_t length) const;
+      void addTo(Slots& slots, unsigned hash, TagNameHandle handle);
+      NameSlot& nameSlot(TagNameHandle handle);
+
+      threads::Atomic<NameSlot*> mSegments[numSegments];   /**< handle -> name, never moved */
+      threads::Atomic<int>       mNextHandle;              /**< next handle to hand out */
+      Shard                      mShards[numShards];       /**< name -> handle */
+   };
+}
+
+#endif
@@ -0,0 +1,276 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file threads.h
+
+  atomics and locks used by the library and by shared_ptr
+
+  Atomic is built on the compiler's atomic builtins (__atomic or __sync
+  with gcc and clang, _Interlocked with MSVC), on std::atomic for other
+  compilers with a C++11 standard library, and is a plain value when
+  CPPDOM_NO_THREADS is defined. Compilers with neither builtins nor C++11
+  get the plain value too, with a #pragma message saying so. The branch
+  does not depend on the language level as long as the compiler has
+  builtins, so the library and its users agree on the layout. Mutex is a
+  spinlock on an Atomic, the locks it guards are short.
+*/
+
+// prevent multiple includes
+#ifndef CPPDOM_THREADS_H
+#define CPPDOM_THREADS_H
+
+// needed includes
+#include <cppdom/config.h>
+
+#if defined(CPPDOM_NO_THREADS)
+#  define CPPDOM_PLAIN_ATOMICS
+#elif defined(__GNUC__)
+   // builtins need no header
+#elif defined(_MSC_VER)
+#  include <cstring>
+#  include <intrin.h>
+#  pragma intrinsic(_InterlockedCompareExchange, _InterlockedCompareExchange64, _ReadWriteBarrier)
+#elif defined(CPPDOM_HAS_STD_THREAD)
+#  include <atomic>
+#else
+#  pragma message("cppdom: no atomic operations for this compiler, the library is not thread-safe")
+#  define CPPDOM_PLAIN_ATOMICS
+#endif
+
+// namespace declaration
+namespace cppdom
+{
+namespace threads
+{
+#if defined(_MSC_VER) && !defined(CPPDOM_PLAIN_ATOMICS) && !defined(__GNUC__)
+   namespace detail
+   {
+      /** compare-exchange on a value of the given size */
+      template<int Size>
+      struct Interlocked;
+
+      template<>
+      struct Interlocked<4>
+      {
+         typedef long value_type;
+
+         static value_type compareExchange(volatile void* p, value_type expected, value_type desired)
+         {  return _InterlockedCompareExchange(static_cast<volatile long*>(p), desired, expected); }
+      };
+
+      template<>
+      struct Interlocked<8>
+      {
+         typedef __int64 value_type;
+
+         static value_type compareExchange(volatile void* p, value_type expected, value_type desired)
+         {  return _InterlockedCompareExchange64(static_cast<volatile __int64*>(p), desired, expected); }
+      };
+   }
+#endif
+
+   /**
+    * A value that may be read and written by several threads.
+    * T is an integer or a pointer, fetchAdd() needs an integer.
+    */
+   template<class T>
+   class Atomic
+   {
+   public:
+      explicit Atomic(T value = T())
+         : mValue(value)
+      {}
+
+      /** reads the value; sees everything written before the matching store */
+      T load() const
+      {
+#if defined(CPPDOM_PLAIN_ATOMICS)
+         return mValue;
+#elif defined(__ATOMIC_ACQUIRE)
+         return __atomic_load_n(&mValue, __ATOMIC_ACQUIRE);
+#elif defined(__GNUC__)
+         T value = *static_cast<const volatile T*>(&mValue);
+         __sync_synchronize();
+         return value;
+#elif defined(_MSC_VER)
+         // volatile accesses have acquire/release semantics with MSVC
+         T value = *static_cast<const volatile T*>(&mValue);
+         _ReadWriteBarrier();
+         return value;
+#else
+         return mValue.load(std::memory_order_acquire);
+#endif
+      }
+
+      /** publishes the value and everything written before it */
+      void store(T value)
+      {
+#if defined(CPPDOM_PLAIN_ATOMICS)
+         mValue = value;
+#elif defined(__ATOMIC_RELEASE)
+         __atomic_store_n(&mValue, value, __ATOMIC_RELEASE);
+#elif defined(__GNUC__)
+         __sync_synchronize();
+         *static_cast<volatile T*>(&mValue) = value;
+#elif defined(_MSC_VER)
+         _ReadWriteBarrier();
+         *static_cast<volatile T*>(&mValue) = value;
+#else
+         mValue.store(value, std::memory_order_release);
+#endif
+      }
+
+      /** stores desired if the value is expected, else loads it into expected */
+      bool compareExchange(T& expected, T desired)
+      {
+#if defined(CPPDOM_PLAIN_ATOMICS)
+         if (mValue != expected)
+         {
+            expected = mValue;
+            return false;
+         }
+         mValue = desired;
+         return true;
+#elif defined(__ATOMIC_SEQ_CST)
+         return __atomic_compare_exchange_n(&mValue, &expected, desired, false,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#elif defined(__GNUC__)
+         const T old_value = __sync_val_compare_and_swap(&mValue, expected, desired);
+         if (old_value == expected)
+         {  return true; }
+         expected = old_value;
+         return false;
+#elif defined(_MSC_VER)
+         // pointers and integers go through an integer of the same size
+         typedef detail::Interlocked<sizeof(T)> Ops;
+         typename Ops::value_type old_bits, expected_bits, desired_bits;
+         std::memcpy(&expected_bits, &expected, sizeof(T));
+         std::memcpy(&desired_bits, &desired, sizeof(T));
+         old_bits = Ops::compareExchange(&mValue, expected_bits, desired_bits);
+         if (old_bits == expected_bits)
+         {  return true; }
+         std::memcpy(&expected, &old_bits, sizeof(T));
+         return false;
+#else
+         return mValue.compare_exchange_strong(expected, desired);
+#endif
+      }
+
+      /** adds to the value, returns the previous one */
+      T fetchAdd(T delta)
+      {
+#if defined(CPPDOM_PLAIN_ATOMICS)
+         T old_value = mValue;
+         mValue += delta;
+         return old_value;
+#elif defined(__ATOMIC_SEQ_CST)
+         return __atomic_fetch_add(&mValue, delta, __ATOMIC_SEQ_CST);
+#elif defined(__GNUC__)
+         return __sync_fetch_and_add(&mValue, delta);
+#elif defined(_MSC_VER)
+         T old_value = load();
+         while (!compareExchange(old_value, old_value + delta))
+         {}
+         return old_value;
+#else
+         return mValue.fetch_add(delta);
+#endif
+      }
+
+   private:
+      Atomic(const Atomic&);
+      Atomic& operator=(const Atomic&);
+
+#if defined(CPPDOM_PLAIN_ATOMICS) || defined(__GNUC__) || defined(_MSC_VER)
+      T mValue;
+#else
+      std::atomic<T> mValue;
+#endif
+   };
+
+   /** spinlock, for the short sections the library locks */
+   class Mutex
+   {
+   public:
+      Mutex()
+         : mLocked(0)
+      {}
+
+      void lock()
+      {
+         int expected = 0;
+         while (!mLocked.compareExchange(expected, 1))
+         {
+            // wait on plain loads, they keep the cache line shared
+            while (mLocked.load() != 0)
+            {}
+            expected = 0;
+         }
+      }
+
+      void unlock()
+      {  mLocked.store(0); }
+
+   private:
+      Mutex(const Mutex&);
+      Mutex& operator=(const Mutex&);
+
+      Atomic<int> mLocked;
+   };
+
+   /** holds a Mutex for its lifetime */
+   class ScopedLock
+   {
+   public:
+      explicit ScopedLock(Mutex& mutex)
+         : mMutex(mutex)
+      {  mMutex.lock(); }
+
+      ~ScopedLock()
+      {  mMutex.unlock(); }
+
+   private:
+      ScopedLock(const ScopedLock&);
+      ScopedLock& operator=(const ScopedLock&);
+
+      Mutex& mMutex;
+   };
+}
+}
+
+#endif
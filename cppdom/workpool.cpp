@@ -0,0 +1,206 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/*! \file workpool.cpp
+
+  work stealing thread pool
+
+*/
+
+// needed includes
+#include <vector>
+
+#include <cppdom/workpool.h>
+#include <cppdom/threads.h>
+
+#ifdef CPPDOM_HAS_STD_THREAD
+#  include <thread>
+#endif
+
+// namespace declaration
+namespace cppdom
+{
+namespace threads
+{
+   Task::~Task()
+   {}
+
+   unsigned defaultThreadCount()
+   {
+#ifdef CPPDOM_HAS_STD_THREAD
+      const unsigned cores = std::thread::hardware_concurrency();
+      return (cores == 0) ? 1 : cores;
+#else
+      return 1;
+#endif
+   }
+
+#ifdef CPPDOM_HAS_STD_THREAD
+   namespace
+   {
+      /** the indices a worker has left, [mBegin, mEnd) */
+      struct WorkRange
+      {
+         WorkRange()
+            : mBegin(0), mEnd(0)
+         {}
+
+         Mutex          mMutex;
+         std::size_t    mBegin;
+         std::size_t    mEnd;
+      };
+
+      class Pool
+      {
+      public:
+         Pool(Task& task, std::size_t count, unsigned numWorkers)
+            : mTask(task), mRanges(numWorkers)
+         {
+            // Contiguous blocks keep neighbouring work in one thread
+            for (unsigned w = 0; w < numWorkers; ++w)
+            {
+               mRanges[w].mBegin = count * w / numWorkers;
+               mRanges[w].mEnd = count * (w + 1) / numWorkers;
+            }
+         }
+
+         void work(unsigned self)
+         {
+            std::size_t index;
+            while (takeOwn(self, index) || steal(self, index))
+            {
+               mTask.run(index);
+            }
+         }
+
+      private:
+         bool takeOwn(unsigned self, std::size_t& index)
+         {
+            WorkRange& range = mRanges[self];
+            ScopedLock lock(range.mMutex);
+            if (range.mBegin == range.mEnd)
+            {  return false; }
+            index = range.mBegin++;
+            return true;
+         }
+
+         bool steal(unsigned self, std::size_t& index)
+         {
+            while (true)
+            {
+               // Pick the victim with the most work left
+               unsigned victim = self;
+               std::size_t most = 0;
+               for (unsigned w = 0; w < mRanges.size(); ++w)
+               {
+                  ScopedLock lock(mRanges[w].mMutex);
+                  const std::size_t left = mRanges[w].mEnd - mRanges[w].mBegin;
+                  if (left > most)
+                  {
+                     most = left;
+                     victim = w;
+                  }
+               }
+               if (0 == most)
+               {  return false; }
+
+               std::size_t begin, end;
+               {
+                  WorkRange& range = mRanges[victim];
+                  ScopedLock lock(range.mMutex);
+                  if (range.mBegin == range.mEnd)
+                  {  continue; }      // Someone was faster, look again
+                  begin = range.mBegin + (range.mEnd - range.mBegin) / 2;
+                  end = range.mEnd;
+                  range.mEnd = begin;
+                  if (begin == end)
+                  {
+                     // A single index left, take it
+                     index = --range.mEnd;
+                     return true;
+                  }
+               }
+
+               WorkRange& own = mRanges[self];
+               ScopedLock lock(own.mMutex);
+               own.mBegin = begin + 1;
+               own.mEnd = end;
+               index = begin;
+               return true;
+            }
+         }
+
+         Task&                   mTask;
+         std::vector<WorkRange>  mRanges;
+      };
+
+      void runWorker(Pool* pool, unsigned self)
+      {
+         pool->work(self);
+      }
+   }
+#endif
+
+   void runTasks(Task& task, std::size_t count, unsigned numThreads)
+   {
+      if (0 == numThreads)
+      {  numThreads = defaultThreadCount(); }
+      if (numThreads > count)
+      {  numThreads = unsigned(count); }
+
+#ifdef CPPDOM_HAS_STD_THREAD
+      if (numThreads > 1)
+      {
+         Pool pool(task, count, numThreads);
+         std::vector<std::thread> workers;
+         for (unsigned w = 1; w < numThreads; ++w)
+         {
+            workers.push_back(std::thread(runWorker, &pool, w));
+         }
+         pool.work(0);     // The calling thread is worker 0
+         for (unsigned w = 0; w < workers.size(); ++w)
+         {  workers[w].join(); }
+         return;
+      }
+#endif
+
+      for (std::size_t i = 0; i < count; ++i)
+      {  task.run(i); }
+   }
+}
+}
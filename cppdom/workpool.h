@@ -0,0 +1,88 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ * 
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+/** \file workpool.h
+
+  work stealing thread pool used by the parallel loaders
+
+  The indices of a job are split into one range per worker. A worker takes
+  indices from the front of its own range and, once that is empty, steals
+  the back half of the largest range left, so uneven work (a few large
+  files among many small ones) still keeps every thread busy.
+*/
+
+// prevent multiple includes
+#ifndef CPPDOM_WORKPOOL_H
+#define CPPDOM_WORKPOOL_H
+
+// needed includes
+#include <cstddef>
+
+#include <cppdom/config.h>
+
+// namespace declaration
+namespace cppdom
+{
+namespace threads
+{
+   /** one job made of count independent pieces of work */
+   class Task
+   {
+   public:
+      virtual ~Task();
+
+      /**
+       * does the piece of work with the given index.
+       * may run in any thread and must not throw
+       */
+      virtual void run(std::size_t index) = 0;
+   };
+
+   /** returns the number of threads to use when the caller did not say */
+   unsigned defaultThreadCount();
+
+   /**
+    * runs task.run(i) for every i in [0, count) on up to numThreads
+    * threads (0 means defaultThreadCount()) and returns when all are done.
+    * without thread support everything runs in the calling thread
+    */
+   void runTasks(Task& task, std::size_t count, unsigned numThreads);
+}
+}
+
+#endif
@@ -44,10 +44,78 @@
 
 // needed includes
 #include "xmlparser.h"
+#include "base64.h"
 
 // namespace declaration
 namespace cppdom
 {
+   namespace
+   {
+      const char* const PiSpaces = " \t\r\n";
+
+      /**
+       * splits the text of a processing instruction into its target and
+       * returns where the data after it starts
+       */
+      std::string::size_type splitPi(const std::string& text, std::string& target)
+      {
+         const std::string::size_type first = text.find_first_not_of(PiSpaces);
+         if (first == std::string::npos)
+         {
+            throw CPPDOM_ERROR(xml_pi_doctype_expected, "");
+         }
+         std::string::size_type last = text.find_first_of(PiSpaces, first);
+         if (last == std::string::npos)
+         {
+            last = text.length();
+         }
+         target.assign(text, first, last - first);
+
+         const std::string::size_type data = text.find_first_not_of(PiSpaces, last);
+         return (data == std::string::npos) ? text.length() : data;
+      }
+
+      /** parses the name="value" pairs of a processing instruction's data */
+      void parsePiAttributes(const std::string& text, std::string::size_type pos, Attributes& attr)
+      {
+         while (true)
+         {
+            pos = text.find_first_not_of(PiSpaces, pos);
+            if (pos == std::string::npos)
+            {
+               return;
+            }
+
+            const std::string::size_type name_end = text.find_first_of(" \t\r\n=", pos);
+            std::string name(text, pos, name_end - pos);
+            pos = text.find_first_not_of(PiSpaces, name_end);
+            if (pos == std::string::npos || text[pos] != '=')
+            {
+               throw CPPDOM_ERROR(xml_attr_equal_expected, "");
+            }
+
+            pos = text.find_first_not_of(PiSpaces, pos + 1);
+            if (pos == std::string::npos || (text[pos] != '\"' && text[pos] != '\''))
+            {
+               throw CPPDOM_ERROR(xml_attr_value_expected, "");
+            }
+            const std::string::size_type value_end = text.find(text[pos], pos + 1);
+            if (value_end == std::string::npos)
+            {
+               throw CPPDOM_ERROR(xml_attr_value_expected, "");
+            }
+
+            std::string value(text, pos + 1, value_end - pos - 1);
+            if(textContainsXmlEscaping(value))
+            {  value = removeXmlEscaping(value, false); }
+
+            Attributes::value_type attrpair(name, value);
+            attr.insert(attrpair);
+            pos = value_end + 1;
+         }
+      }
+   }
+
    // Parser methods
    Parser::Parser(std::istream& in, Location& loc)
       : mInput(in), mTokenizer(in, loc)
@@ -99,6 +167,24 @@ namespace cppdom
       while(true)
       {
          ++mTokenizer;
+
+         // comments before the root element are not kept, the document
+         // has room for only one child
+         if (mTokenizer->isRaw())
+         {
+            switch (mTokenizer->getRawType())
+            {
+            case Token::raw_pi:
+               parseHeaderPi(doc, context);
+               break;
+            case Token::raw_comment:
+               break;
+            default:
+               throw CPPDOM_ERROR(xml_unknown, "");
+            }
+            continue;
+         }
+
          Token token1 = *mTokenizer;
          if (token1 != '<')
          {
@@ -119,40 +205,28 @@ namespace cppdom
          // now check for the literal
          switch(token2.getLiteral())
          {
-            // comment or doctype tag
+            // doctype tag
          case '!':
             {
                ++mTokenizer;
                Token token3 = *mTokenizer;
 
-               if (!token3.isLiteral())
+               if (!token3.isLiteral() && !token3.isRaw())
                {
-                  // now a doctype tag or a comment may follow
-                  if (token3.getGeneric().at(0) == '-' &&
-                      token3.getGeneric().at(1) == '-')
+                  std::string doctypestr(token3.getGeneric());
+
+                  std::transform(doctypestr.begin(), doctypestr.end(), doctypestr.begin(), toupper);
+
+                  if (doctypestr == "DOCTYPE")
                   {
-                      // needed to correctly handle <!---->
-                      Token temp_token(token3.getGeneric().substr(2));
-                      mTokenizer.putBack(temp_token);
-                      parseComment(context);
+                     // \todo parse doctype tag
+
+                     // read the complete tag till the closing >
+                     while (*(mTokenizer++) != '>');
                   }
                   else
                   {
-                     std::string doctypestr(token3.getGeneric());
-
-                     std::transform(doctypestr.begin(), doctypestr.end(), doctypestr.begin(), toupper);
-
-                     if (doctypestr == "DOCTYPE")
-                     {
-                        // \todo parse doctype tag
-
-                        // read the complete tag till the closing >
-                        while (*(mTokenizer++) != '>');
-                     }
-                     else
-                     {
-                        throw CPPDOM_ERROR(xml_unknown, "");
-                     }
+                     throw CPPDOM_ERROR(xml_unknown, "");
                   }
                }
                else
@@ -162,160 +236,222 @@ namespace cppdom
 
                break;
             }
-         case '?':
-            {
-               ++mTokenizer;
-               Token token3 = *mTokenizer;
+         default:
+            // unknown literal encountered
+            throw CPPDOM_ERROR(xml_pi_doctype_expected, "");
 
-               if (token3.isLiteral())
-               {
-                  throw CPPDOM_ERROR(xml_pi_doctype_expected, "");
-               }
+         } // end switch
+
+      } // end while
+   }
+
+   void Parser::parseHeaderPi(Document& doc, ContextPtr& context)
+   {
+      const std::string& text = mTokenizer->getGeneric();
 
-               // parse processing instruction
-               Node pinode(context);
+      // parse processing instruction
+      NodePtr nodeptr(new Node(context));
+      Node& pinode = *nodeptr;
 
-               std::string tagname(token3.getGeneric());
-               pinode.mNodeNameHandle = context->insertTagname(tagname);
+      std::string tagname;
+      const std::string::size_type data = splitPi(text, tagname);
+      pinode.mNodeNameHandle = context->insertTagname(tagname);
 #ifdef CPPDOM_DEBUG
-               pinode.mNodeName_debug = tagname;
+      pinode.mNodeName_debug = tagname;
 #endif
 
+      parsePiAttributes(text, data, pinode.attrib());
 
-               parseAttributes(pinode.attrib());
+      doc.mProcInstructions.push_back(nodeptr);
 
-               NodePtr nodeptr(new Node(pinode));
-               doc.mProcInstructions.push_back(nodeptr);
+      if (context->hasEventHandler())
+      {
+         context->getEventHandler().processingInstruction(pinode);
+      }
+   }
 
-               if (context->hasEventHandler())
-               {
-                  context->getEventHandler().processingInstruction(pinode);
-               }
+   bool Parser::parseMarkup(Node& node, ContextPtr& context)
+   {
+      Token& token = mTokenizer.get();
+      switch (token.getRawType())
+      {
+      case Token::raw_cdata:
+         // the section is text as it stands, it needs no unescaping
+         node.setName("cdata");
+         node.mNodeType = Node::xml_nt_cdata;
+         node.mCdataBinary = false;
+         token.swapGeneric(node.mCdata);
+         if (mTokenizer.getBase64Text() && !node.mCdata.empty())
+         {
+            // decoded in place, the bytes never overtake the text
+            base64::Decoder decoder;
+            unsigned char* bytes = reinterpret_cast<unsigned char*>(&node.mCdata[0]);
+            const unsigned char* end = decoder.decode(node.mCdata.data(),
+                                                      node.mCdata.data() + node.mCdata.size(),
+                                                      bytes);
+            if (end == NULL || !decoder.finished())
+            {
+               throw CPPDOM_ERROR(xml_invalid_base64, "");
+            }
+            node.mCdata.resize(end - bytes);
+            node.mCdataBinary = true;
+         }
+         if (context->hasEventHandler())
+         {
+            context->getEventHandler().gotCdata(node.getCdata());
+         }
+         return true;
 
-               ++mTokenizer;
-               if (*mTokenizer != '?')
-               {
-                  throw CPPDOM_ERROR(xml_pi_doctype_expected, "");
-               }
+      case Token::raw_base64:
+         node.setName("cdata");
+         node.mNodeType = Node::xml_nt_cdata;
+         node.mCdataBinary = true;
+         token.swapGeneric(node.mCdata);
+         if (context->hasEventHandler())
+         {
+            context->getEventHandler().gotCdata(node.getCdata());
+         }
+         return true;
 
-               ++mTokenizer;
-               if (*mTokenizer != '>')
-               {
-                  throw CPPDOM_ERROR(xml_closetag_expected, "");
-               }
-               break;
-            }
-         default:
-            // unknown literal encountered
-            throw CPPDOM_ERROR(xml_pi_doctype_expected, "");
+      case Token::raw_comment:
+         if (!context->getKeepComments())
+         {
+            return false;
+         }
+         node.setName("comment");
+         node.mNodeType = Node::xml_nt_comment;
+         node.mCdataBinary = false;
+         token.swapGeneric(node.mCdata);
+         return true;
 
-         } // end switch
+      case Token::raw_pi:
+         {
+            if (!context->getKeepProcessingInstructions())
+            {
+               return false;
+            }
+            std::string target;
+            const std::string::size_type data = splitPi(token.getGeneric(), target);
+            node.setName(target);
+            node.mNodeType = Node::xml_nt_pi;
+            node.mCdataBinary = false;
+            token.swapGeneric(node.mCdata);
+            node.mCdata.erase(0, data);
+            if (context->hasEventHandler())
+            {
+               context->getEventHandler().processingInstruction(node);
+            }
+            return true;
+         }
 
-      } // end while
+      default:
+         return false;
+      }
    }
 
    // parses the contents of the current node
    bool Parser::parseNode(Node& node, ContextPtr& context)
    {
+      // The next sibling takes the place of an element the filter skipped
+      bool skipped(false);
+      bool parsed(false);
+      do
+      {
+         parsed = parseNextNode(node, context, skipped);
+      }
+      while (skipped);
+      return parsed;
+   }
+
+   bool Parser::parseNextNode(Node& node, ContextPtr& context, bool& skipped)
+   {
+      skipped = false;
       node.mContext = context;
       bool handle = context->hasEventHandler();
 
       ++mTokenizer;
-      Token token1 = *mTokenizer;
 
-      if (token1.isEndOfStream())
+      // skip the comments and pis the context does not keep
+      while (mTokenizer->isRaw())
       {
-         return false;
+         if (parseMarkup(node, context))
+         {
+            return true;
+         }
+         ++mTokenizer;
       }
 
-      Token token2;
-
-      // loop when we encounter a comment
-      bool again;
-      do
+      if (mTokenizer->isEndOfStream())
       {
-         again = false;
+         return false;
+      }
 
-         // check if we have cdata
-         if (!token1.isLiteral())
-         {
-            std::string cdataname("cdata");
-            node.mNodeNameHandle = context->insertTagname(cdataname);
+      // check if we have cdata
+      if (!mTokenizer->isLiteral())
+      {
+         std::string cdataname("cdata");
+         node.mNodeNameHandle = context->insertTagname(cdataname);
 #ifdef CPPDOM_DEBUG
-            node.mNodeName_debug = cdataname;
+         node.mNodeName_debug = cdataname;
 #endif
 
-            // parse cdata section(s) and return
-            node.mNodeType = Node::xml_nt_cdata;
-            node.mCdata.empty();
-
-            while(!token1.isLiteral())
-            {
-               node.mCdata += token1.getGeneric();
-               ++mTokenizer;
-               token1 = *mTokenizer;
-            }
-            mTokenizer.putBack();
-
-            // Clean up the cdata escaping
-            if(textContainsXmlEscaping(node.mCdata))
-            {  node.mCdata = removeXmlEscaping(node.mCdata, true); }
+         // parse cdata section(s) and return
+         node.mNodeType = Node::xml_nt_cdata;
+         node.mCdataBinary = false;
+         node.mCdata.empty();
 
-            if (handle)
-            {
-               context->getEventHandler().gotCdata( node.mCdata );
-            }
-
-            return true;
-         }
-
-         // no cdata, try to continue parsing node content
-         // Must be a start of a node (ie. < literal)
-         if (token1 != '<')
+         // the first text token is swapped in, not copied
+         while(!mTokenizer->isLiteral() && !mTokenizer->isRaw())
          {
-            throw CPPDOM_ERROR(xml_opentag_cdata_expected, "");
+            if (node.mCdata.empty())
+            {  mTokenizer.get().swapGeneric(node.mCdata); }
+            else
+            {  node.mCdata += mTokenizer->getGeneric(); }
+            ++mTokenizer;
          }
+         mTokenizer.putBack();
 
-         // get node name
-         ++mTokenizer;
-         token2 = *mTokenizer;
-         if (token2.isLiteral())
+         // Clean up the cdata escaping
+         if(textContainsXmlEscaping(node.mCdata))
+         {  node.mCdata = removeXmlEscaping(node.mCdata, true); }
+
+         if (handle)
          {
-            // check the following literal
-            switch(token2.getLiteral())
-            {
-               // closing '</...>' follows
-            case '/':
-               // return, we have a closing node with no more content
-               mTokenizer.putBack();
-               mTokenizer.putBack(token1);
-               return false;
+            context->getEventHandler().gotCdata( node.mCdata );
+         }
 
-               // comment follows
-            case '!':
-               {
-                  // Consume the -- part of the comment opening string.
-                  ++mTokenizer;
+         return true;
+      }
 
-                  // needed to correctly handle <!---->
-                  Token temp_token(mTokenizer->getGeneric().substr(2));
-                  mTokenizer.putBack(temp_token);
-                  this->parseComment(context);
+      Token token1 = *mTokenizer;
+      Token token2;
 
-                  // get next token
-                  ++mTokenizer;
-                  token1 = *mTokenizer;
+      // no cdata, try to continue parsing node content
+      // Must be a start of a node (ie. < literal)
+      if (token1 != '<')
+      {
+         throw CPPDOM_ERROR(xml_opentag_cdata_expected, "");
+      }
 
-                  // parse again, until we encounter some useful data
-                  again = true;
-               }
-               break;
+      // get node name
+      ++mTokenizer;
+      token2 = *mTokenizer;
+      if (token2.isLiteral())
+      {
+         // check the following literal
+         switch(token2.getLiteral())
+         {
+            // closing '</...>' follows
+         case '/':
+            // return, we have a closing node with no more content
+            mTokenizer.putBack();
+            mTokenizer.putBack(token1);
+            return false;
 
-            default:
-               throw CPPDOM_ERROR(xml_tagname_expected, "");
-            }
+         default:
+            throw CPPDOM_ERROR(xml_tagname_expected, "");
          }
-      } while (again);
+      }
 
       // insert tag name and set handle for it
       std::string tagname(token2.getGeneric());
@@ -324,6 +460,25 @@ namespace cppdom
       node.mNodeName_debug = tagname;
 #endif
 
+      // skip the elements the filter rejects before anything else is read
+      ElementFilter* filter = context->getElementFilter().get();
+      if (filter != NULL)
+      {
+         mPath.push_back(node.mNodeNameHandle);
+         if (!filter->keepElement(mPath, *context))
+         {
+            // without its root the document would be left empty
+            if (mPath.size() == 1)
+            {
+               throw CPPDOM_ERROR(xml_invalid_operation, "The element filter rejected the root element");
+            }
+            mPath.pop_back();
+            mTokenizer.skipElement();
+            skipped = true;
+            return false;
+         }
+      }
+
       // notify event handler
       if (handle)
       {
@@ -352,6 +507,8 @@ namespace cppdom
          }
 
          node.mNodeType = Node::xml_nt_leaf;
+         if (filter != NULL)
+         {  mPath.pop_back(); }
 
          // return, let the caller continue to parse
          return true;
@@ -363,6 +520,15 @@ namespace cppdom
          throw CPPDOM_ERROR(xml_closetag_expected, "");
       }
 
+      // the text of base64 elements is decoded as it is read
+      const bool outer_base64 = mTokenizer.getBase64Text();
+      mTokenizer.setBase64Text(context->isBase64Element(node.mNodeNameHandle));
+
+      // the whitespace mode applies to element content only, never to the
+      // whitespace around the root element
+      const Context::WhitespaceMode outer_whitespace = mTokenizer.getWhitespaceMode();
+      mTokenizer.setWhitespaceMode(context->getWhitespaceMode());
+
       // loop to parse all subnodes
       while (true)
       {
@@ -382,6 +548,9 @@ namespace cppdom
          }
       }
 
+      mTokenizer.setBase64Text(outer_base64);
+      mTokenizer.setWhitespaceMode(outer_whitespace);
+
       // parse end tag
       Token token5 = *mTokenizer++;
       ++mTokenizer;
@@ -413,10 +582,34 @@ namespace cppdom
       {
          context->getEventHandler().endNode(node);
       }
+      if (filter != NULL)
+      {  mPath.pop_back(); }
 
       return true;
    }
 
+   void Parser::parseContent(Node& parent, ContextPtr& context)
+   {
+      // The '>' puts the tokenizer in the state it has after any tag
+      ++mTokenizer;
+      if (*mTokenizer != '>')
+      {
+         throw CPPDOM_ERROR(xml_closetag_expected, "");
+      }
+
+      mTokenizer.setBase64Text(context->isBase64Element(parent.getNameHandle()));
+      mTokenizer.setWhitespaceMode(context->getWhitespaceMode());
+      while (true)
+      {
+         NodePtr new_subnode(new Node(context));
+         if (!this->parseNode(*new_subnode, context))
+         {  break; }
+         parent.addChild(new_subnode);
+      }
+      mTokenizer.setBase64Text(false);
+      mTokenizer.setWhitespaceMode(Context::xml_ws_trim_leading);
+   }
+
    // parses tag attributes
    bool Parser::parseAttributes(Attributes& attr)
    {
@@ -464,30 +657,4 @@ namespace cppdom
       }
       return true;
    }
-
-   void Parser::parseComment(ContextPtr& context)
-   {
-      cppdom::ignore_unused_variable_warning(context);
-
-      // get tokens until comment is over
-      while (true)
-      {
-         ++mTokenizer;
-         if (mTokenizer->isEndOfStream())
-         {
-            throw CPPDOM_ERROR(xml_closetag_expected, "");
-         }
-
-         // Needed to handle -->s not preceded by whitespace
-         const std::string& s = mTokenizer->getGeneric();
-         if (s.length() >= 2 && (s.substr(s.length() - 2) == "--"))
-         {
-            ++mTokenizer;
-            if (*mTokenizer == '>')
-            {
-               break;
-            }
-         }
-      }
-   }
 }
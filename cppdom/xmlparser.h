@@ -67,6 +67,14 @@ namespace cppdom
       /** parses a node, without processing instructions */
       bool parseNode(Node& node, ContextPtr& context);
 
+      /**
+       * parses nodes up to a closing tag and adds them to parent.
+       *
+       * @pre The input starts at the '>' that ends the parent's start tag
+       *      or a previous sibling.
+       */
+      void parseContent(Node& parent, ContextPtr& context);
+
    protected:
       /** parses xml header, such as processing instructions, doctype etc. */
       bool parseHeader(Document& doc, ContextPtr& context);
@@ -75,11 +83,21 @@ namespace cppdom
       bool parseAttributes(Attributes& attr);
 
       /**
-       * parses a <!-- --> comment
+       * turns the current raw token (comment, cdata section or processing
+       * instruction) into node.
        *
-       * @pre The <!-- part of the comment has already been consumed.
+       * @return false when the context does not keep this kind of markup
        */
-      void parseComment(ContextPtr& context);   
+      bool parseMarkup(Node& node, ContextPtr& context);
+
+      /** parses a processing instruction before the root element into the document */
+      void parseHeaderPi(Document& doc, ContextPtr& context);
+
+      /**
+       * parseNode() for a single node. sets skipped instead when it skipped
+       * an element the element filter rejected.
+       */
+      bool parseNextNode(Node& node, ContextPtr& context, bool& skipped);
 
    protected:
       /** input stream */
@@ -87,6 +105,9 @@ namespace cppdom
 
       /** stream iterator */
       xmlstream_iterator mTokenizer;
+
+      /** handles of the open elements, kept while there is an element filter */
+      std::vector<TagNameHandle> mPath;
    };
 }
 
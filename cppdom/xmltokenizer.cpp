@@ -44,7 +44,11 @@
 
 // needed includes
 #include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <istream>
 #include "cppdom.h"
+#include "base64.h"
 #include "xmltokenizer.h"
 
 
@@ -55,17 +59,20 @@ namespace cppdom
    Token::Token()
       : mIsLiteral(true)
       , mLiteral(0)
+      , mRawType(raw_none)
    {}
 
    Token::Token(char ch)
       : mIsLiteral(true)
       , mLiteral(ch)
+      , mRawType(raw_none)
    {}
 
    Token::Token(const std::string& str)
       : mIsLiteral(false)
       , mLiteral(0)
       , mGeneric(str)
+      , mRawType(raw_none)
    {}
 
    bool Token::isLiteral() const
@@ -88,6 +95,21 @@ namespace cppdom
       return mGeneric;
    }
 
+   bool Token::isRaw() const
+   {
+      return mRawType != raw_none;
+   }
+
+   Token::RawType Token::getRawType() const
+   {
+      return mRawType;
+   }
+
+   void Token::swapGeneric(std::string& str)
+   {
+      mGeneric.swap(str);
+   }
+
    bool Token::operator==(char ch) const
    {
       return !isLiteral() ? false : ch == mLiteral;
@@ -100,7 +122,7 @@ namespace cppdom
 
    bool Token::operator==(const std::string& str) const
    {
-      return !isLiteral() ? str == mGeneric : false;
+      return (!isLiteral() && !isRaw()) ? str == mGeneric : false;
    }
 
    bool Token::operator!=(const std::string& str) const
@@ -112,6 +134,7 @@ namespace cppdom
    {
       mGeneric = str;
       mIsLiteral = false;
+      mRawType = raw_none;
       return *this;
    }
 
@@ -119,6 +142,7 @@ namespace cppdom
    {
       mLiteral = ch;
       mIsLiteral = true;
+      mRawType = raw_none;
       return *this;
    }
 
@@ -169,69 +193,443 @@ namespace cppdom
    }
 
    // xmlstream_iterator methods
+
+   namespace
+   {
+      /** size of the first block read from the input */
+      const std::size_t BlockSize = 16384;
+
+      /** whitespace in text, for the whitespace modes */
+      inline bool isTextSpace(char c)
+      {
+         return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+      }
+
+      /** returns the first occurrence of str in [begin, end), or NULL */
+      const char* findString(const char* begin, const char* end, const char* str, std::size_t len)
+      {
+         while (std::size_t(end - begin) >= len)
+         {
+            begin = static_cast<const char*>(std::memchr(begin, str[0], end - begin - len + 1));
+            if (begin == NULL)
+            {  return NULL; }
+            if (std::memcmp(begin, str, len) == 0)
+            {  return begin; }
+            ++begin;
+         }
+         return NULL;
+      }
+   }
+
    xmlstream_iterator::xmlstream_iterator(std::istream& in, Location& loc)
       : Tokenizer(in, loc)
       , mCdataMode(false)
-      , mPutbackChar(-1)
+      , mBase64Text(false)
+      , mWhitespaceMode(Context::xml_ws_trim_leading)
+      , mPos(0)
+      , mEnd(0)
    {}
 
-   /** \todo check for instr.eof() */
-   void xmlstream_iterator::getNext()
+   xmlstream_iterator::~xmlstream_iterator()
    {
-      // first use the token stack if filled
-      if (mTokenStack.size() != 0)
+      std::streambuf* buf = mInput.rdbuf();
+      std::size_t unread = mEnd - mPos;
+      if (buf == NULL || unread == 0)
+      {  return; }
+
+      if (buf->pubseekoff(-std::streamoff(unread), std::ios::cur, std::ios::in) ==
+          std::streampos(std::streamoff(-1)))
       {
-         // get the token from the stack and return it
-         Token tok;
-         mCurToken = mTokenStack.top();
-         mTokenStack.pop();
+         while (unread != 0 &&
+                !std::char_traits<char>::eq_int_type(buf->sputbackc(mBuffer[mPos + unread - 1]),
+                                                     std::char_traits<char>::eof()))
+         {  --unread; }
+      }
+   }
 
-         return;
+   void xmlstream_iterator::setBase64Text(bool decode)
+   {
+      mBase64Text = decode;
+   }
+
+   bool xmlstream_iterator::getBase64Text() const
+   {
+      return mBase64Text;
+   }
+
+   void xmlstream_iterator::setWhitespaceMode(Context::WhitespaceMode mode)
+   {
+      mWhitespaceMode = mode;
+   }
+
+   Context::WhitespaceMode xmlstream_iterator::getWhitespaceMode() const
+   {
+      return mWhitespaceMode;
+   }
+
+   bool xmlstream_iterator::fill()
+   {
+      typedef std::char_traits<char> traits;
+
+      std::streambuf* buf = mInput.rdbuf();
+      if (buf == NULL || !mInput.good())
+      {  return false; }
+
+      if (mPos != 0)
+      {
+         std::copy(mBuffer.begin() + mPos, mBuffer.begin() + mEnd, mBuffer.begin());
+         mEnd -= mPos;
+         mPos = 0;
+      }
+      if (mEnd == mBuffer.size())
+      {
+         // Markup longer than the buffer is kept whole, it gets twice the room
+         mBuffer.resize(std::max(mBuffer.size() * 2, BlockSize));
       }
 
-      bool finished = false;
+      // Take what the stream has buffered; only wait for input when it has
+      // none, so parsing from an interactive stream does not wait for a block
+      const std::size_t old_end = mEnd;
+      std::streamsize avail = buf->in_avail();
+      if (avail == 0)
+      {
+         const traits::int_type c = buf->sbumpc();
+         if (traits::eq_int_type(c, traits::eof()))
+         {  return false; }
+         mBuffer[mEnd++] = traits::to_char_type(c);
+         avail = buf->in_avail();
+      }
+      if (avail > 0)
+      {
+         const std::streamsize space(mBuffer.size() - mEnd);
+         mEnd += std::size_t(buf->sgetn(&mBuffer[mEnd], std::min(avail, space)));
+      }
+      return mEnd != old_end;
+   }
 
-      std::string generic;
+   bool xmlstream_iterator::ensure(std::size_t count)
+   {
+      while (mEnd - mPos < count)
+      {
+         if (!fill())
+         {  return false; }
+      }
+      return true;
+   }
 
-      // get next char
-      char c;
+   inline int xmlstream_iterator::nextChar()
+   {
+      if (mPos == mEnd && !fill())
+      {
+         mInput.setstate(std::ios::eofbit);
+         return EOF;
+      }
+      mLocation.step();
+      return static_cast<unsigned char>(mBuffer[mPos++]);
+   }
 
-      do
+   void xmlstream_iterator::advance(const char* begin, const char* end)
+   {
+      const char* line = begin;
+      for (const char* nl = line;
+           (nl = static_cast<const char*>(std::memchr(line, '\n', end - line))) != NULL;
+           line = nl + 1)
       {
-         if (mPutbackChar == char(-1))
+         mLocation.newline();
+      }
+      mLocation.step(int(end - line));
+   }
+
+   void xmlstream_iterator::scanText(std::string& str)
+   {
+      while (mPos != mEnd || fill())
+      {
+         const char* begin = &mBuffer[0] + mPos;
+         const char* end = &mBuffer[0] + mEnd;
+         const char* stop = static_cast<const char*>(std::memchr(begin, '<', end - begin));
+         const char* gt = static_cast<const char*>(
+            std::memchr(begin, '>', ((stop == NULL) ? end : stop) - begin));
+         if (gt != NULL)
+         {  stop = gt; }
+
+         const char* last = (stop == NULL) ? end : stop;
+         const char* keep = last;
+         if (stop != NULL && mWhitespaceMode == Context::xml_ws_trim)
          {
-            c = mInput.get();
-            mLocation.step();
+            // trailing whitespace is not copied; some may be in str already
+            // when the text spans blocks
+            while (keep != begin && isTextSpace(keep[-1]))
+            {  --keep; }
+            if (keep == begin)
+            {
+               std::string::size_type text_end = str.length();
+               while (text_end != 0 && isTextSpace(str[text_end - 1]))
+               {  --text_end; }
+               str.erase(text_end);
+            }
          }
-         else
+         str.append(begin, keep);
+         advance(begin, last);
+         mPos += last - begin;
+         if (stop != NULL)
+         {  return; }
+      }
+   }
+
+   void xmlstream_iterator::scanSpace(std::string& str)
+   {
+      // The run stays unread until the char after it tells if it is blank text
+      std::size_t count(0);
+      while ((mPos + count != mEnd || fill()) && isTextSpace(mBuffer[mPos + count]))
+      {
+         ++count;
+      }
+      const bool blank = (mPos + count == mEnd) || (mBuffer[mPos + count] == '<');
+
+      const char* begin = &mBuffer[0] + mPos;
+      if (!blank || mWhitespaceMode == Context::xml_ws_preserve)
+      {
+         str.assign(begin, count);
+      }
+      advance(begin, begin + count);
+      mPos += count;
+   }
+
+   void xmlstream_iterator::scanBase64()
+   {
+      std::string& data = mCurToken.mGeneric;
+      data.clear();
+
+      base64::Decoder decoder;
+      while (mPos != mEnd || fill())
+      {
+         const char* begin = &mBuffer[0] + mPos;
+         const char* end = &mBuffer[0] + mEnd;
+         const char* stop = static_cast<const char*>(std::memchr(begin, '<', end - begin));
+         const char* last = (stop == NULL) ? end : stop;
+         if (!decoder.decode(begin, last, data))
          {
-            c = mPutbackChar;
-            mPutbackChar = char(-1);
-            mLocation.step();
+            throw CPPDOM_ERROR(xml_invalid_base64, "");
          }
+         advance(begin, last);
+         mPos += last - begin;
+         if (stop != NULL)
+         {  break; }
+      }
+      if (!decoder.finished())
+      {
+         throw CPPDOM_ERROR(xml_invalid_base64, "Text ends inside a group");
+      }
 
-         // do we have an eof?
-         // TODO: check for instr.eof()
-         if (c == char(EOF))
+      mCurToken.mIsLiteral = false;
+      mCurToken.mLiteral = 0;
+      mCurToken.mRawType = Token::raw_base64;
+   }
+
+   void xmlstream_iterator::scanMarkup(Token::RawType type, std::size_t openLength,
+                                       const char* terminator)
+   {
+      mPos += openLength;
+      mLocation.step(int(openLength));
+
+      // The text stays in the buffer until the terminator shows up, so it is
+      // copied once, into a string of the right size
+      const std::size_t term_length = std::strlen(terminator);
+      std::size_t scanned(0);
+      const char* found = NULL;
+      while (true)
+      {
+         const char* begin = &mBuffer[0] + mPos;
+         found = findString(begin + scanned, &mBuffer[0] + mEnd, terminator, term_length);
+         if (found != NULL)
+         {  break; }
+         if (mEnd - mPos >= term_length)
+         {  scanned = mEnd - mPos - term_length + 1; }
+         if (!fill())
+         {
+            throw CPPDOM_ERROR(xml_closetag_expected,
+                               "Unterminated comment, cdata section or processing instruction");
+         }
+      }
+
+      const char* begin = &mBuffer[0] + mPos;
+      const char* end = found + term_length;
+      mCurToken.mGeneric.assign(begin, found);
+      mCurToken.mIsLiteral = false;
+      mCurToken.mLiteral = 0;
+      mCurToken.mRawType = type;
+      advance(begin, end);
+      mPos += end - begin;
+
+      // Text may follow, as after a '>'
+      mCdataMode = true;
+   }
+
+   void xmlstream_iterator::skipPast(const char* terminator)
+   {
+      const std::size_t length = std::strlen(terminator);
+      while (true)
+      {
+         const char* begin = &mBuffer[0] + mPos;
+         const char* end = &mBuffer[0] + mEnd;
+         const char* found = findString(begin, end, terminator, length);
+         if (found != NULL)
          {
-            if (generic.length() != 0)
+            advance(begin, found + length);
+            mPos += found + length - begin;
+            return;
+         }
+
+         // Only the chars that may start the terminator stay unread
+         const char* kept = end - std::min(std::size_t(end - begin), length - 1);
+         advance(begin, kept);
+         mPos += kept - begin;
+         if (!fill())
+         {  throw CPPDOM_ERROR(xml_closetag_expected, "Unterminated element"); }
+      }
+   }
+
+   void xmlstream_iterator::skipElement()
+   {
+      std::size_t depth(1);   // open elements, the skipped one included
+      bool in_tag(true);      // reading a start tag, up to its '>'
+      char quote('\0');       // delimiter of the quoted value being read
+      char last('\0');        // the char before the current one in a tag
+      while (depth != 0)
+      {
+         if (mPos == mEnd && !fill())
+         {  throw CPPDOM_ERROR(xml_closetag_expected, "Unterminated element"); }
+
+         const char* begin = &mBuffer[0] + mPos;
+         const char* end = &mBuffer[0] + mEnd;
+         if (in_tag)
+         {
+            const char* p = begin;
+            for (; p != end; ++p)
             {
-               mCurToken = c;
-               return;
+               if (quote != '\0')
+               {
+                  if (*p == quote)
+                  {  quote = '\0'; }
+               }
+               else if (*p == '"' || *p == '\'')
+               {  quote = *p; }
+               else if (*p == '>')
+               {  break; }
+               last = *p;
             }
-            else
+            if (p != end)
             {
-               break;
+               ++p;
+               in_tag = false;
+               if (last == '/')
+               {  --depth; }
             }
+            advance(begin, p);
+            mPos += p - begin;
+            continue;
+         }
+
+         // Content: only the next tag matters
+         const char* p = static_cast<const char*>(std::memchr(begin, '<', end - begin));
+         if (p == NULL)
+         {
+            advance(begin, end);
+            mPos = mEnd;
+            continue;
+         }
+         advance(begin, p);
+         mPos += p - begin;
+         ensure(9);
+
+         const char* tag = &mBuffer[0] + mPos;
+         const std::size_t avail = mEnd - mPos;
+         if (avail >= 4 && std::memcmp(tag, "<!--", 4) == 0)
+         {  skipPast("-->"); }
+         else if (avail >= 9 && std::memcmp(tag, "<![CDATA[", 9) == 0)
+         {  skipPast("]]>"); }
+         else if (avail >= 2 && tag[1] == '?')
+         {  skipPast("?>"); }
+         else if (avail >= 2 && (tag[1] == '/' || tag[1] == '!'))
+         {
+            if (tag[1] == '/')
+            {  --depth; }
+            skipPast(">");
+         }
+         else
+         {
+            ++mPos;
+            mLocation.step();
+            in_tag = true;
+            last = '\0';
+            ++depth;
+         }
+      }
+
+      // Text may follow, as after a '>'
+      mCdataMode = true;
+   }
+
+   /** \todo check for instr.eof() */
+   void xmlstream_iterator::getNext()
+   {
+      // first use the token stack if filled
+      if (mTokenStack.size() != 0)
+      {
+         // get the token from the stack and return it; the string is swapped
+         // so raw markup is not copied again
+         Token& top = mTokenStack.top();
+         mCurToken.mIsLiteral = top.mIsLiteral;
+         mCurToken.mLiteral = top.mLiteral;
+         mCurToken.mRawType = top.mRawType;
+         mCurToken.mGeneric.swap(top.mGeneric);
+         mTokenStack.pop();
+
+         return;
+      }
+
+      std::string generic;
+
+      while (true)
+      {
+         const int c = nextChar();
+
+         // do we have an eof?
+         if (c == EOF)
+         {
+            mCurToken = char(EOF);
+            return;
          }
 
          // is it a literal?
-         if (isLiteral(c))
+         if (isLiteral(char(c)))
          {
             mCdataMode = false;
             if (generic.length() == 0)
             {
-               mCurToken = c;
+               // comments, cdata sections and pis are read as a whole
+               if (c == '<' && ensure(1))
+               {
+                  const char* next = &mBuffer[0] + mPos;
+                  if (*next == '?')
+                  {
+                     scanMarkup(Token::raw_pi, 1, "?>");
+                     return;
+                  }
+                  if (*next == '!' && ensure(3) && next[1] == '-' && next[2] == '-')
+                  {
+                     scanMarkup(Token::raw_comment, 3, "-->");
+                     return;
+                  }
+                  if (*next == '!' && ensure(8) &&
+                      std::memcmp(&mBuffer[0] + mPos, "![CDATA[", 8) == 0)
+                  {
+                     scanMarkup(Token::raw_cdata, 8, "]]>");
+                     return;
+                  }
+               }
+
+               mCurToken = char(c);
 
                // quick fix for removing set_cdataMode() functionality
                if (c == '>')
@@ -241,32 +639,42 @@ namespace cppdom
 
                return;
             }
-            mPutbackChar = c;
+            --mPos;
             mLocation.step(-1);
             break;
          }
 
          // a string delimiter and not in cdata mode?
-         if (isStringDelimiter(c) && !mCdataMode)
+         if (isStringDelimiter(char(c)) && !mCdataMode)
          {
-            generic = c;
-            char delim = c;
-            do
+            generic = char(c);
+            while (mPos != mEnd || fill())
             {
-               c = mInput.get();
-               mLocation.step();
-               if (c == char(EOF))
-               {
-                  break;
-               }
-               generic += c;
+               const char* begin = &mBuffer[0] + mPos;
+               const char* delim = static_cast<const char*>(std::memchr(begin, c, mEnd - mPos));
+               const std::size_t count = (delim == NULL) ? (mEnd - mPos) : (delim - begin + 1);
+               generic.append(begin, count);
+               mLocation.step(int(count));
+               mPos += count;
+               if (delim != NULL)
+               {  break; }
             }
-            while (c != delim);
             break;
          }
 
+         // whitespace that starts a text, in the modes that may keep it
+         if (mCdataMode && generic.length() == 0 && isTextSpace(char(c)) && !mBase64Text &&
+             (mWhitespaceMode == Context::xml_ws_drop_blank ||
+              mWhitespaceMode == Context::xml_ws_preserve))
+         {
+            --mPos;
+            mLocation.step(-1);
+            scanSpace(generic);
+            continue;
+         }
+
          // a whitespace?
-         if (isWhiteSpace(c))
+         if (isWhiteSpace(char(c)))
          {
             if (generic.length() == 0)
             {
@@ -282,7 +690,7 @@ namespace cppdom
          }
 
          // a newline char?
-         if (isNewLine(c) )
+         if (isNewLine(char(c)) )
          {
             if (!mCdataMode || generic.length() == 0)
             {
@@ -290,13 +698,29 @@ namespace cppdom
             }
          }
 
+         // base64 text is decoded from the buffer, it is never held as text
+         if (mCdataMode && mBase64Text && generic.length() == 0)
+         {
+            --mPos;
+            mLocation.step(-1);
+            scanBase64();
+            return;
+         }
+
          // add to generic string
-         generic += c;
+         generic += char(c);
+
+         // text runs up to the next tag
+         if (mCdataMode)
+         {
+            scanText(generic);
+         }
       }
-      while (!finished);
 
       // set the generic string
-      mCurToken = generic;
+      mCurToken.mGeneric.swap(generic);
+      mCurToken.mIsLiteral = false;
+      mCurToken.mRawType = Token::raw_none;
    }
 
    // returns if we have a literal char
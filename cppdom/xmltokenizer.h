@@ -49,6 +49,7 @@
 // needed includes
 #include <string>
 #include <stack>
+#include <vector>
 #include <iosfwd>
 
 
@@ -57,11 +58,24 @@ namespace cppdom
 {
    /// xml token
    /** an Token is a representation for a literal character or a
-       generic string (not recognized as a literal) */
+       generic string (not recognized as a literal). comments, cdata
+       sections and processing instructions are raw tokens: the generic
+       string holds the text between their delimiters */
    class Token
    {
+      friend class Tokenizer;
       friend class xmlstream_iterator;
    public:
+      /// kinds of markup read as one raw token
+      enum RawType
+      {
+         raw_none,      /**< a literal or generic token */
+         raw_comment,   /**< <!-- --> */
+         raw_cdata,     /**< <![CDATA[ ]]> */
+         raw_pi,        /**< <? ?> */
+         raw_base64     /**< base64 text, the generic string holds its bytes */
+      };
+
       Token();
       Token(char ch);
       Token(const std::string& str);
@@ -78,6 +92,15 @@ namespace cppdom
       /// returns generic string
       const std::string& getGeneric() const;
 
+      /// returns if the token is a comment, cdata section or processing instruction
+      bool isRaw() const;
+
+      /// returns the kind of markup of a raw token
+      RawType getRawType() const;
+
+      /// swaps the generic string with str, takes large texts out without a copy
+      void swapGeneric(std::string& str);
+
       // operators
 
       /// compare operator for literals
@@ -107,6 +130,9 @@ namespace cppdom
 
       /// pointer to string
       std::string mGeneric;
+
+      /// kind of markup of a raw token
+      RawType mRawType;
    };
 
 
@@ -162,6 +188,11 @@ namespace cppdom
    /**
     * xml input stream iterator
     * an iterator through all Token contained in the xml input stream
+    *
+    * the input is read in blocks. text, quoted values and raw markup are
+    * found by scanning the block for their end, not char by char. the
+    * input read ahead is handed back to the stream on destruction, where
+    * the stream can seek or put it back.
     */
    class xmlstream_iterator : public Tokenizer
    {
@@ -169,9 +200,61 @@ namespace cppdom
       /** ctor */
       xmlstream_iterator(std::istream& in, Location& loc);
 
+      /** dtor, hands the unread input back to the stream */
+      ~xmlstream_iterator();
+
+      /** decodes text as base64 into raw_base64 tokens from now on */
+      void setBase64Text(bool decode);
+
+      /** returns if text is decoded as base64 */
+      bool getBase64Text() const;
+
+      /** handles the whitespace of text as mode says from now on */
+      void setWhitespaceMode(Context::WhitespaceMode mode);
+
+      /** returns how the whitespace of text is handled */
+      Context::WhitespaceMode getWhitespaceMode() const;
+
+      /**
+       * skips the rest of the element whose name was the last token read,
+       * up to and including its end tag, by balancing the tags only.
+       * @pre no token has been put back
+       */
+      void skipElement();
+
    protected:
       void getNext();
 
+      /** moves the unread input to the front of the buffer and reads more;
+          returns false at the end of the input */
+      bool fill();
+
+      /** makes count unread chars available; false if the input ends first */
+      bool ensure(std::size_t count);
+
+      /** returns the next char, or EOF at the end of the input */
+      int nextChar();
+
+      /** appends text up to the next < or > to str */
+      void scanText(std::string& str);
+
+      /** decodes base64 text up to the next < into a raw_base64 token */
+      void scanBase64();
+
+      /** reads the whitespace that starts a text into str, unless the
+          whitespace mode drops it */
+      void scanSpace(std::string& str);
+
+      /** reads markup up to terminator as a raw token; the '<' and
+          openLength more chars of the opening are already read */
+      void scanMarkup(Token::RawType type, std::size_t openLength, const char* terminator);
+
+      /** skips the input up to and including terminator */
+      void skipPast(const char* terminator);
+
+      /** moves the location over the chars in [begin, end) */
+      void advance(const char* begin, const char* end);
+
       // internally used to recognize chars in the stream
       bool isLiteral(char c);
       bool isWhiteSpace(char c);
@@ -181,8 +264,16 @@ namespace cppdom
       /** cdata-mode doesn't care for whitespaces in generic strings */
       bool mCdataMode;
 
-      /** char which was put back internally */
-      char mPutbackChar;
+      /** text is decoded as base64 */
+      bool mBase64Text;
+
+      /** whitespace handling of text */
+      Context::WhitespaceMode mWhitespaceMode;
+
+      /** input read ahead, unread from mPos to mEnd */
+      std::vector<char> mBuffer;
+      std::size_t mPos;
+      std::size_t mEnd;
    };
 
    /**
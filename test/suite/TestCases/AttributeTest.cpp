@@ -0,0 +1,386 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ *
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+#include <TestCases/AttributeTest.h>
+
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#include <cppdom/cppdom.h>
+
+#ifdef CPPDOM_HAS_STD_THREAD
+#  include <thread>
+#endif
+
+namespace cppdomtest
+{
+CPPUNIT_TEST_SUITE_REGISTRATION(AttributeTest);
+
+namespace
+{
+   /** A user type that only has stream operators. */
+   struct Vec2
+   {
+      Vec2() : x(0), y(0) {}
+      Vec2(int x_, int y_) : x(x_), y(y_) {}
+      int x, y;
+   };
+
+   std::ostream& operator<<(std::ostream& out, const Vec2& v)
+   {
+      return out << v.x << ' ' << v.y;
+   }
+
+   std::istream& operator>>(std::istream& in, Vec2& v)
+   {
+      return in >> v.x >> v.y;
+   }
+
+   /** Gives the tests a look at the cached value. */
+   class CacheProbe : public cppdom::Attribute
+   {
+   public:
+      CacheProbe(const cppdom::Attribute& attr)
+         : cppdom::Attribute(attr)
+      {}
+
+      template<class T>
+      bool isCached(T expected) const
+      {
+         T value;
+         return loadCache(cppdom::AttributeCacheType<T>::value, &value, sizeof(T)) &&
+                value == expected;
+      }
+   };
+}
+
+void AttributeTest::testNumbers()
+{
+   cppdom::Attribute attr;
+
+   attr.setValue(42);
+   CPPUNIT_ASSERT_EQUAL(std::string("42"), attr.getString());
+   CPPUNIT_ASSERT_EQUAL(42, attr.getValue<int>());
+
+   attr.setValue(-7L);
+   CPPUNIT_ASSERT_EQUAL(std::string("-7"), attr.getString());
+   CPPUNIT_ASSERT_EQUAL(-7L, attr.getValue<long>());
+
+   attr.setValue(std::numeric_limits<int>::min());
+   CPPUNIT_ASSERT_EQUAL(std::numeric_limits<int>::min(), attr.getValue<int>());
+
+   attr.setValue(std::numeric_limits<unsigned long>::max());
+   CPPUNIT_ASSERT_EQUAL(std::numeric_limits<unsigned long>::max(),
+                        attr.getValue<unsigned long>());
+
+#ifdef CPPDOM_HAS_LONG_LONG
+   const long long big = -1234567890123LL;
+   attr.setValue(big);
+   CPPUNIT_ASSERT_EQUAL(std::string("-1234567890123"), attr.getString());
+   CPPUNIT_ASSERT(attr.getValue<long long>() == big);
+#endif
+
+   // Floating point values are written like a default ostream writes them
+   attr.setValue(1.5);
+   CPPUNIT_ASSERT_EQUAL(std::string("1.5"), attr.getString());
+   CPPUNIT_ASSERT_EQUAL(1.5, attr.getValue<double>());
+
+   attr.setValue(3.14159265f);
+   CPPUNIT_ASSERT_EQUAL(std::string("3.14159"), attr.getString());
+
+   attr.setValue(1e-10);
+   CPPUNIT_ASSERT_EQUAL(std::string("1e-10"), attr.getString());
+
+   attr.setValue(1234567.0);
+   CPPUNIT_ASSERT_EQUAL(std::string("1.23457e+06"), attr.getString());
+
+   // Surrounding whitespace and a leading '+' are accepted
+   cppdom::Attribute padded(std::string("  +12\n"));
+   CPPUNIT_ASSERT_EQUAL(12, padded.getValue<int>());
+   cppdom::Attribute real(std::string(" -2.5e3 "));
+   CPPUNIT_ASSERT_EQUAL(-2500.0f, real.getValue<float>());
+
+   // Node::setAttribute goes through the same conversion
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Node node("node", ctx);
+   node.setAttribute("count", 17u);
+   node.setAttribute("scale", 0.25);
+   CPPUNIT_ASSERT_EQUAL(std::string("17"), node.getAttribute("count").getString());
+   CPPUNIT_ASSERT_EQUAL(17u, node.getAttribute("count").getValue<unsigned>());
+   CPPUNIT_ASSERT_EQUAL(0.25, node.getAttribute("scale").getValue<double>());
+}
+
+void AttributeTest::testBool()
+{
+   cppdom::Attribute attr;
+   attr.setValue(true);
+   CPPUNIT_ASSERT_EQUAL(std::string("1"), attr.getString());
+   CPPUNIT_ASSERT(attr.getValue<bool>());
+   attr.setValue(false);
+   CPPUNIT_ASSERT_EQUAL(std::string("0"), attr.getString());
+   CPPUNIT_ASSERT(!attr.getValue<bool>());
+
+   bool value = false;
+   CPPUNIT_ASSERT(cppdom::Attribute(std::string("true")).tryGetValue(value));
+   CPPUNIT_ASSERT(value);
+   CPPUNIT_ASSERT(cppdom::Attribute(std::string(" false ")).tryGetValue(value));
+   CPPUNIT_ASSERT(!value);
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("yes")).tryGetValue(value));
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("2")).tryGetValue(value));
+}
+
+void AttributeTest::testInvalid()
+{
+   int i = 5;
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("")).tryGetValue(i));
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("   ")).tryGetValue(i));
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("12abc")).tryGetValue(i));
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("1 2")).tryGetValue(i));
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("+-3")).tryGetValue(i));
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("1.5")).tryGetValue(i));
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("99999999999999999999")).tryGetValue(i));
+   CPPUNIT_ASSERT_EQUAL(5, i);
+
+   // getValue reads the leading part like operator>>, else gives T()
+   CPPUNIT_ASSERT_EQUAL(0, cppdom::Attribute(std::string("abc")).getValue<int>());
+   CPPUNIT_ASSERT_EQUAL(1, cppdom::Attribute(std::string("1.5")).getValue<int>());
+   CPPUNIT_ASSERT_EQUAL(12, cppdom::Attribute(std::string(" 12abc")).getValue<int>());
+   CPPUNIT_ASSERT_EQUAL(2.5, cppdom::Attribute(std::string("2.5 m")).getValue<double>());
+
+   short s = 1;
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("40000")).tryGetValue(s));
+   unsigned u = 1;
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("-1")).tryGetValue(u));
+   CPPUNIT_ASSERT_EQUAL(short(1), s);
+   CPPUNIT_ASSERT_EQUAL(1u, u);
+
+   float f = 1.0f;
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("1e300")).tryGetValue(f));
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("1.0.0")).tryGetValue(f));
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("0x1p4")).tryGetValue(f));
+   CPPUNIT_ASSERT_EQUAL(1.0f, f);
+   CPPUNIT_ASSERT_EQUAL(0.0, cppdom::Attribute(std::string("0x1p4")).getValue<double>());
+}
+
+void AttributeTest::testStreamFallback()
+{
+   cppdom::Attribute attr(Vec2(3, -4));
+   CPPUNIT_ASSERT_EQUAL(std::string("3 -4"), attr.getString());
+
+   Vec2 v;
+   CPPUNIT_ASSERT(attr.tryGetValue(v));
+   CPPUNIT_ASSERT_EQUAL(3, v.x);
+   CPPUNIT_ASSERT_EQUAL(-4, v.y);
+
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("3 -4 5")).tryGetValue(v));
+   CPPUNIT_ASSERT(!cppdom::Attribute(std::string("3")).tryGetValue(v));
+
+   // Strings are taken whole, not word by word
+   std::string text;
+   CPPUNIT_ASSERT(cppdom::Attribute(std::string(" two words ")).tryGetValue(text));
+   CPPUNIT_ASSERT_EQUAL(std::string(" two words "), text);
+}
+
+void AttributeTest::testCache()
+{
+   cppdom::Attribute attr(std::string("2.5"));
+   CPPUNIT_ASSERT(!CacheProbe(attr).isCached(2.5f));
+
+   CPPUNIT_ASSERT_EQUAL(2.5f, attr.getValue<float>());
+   CPPUNIT_ASSERT(CacheProbe(attr).isCached(2.5f));
+   CPPUNIT_ASSERT_EQUAL(2.5f, attr.getValue<float>());
+
+   // Other types still parse the string, and do not replace the cache
+   CPPUNIT_ASSERT_EQUAL(2.5, attr.getValue<double>());
+   CPPUNIT_ASSERT_EQUAL(2, attr.getValue<int>());
+   CPPUNIT_ASSERT(CacheProbe(attr).isCached(2.5f));
+   CPPUNIT_ASSERT(!CacheProbe(attr).isCached(2.5));
+
+   // Copies keep the parsed value
+   cppdom::Attribute copy(attr);
+   CPPUNIT_ASSERT(CacheProbe(copy).isCached(2.5f));
+   copy = cppdom::Attribute(std::string("7"));
+   CPPUNIT_ASSERT(!CacheProbe(copy).isCached(2.5f));
+   CPPUNIT_ASSERT_EQUAL(7.0f, copy.getValue<float>());
+
+   // Writes drop it, the string stays canonical
+   attr.setValue(4);
+   CPPUNIT_ASSERT(!CacheProbe(attr).isCached(2.5f));
+   CPPUNIT_ASSERT_EQUAL(std::string("4"), attr.getString());
+   CPPUNIT_ASSERT_EQUAL(4.0f, attr.getValue<float>());
+   CPPUNIT_ASSERT(CacheProbe(attr).isCached(4.0f));
+
+   // Through the node's attribute map
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Node node("node", ctx);
+   node.setAttribute("gain", 0.5f);
+   cppdom::Attributes& attrs = node.attrib();
+   CPPUNIT_ASSERT_EQUAL(0.5f, attrs["gain"].getValue<float>());
+   attrs.set("gain", cppdom::Attribute(std::string("0.75")));
+   CPPUNIT_ASSERT_EQUAL(0.75f, attrs["gain"].getValue<float>());
+   node.setAttribute("gain", 1.25f);
+   CPPUNIT_ASSERT_EQUAL(1.25f, node.getAttribute("gain").getValue<float>());
+
+   std::ostringstream out;
+   node.save(out);
+   CPPUNIT_ASSERT(out.str().find("gain=\"1.25\"") != std::string::npos);
+}
+
+#ifdef CPPDOM_HAS_STD_THREAD
+namespace
+{
+   void readAttribute(const cppdom::Attribute* attr, bool* ok)
+   {
+      for (unsigned i = 0; i < 1000; ++i)
+      {
+         if (attr->getValue<double>() != 0.125 || attr->getValue<int>() != 0)
+         {
+            *ok = false;
+            return;
+         }
+      }
+      *ok = true;
+   }
+}
+#endif
+
+void AttributeTest::testConcurrentCache()
+{
+#ifdef CPPDOM_HAS_STD_THREAD
+   const unsigned num_threads = 8;
+   for (unsigned round = 0; round < 20; ++round)
+   {
+      cppdom::Attribute attr(std::string("0.125"));
+      bool ok[num_threads];
+      std::vector<std::thread> threads;
+      for (unsigned t = 0; t < num_threads; ++t)
+      {
+         threads.push_back(std::thread(readAttribute, &attr, &ok[t]));
+      }
+      for (unsigned t = 0; t < num_threads; ++t)
+      {
+         threads[t].join();
+         CPPUNIT_ASSERT(ok[t]);
+      }
+      CPPUNIT_ASSERT(CacheProbe(attr).isCached(0.125));
+   }
+#endif
+}
+
+void AttributeTest::testArrays()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Node node("node", ctx);
+
+   node.setAttribute("pos", std::string(" 1.5  -2\t3e2\n"));
+   std::vector<float> pos;
+   CPPUNIT_ASSERT(node.getAttributeArray("pos", pos));
+   CPPUNIT_ASSERT_EQUAL(std::size_t(3), pos.size());
+   CPPUNIT_ASSERT_EQUAL(1.5f, pos[0]);
+   CPPUNIT_ASSERT_EQUAL(-2.0f, pos[1]);
+   CPPUNIT_ASSERT_EQUAL(300.0f, pos[2]);
+
+   // Round trip
+   std::vector<int> ids;
+   ids.push_back(3);
+   ids.push_back(-40);
+   ids.push_back(500);
+   node.setAttributeArray("ids", ids);
+   CPPUNIT_ASSERT_EQUAL(std::string("3 -40 500"), node.getAttribute("ids").getString());
+   std::vector<int> read_ids;
+   CPPUNIT_ASSERT(node.getAttributeArray("ids", read_ids));
+   CPPUNIT_ASSERT(read_ids == ids);
+
+   std::vector<double> scale(2, 0.25);
+   node.setAttributeArray("scale", scale);
+   CPPUNIT_ASSERT_EQUAL(std::string("0.25 0.25"), node.getAttribute("scale").getString());
+
+   // Empty, missing and malformed
+   node.setAttributeArray("none", std::vector<double>());
+   CPPUNIT_ASSERT_EQUAL(std::string(""), node.getAttribute("none").getString());
+   CPPUNIT_ASSERT(node.getAttributeArray("none", pos));
+   CPPUNIT_ASSERT(pos.empty());
+   read_ids.push_back(1);
+   CPPUNIT_ASSERT(!node.getAttributeArray("missing", read_ids));
+   CPPUNIT_ASSERT(read_ids.empty());
+   node.setAttribute("bad", std::string("1 2 x 4"));
+   CPPUNIT_ASSERT(!node.getAttributeArray("bad", read_ids));
+   CPPUNIT_ASSERT_EQUAL(std::size_t(2), read_ids.size());
+   node.setAttribute("bad", std::string("1 2.5"));
+   CPPUNIT_ASSERT(!node.getAttributeArray("bad", read_ids));
+
+   // Types without built-in conversion use their stream operators
+   std::vector<std::string> words;
+   node.setAttribute("words", std::string("alpha  beta gamma"));
+   CPPUNIT_ASSERT(node.getAttributeArray("words", words));
+   CPPUNIT_ASSERT_EQUAL(std::size_t(3), words.size());
+   CPPUNIT_ASSERT_EQUAL(std::string("gamma"), words[2]);
+   std::string text;
+   cppdom::formatArray(text, words);
+   CPPUNIT_ASSERT_EQUAL(std::string("alpha beta gamma"), text);
+}
+
+void AttributeTest::testCdataArrays()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Document doc(ctx);
+   std::istringstream in("<samples rate='4'>\n  0.5 1 1.5\n  2<!-- gap --> 2.5\n</samples>");
+   doc.load(in, ctx);
+   cppdom::NodePtr samples = doc.getChild("samples");
+   CPPUNIT_ASSERT(samples.get() != NULL);
+
+   // The cdata pieces on either side of the comment are joined
+   std::vector<double> values;
+   CPPUNIT_ASSERT(samples->getCdataArray(values));
+   CPPUNIT_ASSERT_EQUAL(std::size_t(5), values.size());
+   CPPUNIT_ASSERT_EQUAL(0.5, values[0]);
+   CPPUNIT_ASSERT_EQUAL(2.5, values[4]);
+
+   cppdom::Node matrix("matrix", ctx);
+   std::vector<float> identity(9, 0.0f);
+   identity[0] = identity[4] = identity[8] = 1.0f;
+   matrix.setCdataArray(identity);
+   CPPUNIT_ASSERT_EQUAL(std::string("1 0 0 0 1 0 0 0 1"), matrix.getCdata());
+   std::vector<float> read;
+   CPPUNIT_ASSERT(matrix.getCdataArray(read));
+   CPPUNIT_ASSERT(read == identity);
+}
+
+}
@@ -0,0 +1,214 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ *
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+#include <TestCases/BinaryTest.h>
+#include <TestCases/TestData.h>
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include <cppdom/cppdom.h>
+#include <cppdom/binary.h>
+
+namespace cppdomtest
+{
+CPPUNIT_TEST_SUITE_REGISTRATION(BinaryTest);
+
+void BinaryTest::testRoundTrip()
+{
+   std::vector<std::string> filenames;
+   filenames.push_back(cppdomtest::game_xml_filename);
+   filenames.push_back(cppdomtest::nodetest_xml_filename);
+   filenames.push_back(cppdomtest::hamlet_xml_filename);
+
+   for (unsigned i = 0; i < filenames.size(); ++i)
+   {
+      cppdom::ContextPtr ctx(new cppdom::Context);
+      cppdom::DocumentPtr doc(new cppdom::Document(ctx));
+      doc->loadFile(filenames[i]);
+
+      std::stringstream image;
+      doc->saveBinary(image);
+
+      // Load into an unrelated context so that handles differ
+      cppdom::ContextPtr other_ctx(new cppdom::Context);
+      other_ctx->insertTagname("unrelated");
+      cppdom::DocumentPtr copy(new cppdom::Document(other_ctx));
+      copy->loadBinary(image);
+
+      CPPUNIT_ASSERT(copy->isEqual(doc));
+      CPPUNIT_ASSERT(copy->getPiList().size() == doc->getPiList().size());
+      CPPUNIT_ASSERT(copy->isDocument());
+   }
+}
+
+void BinaryTest::testView()
+{
+   cppdom::DocumentPtr doc(new cppdom::Document);
+   doc->loadFile(cppdomtest::game_xml_filename);
+
+   std::stringstream stream;
+   doc->saveBinary(stream);
+
+   cppdom::BinaryDocument image;
+   image.load(stream);
+   CPPUNIT_ASSERT(image.isOpen());
+
+   cppdom::BinaryNode root = image.getRootElement();
+   CPPUNIT_ASSERT(root.isValid());
+   CPPUNIT_ASSERT(std::string("gameinput") == root.getName());
+   CPPUNIT_ASSERT(root.getChildCount() == 10);
+   CPPUNIT_ASSERT(root.getParent().getIndex() == image.getDocument().getIndex());
+
+   cppdom::BinaryNode bind = root.getChild("bind");
+   CPPUNIT_ASSERT(bind.isValid());
+   CPPUNIT_ASSERT(std::string("Accelerate") == bind.getAttribute("action"));
+   CPPUNIT_ASSERT(bind.hasAttribute("device"));
+   CPPUNIT_ASSERT(!bind.hasAttribute("missing"));
+   CPPUNIT_ASSERT(std::string("") == bind.getAttribute("missing"));
+   CPPUNIT_ASSERT(bind.getType() == cppdom::Node::xml_nt_leaf);
+
+   // Siblings are in document order
+   unsigned count(0);
+   for (cppdom::BinaryNode c = root.getFirstChild(); c.isValid(); c = c.getNextSibling())
+   {  ++count; }
+   CPPUNIT_ASSERT(count == root.getChildCount());
+
+   cppdom::BinaryNode bok = root.getChild("bokbokbok");
+   CPPUNIT_ASSERT(std::string("hi man") == bok.getAttribute("noattrs"));
+   CPPUNIT_ASSERT(!root.getChild("not_there").isValid());
+}
+
+void BinaryTest::testMapFile()
+{
+   const std::string filename("BinaryTestDoc.cpdb");
+
+   cppdom::DocumentPtr doc(new cppdom::Document);
+   doc->loadFile(cppdomtest::nodetest_xml_filename);
+   doc->saveBinaryFile(filename);
+
+   {
+      cppdom::BinaryDocument image;
+      image.mapFile(filename);
+      cppdom::BinaryNode child = image.getRootElement().getChild("gp")
+                                    .getChild("parent").getChild("child");
+      CPPUNIT_ASSERT(child.isValid());
+      CPPUNIT_ASSERT(std::string("21") == child.getAttribute("val"));
+   }
+
+   cppdom::DocumentPtr copy(new cppdom::Document);
+   copy->loadBinaryFile(filename);
+   CPPUNIT_ASSERT(copy->isEqual(doc));
+
+   std::remove(filename.c_str());
+}
+
+void BinaryTest::testInvalidImage()
+{
+   cppdom::DocumentPtr doc(new cppdom::Document);
+   doc->loadFile(cppdomtest::game_xml_filename);
+   std::stringstream stream;
+   doc->saveBinary(stream);
+   std::string bytes = stream.str();
+
+   // Truncated image
+   std::istringstream truncated(bytes.substr(0, bytes.size() / 2));
+   cppdom::BinaryDocument image;
+   CPPUNIT_ASSERT_THROW(image.load(truncated), cppdom::Error);
+   CPPUNIT_ASSERT(!image.isOpen());
+
+   // Wrong magic
+   bytes[0] = 'X';
+   std::istringstream bad_magic(bytes);
+   CPPUNIT_ASSERT_THROW(image.load(bad_magic), cppdom::Error);
+
+   // Not an image at all
+   std::istringstream text("<xml/>");
+   CPPUNIT_ASSERT_THROW(doc->loadBinary(text), cppdom::Error);
+
+   // Empty text pointing outside the pool
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Document small(ctx);
+   std::istringstream small_xml("<r>text</r>");
+   small.load(small_xml, ctx);
+   std::stringstream small_stream;
+   small.saveBinary(small_stream);
+   std::string small_bytes = small_stream.str();
+   cppdom::binary::Header header;
+   std::memcpy(&header, small_bytes.data(), sizeof(header));
+   const std::size_t nodes = sizeof(header) + header.mNameCount * sizeof(cppdom::binary::NameRecord);
+   for (cppdom::binary::Word n = 0; n < header.mNodeCount; ++n)
+   {
+      const std::size_t at = nodes + n * sizeof(cppdom::binary::NodeRecord);
+      cppdom::binary::NodeRecord rec;
+      std::memcpy(&rec, small_bytes.data() + at, sizeof(rec));
+      if (rec.mType == cppdom::binary::Word(cppdom::Node::xml_nt_cdata))
+      {
+         rec.mTextOffset = header.mPoolSize + 4096;
+         rec.mTextLength = 0;
+         small_bytes.replace(at, sizeof(rec), reinterpret_cast<const char*>(&rec), sizeof(rec));
+      }
+   }
+   std::istringstream bad_text(small_bytes);
+   CPPUNIT_ASSERT_THROW(image.load(bad_text), cppdom::Error);
+
+   // A child count that is not the length of the chain of children
+   const std::string good = small_stream.str();
+   cppdom::binary::NodeRecord top;
+   std::memcpy(&top, good.data() + nodes, sizeof(top));
+   top.mChildCount = 0x7fffffff;
+   std::string bad_count(good);
+   bad_count.replace(nodes, sizeof(top), reinterpret_cast<const char*>(&top), sizeof(top));
+   std::istringstream bad_count_in(bad_count);
+   CPPUNIT_ASSERT_THROW(small.loadBinary(bad_count_in), cppdom::Error);
+
+   // The document and the root element sharing the text as a child
+   top.mChildCount = 1;
+   top.mFirstChild = 2;
+   std::string shared(good);
+   shared.replace(nodes, sizeof(top), reinterpret_cast<const char*>(&top), sizeof(top));
+   std::istringstream shared_in(shared);
+   CPPUNIT_ASSERT_THROW(image.load(shared_in), cppdom::Error);
+
+   std::istringstream good_in(good);
+   image.load(good_in);
+   CPPUNIT_ASSERT_EQUAL(std::string("text"), std::string(image.getRootElement().getCdata()));
+}
+
+}
@@ -0,0 +1,362 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ *
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+#include <TestCases/DiffTest.h>
+
+#include <sstream>
+
+#include <cppdom/cppdom.h>
+#include <cppdom/diff.h>
+
+namespace cppdomtest
+{
+CPPUNIT_TEST_SUITE_REGISTRATION(DiffTest);
+
+namespace
+{
+   cppdom::NodePtr parse(const std::string& xml, cppdom::ContextPtr ctx)
+   {
+      cppdom::DocumentPtr doc(new cppdom::Document(ctx));
+      std::istringstream in(xml);
+      doc->load(in, ctx);
+      return doc->getChildren()[0];
+   }
+
+   std::string toString(cppdom::NodePtr node)
+   {
+      std::ostringstream out;
+      node->save(out, 0, false, false);
+      return out.str();
+   }
+
+   /** Diffs a and b, patches a and checks it became b. */
+   cppdom::EditScript roundTrip(cppdom::NodePtr a, cppdom::NodePtr b)
+   {
+      cppdom::EditScript script = cppdom::diff(a, b);
+      cppdom::patch(a, script);
+      CPPUNIT_ASSERT_EQUAL(toString(b), toString(a));
+      CPPUNIT_ASSERT(a->isEqual(b));
+      return script;
+   }
+
+   /** Small deterministic random numbers, the same on every platform. */
+   class Random
+   {
+   public:
+      explicit Random(unsigned long seed)
+         : mState(seed)
+      {}
+
+      unsigned next(unsigned range)
+      {
+         mState = (mState * 1103515245UL + 12345UL) & 0x7fffffffUL;
+         return unsigned((mState >> 8) % range);
+      }
+
+   private:
+      unsigned long mState;
+   };
+
+   void buildTree(cppdom::NodePtr parent, cppdom::ContextPtr ctx, Random& random,
+                  unsigned depth)
+   {
+      const unsigned children = (depth == 0) ? 0 : random.next(6);
+      for (unsigned c = 0; c < children; ++c)
+      {
+         std::ostringstream name;
+         name << "n" << random.next(4);
+         cppdom::NodePtr child(new cppdom::Node(name.str(), ctx));
+         if (random.next(3) == 0)
+         {  child->setAttribute("a", random.next(3)); }
+         if (random.next(4) == 0)
+         {  child->setCdata("text"); }
+         parent->addChild(child);
+         buildTree(child, ctx, random, depth - 1);
+      }
+   }
+
+   /** Makes a few random changes somewhere below node. */
+   void mutateTree(cppdom::NodePtr node, cppdom::ContextPtr ctx, Random& random)
+   {
+      if (node->getType() == cppdom::Node::xml_nt_cdata)
+      {  return; }
+
+      cppdom::NodeList& children = node->getChildren();
+      switch (random.next(6))
+      {
+      case 0:
+         node->setAttribute("b", random.next(5));
+         break;
+      case 1:
+         if (!children.empty())
+         {
+            // reorder
+            const unsigned from = random.next(unsigned(children.size()));
+            cppdom::NodePtr child = children[from];
+            children.erase(children.begin() + from);
+            children.insert(children.begin() + random.next(unsigned(children.size()) + 1), child);
+            node->invalidateHash();
+         }
+         break;
+      case 2:
+         if (!children.empty())
+         {
+            children.erase(children.begin() + random.next(unsigned(children.size())));
+            node->invalidateHash();
+         }
+         break;
+      case 3:
+         {
+            cppdom::NodePtr child(new cppdom::Node("added", ctx));
+            buildTree(child, ctx, random, 2);
+            node->addChild(child);
+         }
+         break;
+      default:
+         break;
+      }
+
+      for (cppdom::NodeList::iterator c = children.begin(); c != children.end(); ++c)
+      {
+         if (random.next(3) == 0)
+         {  mutateTree(*c, ctx, random); }
+      }
+   }
+}
+
+void DiffTest::testIdentical()
+{
+   cppdom::ContextPtr ctx1(new cppdom::Context), ctx2(new cppdom::Context);
+   const std::string xml("<r a='1'><x>text</x><y/><z b='2'><x/></z></r>");
+   cppdom::NodePtr a = parse(xml, ctx1);
+   cppdom::NodePtr b = parse(xml, ctx2);
+   CPPUNIT_ASSERT(cppdom::diff(a, b).empty());
+
+   // Edits through references kept from before hashing are still found
+   cppdom::Attributes& kept = a->getChild("z")->attrib();
+   cppdom::NodeList& kept_children = a->getChildren();
+   CPPUNIT_ASSERT(cppdom::diff(a, b).empty());
+   kept["b"] = cppdom::Attribute(std::string("3"));
+   kept_children.erase(kept_children.begin() + 1);
+   CPPUNIT_ASSERT(a->hasHash());
+   CPPUNIT_ASSERT(!cppdom::diff(a, b).empty());
+   roundTrip(a, b);
+}
+
+void DiffTest::testAttributesAndCdata()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::NodePtr a = parse("<r a='1' b='2'><x>old</x><y c='3'/></r>", ctx);
+   cppdom::NodePtr b = parse("<r b='5' d='4'><x>new</x><y c='3'/></r>", ctx);
+
+   cppdom::EditScript script = roundTrip(a, b);
+   CPPUNIT_ASSERT_EQUAL(std::size_t(4), script.size());
+   CPPUNIT_ASSERT_EQUAL(cppdom::Edit::xml_edit_remove_attribute, script[0].getType());
+   CPPUNIT_ASSERT_EQUAL(std::string("a"), script[0].getName());
+   CPPUNIT_ASSERT_EQUAL(cppdom::Edit::xml_edit_set_attribute, script[1].getType());
+   CPPUNIT_ASSERT_EQUAL(std::string("5"), script[1].getValue());
+   CPPUNIT_ASSERT_EQUAL(cppdom::Edit::xml_edit_set_attribute, script[2].getType());
+   CPPUNIT_ASSERT_EQUAL(std::string("d"), script[2].getName());
+   CPPUNIT_ASSERT_EQUAL(cppdom::Edit::xml_edit_set_cdata, script[3].getType());
+   CPPUNIT_ASSERT_EQUAL(std::string("new"), script[3].getValue());
+   cppdom::Edit::Path cdata_path;
+   cdata_path.push_back(0);
+   cdata_path.push_back(0);
+   CPPUNIT_ASSERT(script[3].getPath() == cdata_path);
+}
+
+void DiffTest::testChildren()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+
+   // A move is a single edit, whatever the size of the subtree
+   cppdom::NodePtr a = parse("<r><big><x/><x/><x/></big><p/><q/><s/></r>", ctx);
+   cppdom::NodePtr b = parse("<r><p/><q/><s/><big><x/><x/><x/></big></r>", ctx);
+   cppdom::EditScript script = roundTrip(a, b);
+   CPPUNIT_ASSERT_EQUAL(std::size_t(1), script.size());
+   CPPUNIT_ASSERT_EQUAL(cppdom::Edit::xml_edit_move, script[0].getType());
+   CPPUNIT_ASSERT_EQUAL(0u, script[0].getIndex());
+   CPPUNIT_ASSERT_EQUAL(3u, script[0].getTarget());
+
+   // Insert and delete
+   a = parse("<r><p/><q/><s/></r>", ctx);
+   b = parse("<r><p/><new k='v'><c/></new><s/></r>", ctx);
+   script = roundTrip(a, b);
+   CPPUNIT_ASSERT_EQUAL(std::size_t(2), script.size());
+   CPPUNIT_ASSERT_EQUAL(cppdom::Edit::xml_edit_delete, script[0].getType());
+   CPPUNIT_ASSERT_EQUAL(1u, script[0].getIndex());
+   CPPUNIT_ASSERT_EQUAL(cppdom::Edit::xml_edit_insert, script[1].getType());
+   CPPUNIT_ASSERT_EQUAL(1u, script[1].getIndex());
+   CPPUNIT_ASSERT_EQUAL(std::string("new"), script[1].getNode()->getName());
+
+   // Changed children keep their place and are edited in place
+   a = parse("<r><p i='1'/><p i='2'/><p i='3'/></r>", ctx);
+   b = parse("<r><p i='1'/><p i='9'/><p i='3'/></r>", ctx);
+   script = roundTrip(a, b);
+   CPPUNIT_ASSERT_EQUAL(std::size_t(1), script.size());
+   CPPUNIT_ASSERT_EQUAL(cppdom::Edit::xml_edit_set_attribute, script[0].getType());
+
+   // Long reordered lists
+   std::ostringstream forward, backward;
+   forward << "<r>";
+   backward << "<r>";
+   for (unsigned i = 0; i < 200; ++i)
+   {
+      forward << "<c i='" << i << "'/>";
+      backward << "<c i='" << (199 - i) << "'/>";
+   }
+   forward << "</r>";
+   backward << "</r>";
+   a = parse(forward.str(), ctx);
+   b = parse(backward.str(), ctx);
+   script = roundTrip(a, b);
+   CPPUNIT_ASSERT_EQUAL(std::size_t(199), script.size());
+
+   // Children added to a leaf
+   a = parse("<r><leaf/></r>", ctx);
+   b = parse("<r><leaf><c/></leaf></r>", ctx);
+   roundTrip(a, b);
+
+   // Scripts are independent of the trees they were made from
+   a = parse("<r><p/></r>", ctx);
+   b = parse("<r><p/><q><c/></q></r>", ctx);
+   script = cppdom::diff(a, b);
+   b->getChildren()[1]->setName("changed");
+   cppdom::ContextPtr other_ctx(new cppdom::Context);
+   cppdom::NodePtr a2 = parse("<r><p/></r>", other_ctx);
+   cppdom::patch(a2, script);
+   CPPUNIT_ASSERT_EQUAL(std::string("<r><p/><q><c/></q></r>"), toString(a2));
+   CPPUNIT_ASSERT(a2->getChildren()[1]->getContext() == other_ctx);
+}
+
+void DiffTest::testRoot()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::NodePtr a = parse("<r><x/></r>", ctx);
+   cppdom::NodePtr b = parse("<other k='1'><y/></other>", ctx);
+   cppdom::EditScript script = roundTrip(a, b);
+   CPPUNIT_ASSERT_EQUAL(std::size_t(1), script.size());
+   CPPUNIT_ASSERT_EQUAL(cppdom::Edit::xml_edit_replace, script[0].getType());
+   CPPUNIT_ASSERT_EQUAL(std::string("other"), a->getName());
+}
+
+void DiffTest::testRandomEdits()
+{
+   Random random(12345);
+   for (unsigned round = 0; round < 40; ++round)
+   {
+      cppdom::ContextPtr ctx(new cppdom::Context);
+      cppdom::NodePtr a(new cppdom::Node("root", ctx));
+      buildTree(a, ctx, random, 5);
+      const std::string original = toString(a);
+
+      // b starts as a copy of a and is then edited
+      cppdom::NodePtr b = parse(original, ctx);
+      mutateTree(b, ctx, random);
+
+      cppdom::EditScript script = roundTrip(a, b);
+
+      // The script applies to any tree equal to a
+      cppdom::ContextPtr other_ctx(new cppdom::Context);
+      cppdom::NodePtr a2 = parse(original, other_ctx);
+      cppdom::patch(a2, script);
+      CPPUNIT_ASSERT_EQUAL(toString(b), toString(a2));
+   }
+}
+
+void DiffTest::testBadScript()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::NodePtr a = parse("<r><p/><q/></r>", ctx);
+
+   cppdom::Edit::Path path;
+   path.push_back(5);
+   cppdom::EditScript script;
+   script.push_back(cppdom::Edit::setAttribute(path, "a", "1"));
+   CPPUNIT_ASSERT_THROW(cppdom::patch(a, script), cppdom::Error);
+
+   script.clear();
+   script.push_back(cppdom::Edit::deleteNode(cppdom::Edit::Path(), 2));
+   CPPUNIT_ASSERT_THROW(cppdom::patch(a, script), cppdom::Error);
+
+   script.clear();
+   script.push_back(cppdom::Edit::setCdata(cppdom::Edit::Path(), "text"));
+   CPPUNIT_ASSERT_THROW(cppdom::patch(a, script), cppdom::Error);
+
+   // Nothing was changed
+   CPPUNIT_ASSERT_EQUAL(std::string("<r><p/><q/></r>"), toString(a));
+}
+
+void DiffTest::testIndexedDocument()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Document doc(ctx);
+   std::istringstream in("<r><x id='1'/><x id='2' k='a'/><y id='3'><z id='4'/></y></r>");
+   doc.load(in, ctx);
+   doc.buildIndex("id");
+   doc.buildIndex("k");
+   cppdom::NodePtr a = doc.getChild("r");
+
+   // Deleted children leave the indexes, inserted ones join them
+   cppdom::patch(a, cppdom::diff(a, parse("<r><x id='2' k='a'/><y id='3'><z id='4'/></y>"
+                                          "<w id='5'/></r>", ctx)));
+   CPPUNIT_ASSERT(doc.findById("1").get() == NULL);
+   CPPUNIT_ASSERT(doc.findById("2") == a->getChildren()[0]);
+   CPPUNIT_ASSERT(doc.findById("4") == a->getChildren()[1]->getChildren()[0]);
+   CPPUNIT_ASSERT(doc.findById("5") == a->getChildren()[2]);
+
+   // So do removed attributes
+   cppdom::patch(a, cppdom::diff(a, parse("<r><x id='2'/><y id='3'><z id='4'/></y>"
+                                          "<w id='5'/></r>", ctx)));
+   CPPUNIT_ASSERT(doc.findByAttribute("k", "a").get() == NULL);
+   CPPUNIT_ASSERT(doc.findById("2") == a->getChildren()[0]);
+
+   // A replaced root keeps its place, its old content leaves
+   cppdom::patch(a, cppdom::diff(a, parse("<s id='6'><t id='7'/></s>", ctx)));
+   CPPUNIT_ASSERT(doc.getChild("s") == a);
+   CPPUNIT_ASSERT(doc.findById("6") == a);
+   CPPUNIT_ASSERT(doc.findById("7") == a->getChildren()[0]);
+   for (unsigned id = 1; id < 6; ++id)
+   {
+      std::ostringstream value;
+      value << id;
+      CPPUNIT_ASSERT(doc.findById(value.str()).get() == NULL);
+   }
+}
+
+}
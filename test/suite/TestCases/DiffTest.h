@@ -0,0 +1,87 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ *
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+#ifndef CPPDOM_TEST_DIFF_TEST_H
+#define CPPDOM_TEST_DIFF_TEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppdom/cppdom.h>
+
+namespace cppdomtest
+{
+
+class DiffTest : public CppUnit::TestFixture
+{
+
+CPPUNIT_TEST_SUITE(DiffTest);
+CPPUNIT_TEST(testIdentical);
+CPPUNIT_TEST(testAttributesAndCdata);
+CPPUNIT_TEST(testChildren);
+CPPUNIT_TEST(testRoot);
+CPPUNIT_TEST(testRandomEdits);
+CPPUNIT_TEST(testBadScript);
+CPPUNIT_TEST(testIndexedDocument);
+CPPUNIT_TEST_SUITE_END();
+
+public:
+
+   /** Equal trees give an empty script. */
+   void testIdentical();
+
+   /** Attribute and text changes. */
+   void testAttributesAndCdata();
+
+   /** Inserted, deleted and reordered children. */
+   void testChildren();
+
+   /** Roots that do not match are replaced. */
+   void testRoot();
+
+   /** Patching with the diff of randomly edited trees reproduces them. */
+   void testRandomEdits();
+
+   /** Scripts that do not fit the tree are reported. */
+   void testBadScript();
+
+   /** Patching keeps the attribute indexes of the document. */
+   void testIndexedDocument();
+};
+
+}
+
+#endif
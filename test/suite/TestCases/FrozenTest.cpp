@@ -0,0 +1,123 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ *
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+#include <TestCases/FrozenTest.h>
+#include <TestCases/TestData.h>
+
+#include <sstream>
+
+#include <cppdom/cppdom.h>
+#include <cppdom/binary.h>
+
+namespace cppdomtest
+{
+CPPUNIT_TEST_SUITE_REGISTRATION(FrozenTest);
+
+void FrozenTest::testQueries()
+{
+   cppdom::DocumentPtr doc(new cppdom::Document);
+   doc->loadFile(cppdomtest::nodetest_xml_filename);
+   cppdom::FrozenDocumentPtr frozen = doc->freeze();
+
+   cppdom::NodePtr root = doc->getChild("nodetest_root");
+   cppdom::FrozenNode froot = frozen->getRootElement();
+   CPPUNIT_ASSERT(froot.isValid());
+   CPPUNIT_ASSERT(root->getName() == froot.getName());
+   CPPUNIT_ASSERT(root->getChildren().size() == froot.getChildren().size());
+
+   // Paths
+   CPPUNIT_ASSERT(froot.getChildPath("child_1/child_1_2").isValid());
+   CPPUNIT_ASSERT(std::string("child_1_2") == froot.getChildPath("child_1/child_1_2").getName());
+   CPPUNIT_ASSERT(!froot.getChildPath("gp/parent/has_no_daddy").isValid());
+   CPPUNIT_ASSERT(!froot.getChildPath("unknown_name/child").isValid());
+   CPPUNIT_ASSERT(froot.hasChild("gp/parent/child"));
+   CPPUNIT_ASSERT(std::string("21") == froot.getChildPath("gp/parent/child").getAttribute("val"));
+
+   // Children by name
+   std::vector<cppdom::FrozenNode> dupes = froot.getChildren("dupe_child");
+   cppdom::NodeList tree_dupes = root->getChildren("dupe_child");
+   CPPUNIT_ASSERT(dupes.size() == 2);
+   CPPUNIT_ASSERT(tree_dupes.size() == dupes.size());
+   for (unsigned i = 0; i < dupes.size(); ++i)
+   {
+      CPPUNIT_ASSERT(tree_dupes[i]->getAttribute("id").getString() == dupes[i].getAttribute("id"));
+   }
+   CPPUNIT_ASSERT(froot.getChildren("not_a_child").empty());
+
+   // Text
+   cppdom::NodePtr testnode = root->getChild("testnode");
+   cppdom::FrozenNode ftestnode = froot.getChild("testnode");
+   CPPUNIT_ASSERT(testnode->getFullCdata() == ftestnode.getFullCdata());
+   CPPUNIT_ASSERT(testnode->getCdata() == ftestnode.getCdata());
+   CPPUNIT_ASSERT(std::string("nested text") == ftestnode.getChild("nestednode").getCdata());
+}
+
+void FrozenTest::testSnapshot()
+{
+   cppdom::DocumentPtr doc(new cppdom::Document);
+   doc->loadFile(cppdomtest::game_xml_filename);
+   cppdom::FrozenDocumentPtr frozen = doc->freeze();
+
+   cppdom::NodePtr bind = doc->getChildPath("gameinput/bind");
+   bind->setAttribute("action", std::string("Brake"));
+
+   CPPUNIT_ASSERT(std::string("Accelerate") ==
+                  frozen->getRootElement().getChild("bind").getAttribute("action"));
+   CPPUNIT_ASSERT(std::string("Brake") ==
+                  doc->freeze()->getRootElement().getChild("bind").getAttribute("action"));
+}
+
+void FrozenTest::testSave()
+{
+   cppdom::DocumentPtr doc(new cppdom::Document);
+   doc->loadFile(cppdomtest::hamlet_xml_filename);
+   cppdom::FrozenDocumentPtr frozen = doc->freeze();
+
+   std::stringstream image;
+   frozen->save(image);
+
+   cppdom::DocumentPtr copy(new cppdom::Document);
+   copy->loadBinary(image);
+   CPPUNIT_ASSERT(copy->isEqual(doc));
+
+   cppdom::DocumentPtr thawed(new cppdom::Document);
+   thawed->loadBinary(*frozen);
+   CPPUNIT_ASSERT(thawed->isEqual(doc));
+}
+
+}
@@ -0,0 +1,71 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ *
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+#ifndef CPPDOM_TEST_FROZEN_TEST_H
+#define CPPDOM_TEST_FROZEN_TEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppdom/cppdom.h>
+
+namespace cppdomtest
+{
+
+class FrozenTest : public CppUnit::TestFixture
+{
+
+CPPUNIT_TEST_SUITE(FrozenTest);
+CPPUNIT_TEST(testQueries);
+CPPUNIT_TEST(testSnapshot);
+CPPUNIT_TEST(testSave);
+CPPUNIT_TEST_SUITE_END();
+
+public:
+
+   /** Frozen queries must answer like the node tree. */
+   void testQueries();
+
+   /** Changes to the document after freezing are not seen. */
+   void testSnapshot();
+
+   /** A frozen document saves as a loadable binary image. */
+   void testSave();
+};
+
+}
+
+#endif
@@ -0,0 +1,157 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ *
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+#include <TestCases/LazyLoadTest.h>
+#include <TestCases/TestData.h>
+
+#include <sstream>
+
+#include <cppdom/cppdom.h>
+#include <cppdom/lazy.h>
+
+namespace cppdomtest
+{
+CPPUNIT_TEST_SUITE_REGISTRATION(LazyLoadTest);
+
+namespace
+{
+   std::string saved(cppdom::Document& doc)
+   {
+      std::ostringstream out;
+      doc.save(out);
+      return out.str();
+   }
+}
+
+void LazyLoadTest::testSameAsLoad()
+{
+   std::vector<std::string> filenames;
+   filenames.push_back(cppdomtest::game_xml_filename);
+   filenames.push_back(cppdomtest::hamlet_xml_filename);
+   filenames.push_back(cppdomtest::nodetest_xml_filename);
+   filenames.push_back(cppdomtest::simple_nodes_xml_filename);
+
+   for (unsigned i = 0; i < filenames.size(); ++i)
+   {
+      cppdom::DocumentPtr expected(new cppdom::Document);
+      expected->loadFile(filenames[i]);
+
+      cppdom::DocumentPtr lazy(new cppdom::Document);
+      cppdom::loadFileLazy(*lazy, filenames[i]);
+      CPPUNIT_ASSERT_EQUAL(saved(*expected), saved(*lazy));
+
+      cppdom::DocumentPtr compared(new cppdom::Document);
+      cppdom::loadFileLazy(*compared, filenames[i]);
+      CPPUNIT_ASSERT(compared->isEqual(expected));
+      CPPUNIT_ASSERT(compared->getHash() == expected->getHash());
+   }
+
+   // Text next to elements, markup the skim skips and kept comments
+   const std::string text("<?xml version=\"1.0\"?>\n<!-- head -->\n"
+                          "<r a=\"1\">x <b c='<>'>y<![CDATA[<z>]]></b> w<!-- c --> v<e/><f g=\"2\"/></r>\n");
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   ctx->setKeepComments(true);
+   cppdom::Document doc(ctx);
+   std::istringstream in(text);
+   doc.load(in, ctx);
+   cppdom::Document lazy_doc(ctx);
+   std::istringstream lazy_in(text);
+   cppdom::loadLazy(lazy_doc, lazy_in, ctx, ctx->getLocation());
+   CPPUNIT_ASSERT_EQUAL(saved(doc), saved(lazy_doc));
+}
+
+void LazyLoadTest::testParsedOnUse()
+{
+   // The attribute of b is not well formed, the skim does not see that
+   const std::string text("<r><a n=\"1\"><c/></a><b n\"1\"/></r>");
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Document eager(ctx);
+   std::istringstream eager_in(text);
+   CPPUNIT_ASSERT_THROW(eager.load(eager_in, ctx), cppdom::Error);
+
+   cppdom::Document doc(ctx);
+   std::istringstream in(text);
+   cppdom::loadLazy(doc, in, ctx, ctx->getLocation());
+   cppdom::NodePtr root = doc.getChild("r");
+   CPPUNIT_ASSERT_EQUAL(std::size_t(2), root->getChildren().size());
+   CPPUNIT_ASSERT_EQUAL(std::string("1"), root->getChild("a")->getAttribute("n").getString());
+   CPPUNIT_ASSERT(root->getChild("a")->getChild("c")->isLeaf());
+
+   // The error comes from the first use of b, and again from the next
+   cppdom::NodePtr b = root->getChildren()[1];
+   CPPUNIT_ASSERT_EQUAL(std::string("b"), b->getName());
+
+   // Numbering the tree leaves unparsed nodes alone
+   cppdom::NodePtr a = root->getChild("a");
+   CPPUNIT_ASSERT(root->isAncestorOf(*b));
+   CPPUNIT_ASSERT(a->getPreOrder() < b->getPreOrder());
+   CPPUNIT_ASSERT(a->getChild("c")->getPostOrder() < b->getPostOrder());
+   CPPUNIT_ASSERT(!a->isAncestorOf(*b));
+   CPPUNIT_ASSERT_THROW(b->getAttribute("n"), cppdom::Error);
+   CPPUNIT_ASSERT_THROW(b->hasAttribute("n"), cppdom::Error);
+
+   // Tags that do not match are found by the skim
+   cppdom::Document bad(ctx);
+   std::istringstream bad_in("<r><a></b></r>");
+   CPPUNIT_ASSERT_THROW(cppdom::loadLazy(bad, bad_in, ctx, ctx->getLocation()), cppdom::Error);
+}
+
+void LazyLoadTest::testChanges()
+{
+   const std::string text("<r><a n=\"1\">text<c/></a><b m=\"2\"></b></r>");
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Document doc(ctx);
+   std::istringstream in(text);
+   cppdom::loadLazy(doc, in, ctx, ctx->getLocation());
+
+   cppdom::NodePtr a = doc.getChild("r")->getChild("a");
+   cppdom::NodePtr b = doc.getChild("r")->getChild("b");
+   a->setAttribute("o", 3);
+   cppdom::NodePtr d(new cppdom::Node("d", ctx));
+   b->addChild(d);
+
+   // Copies parse the shared text on their own
+   cppdom::Node copy(*doc.getChild("r"));
+   CPPUNIT_ASSERT_EQUAL(std::size_t(2), copy.getChildren().size());
+
+   std::ostringstream out;
+   doc.getChild("r")->save(out, 0, false, false);
+   CPPUNIT_ASSERT_EQUAL(std::string("<r><a n=\"1\" o=\"3\">text<c/></a><b m=\"2\"><d></d></b></r>"), out.str());
+}
+
+}
@@ -0,0 +1,188 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ *
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+#include <TestCases/MergeTest.h>
+
+#include <sstream>
+
+#include <cppdom/cppdom.h>
+#include <cppdom/merge.h>
+
+namespace cppdomtest
+{
+CPPUNIT_TEST_SUITE_REGISTRATION(MergeTest);
+
+namespace
+{
+   cppdom::NodePtr parse(const std::string& xml, cppdom::ContextPtr ctx)
+   {
+      cppdom::DocumentPtr doc(new cppdom::Document(ctx));
+      std::istringstream in(xml);
+      doc->load(in, ctx);
+      return doc->getChildren()[0];
+   }
+
+   std::string toString(cppdom::NodePtr node)
+   {
+      std::ostringstream out;
+      node->save(out, 0, false, false);
+      return out.str();
+   }
+}
+
+void MergeTest::testOverride()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::NodePtr to = parse("<cfg a='1' b='2'><item x='1'/><item x='2'/><name>old</name></cfg>", ctx);
+   cppdom::NodePtr from = parse("<cfg b='3' c='4'><item x='5'/><name>new</name><extra/></cfg>", ctx);
+
+   cppdom::merge(from, to);
+   cppdom::NodePtr expected = parse("<cfg a='1' b='3' c='4'><item x='5'/><item x='2'/>"
+                                    "<name>new</name><extra/></cfg>", ctx);
+   CPPUNIT_ASSERT_EQUAL(toString(expected), toString(to));
+   CPPUNIT_ASSERT(to->getChild("extra")->getParent() == to.get());
+
+   // Overlays from another context
+   cppdom::ContextPtr other(new cppdom::Context);
+   other->insertTagname("unrelated");
+   cppdom::NodePtr foreign = parse("<cfg d='5'><name>newer</name><more/></cfg>", other);
+   cppdom::merge(foreign, to);
+   CPPUNIT_ASSERT_EQUAL(std::string("newer"), to->getChild("name")->getCdata());
+   CPPUNIT_ASSERT(to->getChild("more")->getContext() == ctx);
+   CPPUNIT_ASSERT_EQUAL(std::size_t(5), to->getChildren().size());
+}
+
+void MergeTest::testKeep()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::NodePtr to = parse("<cfg a='1'><name>old</name><opt v='1'/></cfg>", ctx);
+   cppdom::NodePtr from = parse("<cfg a='2' b='3'><name>new</name><opt v='2' w='4'/><extra/></cfg>", ctx);
+
+   cppdom::MergeOptions options;
+   options.setPolicy(cppdom::MergeOptions::xml_merge_keep);
+   cppdom::merge(from, to, options);
+   cppdom::NodePtr expected = parse("<cfg a='1' b='3'><name>old</name><opt v='1' w='4'/><extra/></cfg>", ctx);
+   CPPUNIT_ASSERT_EQUAL(toString(expected), toString(to));
+
+   // Policies per element
+   options.setPolicy(cppdom::MergeOptions::xml_merge_override);
+   options.setPolicy("opt", cppdom::MergeOptions::xml_merge_keep);
+   cppdom::merge(from, to, options);
+   expected = parse("<cfg a='2' b='3'><name>new</name><opt v='1' w='4'/><extra/></cfg>", ctx);
+   CPPUNIT_ASSERT_EQUAL(toString(expected), toString(to));
+}
+
+void MergeTest::testAppend()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::NodePtr to = parse("<cfg><list><item/></list><plugins/></cfg>", ctx);
+   cppdom::NodePtr from = parse("<cfg><list a='1'><item/><item/></list><plugins><p/></plugins></cfg>", ctx);
+
+   cppdom::MergeOptions options;
+   options.setPolicy("list", cppdom::MergeOptions::xml_merge_append);
+   cppdom::merge(from, to, options);
+   cppdom::NodePtr expected = parse("<cfg><list a='1'><item/><item/><item/></list>"
+                                    "<plugins><p/></plugins></cfg>", ctx);
+   CPPUNIT_ASSERT_EQUAL(toString(expected), toString(to));
+
+   // A leaf that gets children is no longer saved as a leaf
+   cppdom::NodePtr leaf = to->getChild("plugins");
+   CPPUNIT_ASSERT(leaf->getChild("p").get() != NULL);
+}
+
+void MergeTest::testKeys()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::NodePtr to = parse("<sites><site id='a' port='1'/><site id='b' port='2'/>"
+                              "<site port='3'/><alias name='x'/></sites>", ctx);
+   cppdom::NodePtr from = parse("<sites><site id='b' port='20'/><site id='c' port='30'/>"
+                                "<site port='4'/><alias name='y'/></sites>", ctx);
+
+   cppdom::MergeOptions options;
+   options.setKey("id");
+   options.setKey("alias", "name");
+   cppdom::merge(from, to, options);
+   cppdom::NodePtr expected = parse("<sites><site id='a' port='1'/><site id='b' port='20'/>"
+                                    "<site port='4'/><alias name='x'/><site id='c' port='30'/>"
+                                    "<alias name='y'/></sites>", ctx);
+   CPPUNIT_ASSERT_EQUAL(toString(expected), toString(to));
+
+   // Without a key for the name, matched by name in order
+   options.setKey("alias", "");
+   cppdom::NodePtr overlay = parse("<sites><alias name='z'/></sites>", ctx);
+   cppdom::merge(overlay, to, options);
+   CPPUNIT_ASSERT_EQUAL(std::string("z"), to->getChild("alias")->getAttribute("name").getString());
+   CPPUNIT_ASSERT_EQUAL(std::size_t(2), to->getChildren("alias").size());
+}
+
+void MergeTest::testLargeOverlay()
+{
+   const int count = 50000;
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::NodePtr to(new cppdom::Node("list", ctx));
+   cppdom::NodePtr from(new cppdom::Node("list", ctx));
+   for (int i = 0; i < count; ++i)
+   {
+      cppdom::NodePtr item(new cppdom::Node("item", ctx));
+      item->setAttribute("id", i);
+      item->setAttribute("v", 0);
+      to->addChild(item);
+
+      // every other item overridden, in reverse order, and some new ones
+      const int id = (i % 2 == 0) ? count - 1 - i : count + i;
+      cppdom::NodePtr overlay(new cppdom::Node("item", ctx));
+      overlay->setAttribute("id", id);
+      overlay->setAttribute("v", 1);
+      from->addChild(overlay);
+   }
+
+   cppdom::MergeOptions options;
+   options.setKey("item", "id");
+   cppdom::merge(from, to, options);
+
+   cppdom::NodeList& children = to->getChildren();
+   CPPUNIT_ASSERT_EQUAL(std::size_t(count + count / 2), children.size());
+   for (int i = 0; i < count; ++i)
+   {
+      CPPUNIT_ASSERT_EQUAL(i, children[i]->getAttribute("id").getValue<int>());
+      CPPUNIT_ASSERT_EQUAL(i % 2, children[i]->getAttribute("v").getValue<int>());
+   }
+   CPPUNIT_ASSERT_EQUAL(count + 1, children[count]->getAttribute("id").getValue<int>());
+}
+
+}
@@ -43,6 +43,7 @@
 #include <Suites.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 #include <cppdom/cppdom.h>
 #include <cppdom/predicates.h>
@@ -210,8 +211,462 @@ void NodeTest::testEqual()
 
          CPPUNIT_ASSERT(false && "Failed equal test");
       }
+
+      // Same answer once both subtrees are hashed
+      child1->getHash();
+      child2->getHash();
+      CPPUNIT_ASSERT(child1->hasHash() && child2->hasHash());
+      CPPUNIT_ASSERT_EQUAL(should_be_equal,
+                           child1->isEqual(child2, attrib_list, element_list));
+   }
+
+}
+
+void NodeTest::testHash()
+{
+   const std::string xml("<root a='1' b='two'><child>text</child><leaf/></root>");
+
+   // Same content in different contexts hashes alike
+   cppdom::ContextPtr ctx1(new cppdom::Context);
+   cppdom::ContextPtr ctx2(new cppdom::Context);
+   ctx2->insertTagname("unrelated");        // shifts the handles
+   cppdom::Document doc1(ctx1), doc2(ctx2);
+   std::istringstream in1(xml), in2(xml);
+   doc1.load(in1, ctx1);
+   doc2.load(in2, ctx2);
+   cppdom::NodePtr root1 = doc1.getChild("root");
+   cppdom::NodePtr root2 = doc2.getChild("root");
+
+   CPPUNIT_ASSERT(!root1->hasHash());
+   CPPUNIT_ASSERT(root1->getHash() == root2->getHash());
+   CPPUNIT_ASSERT(root1->hasHash());
+   CPPUNIT_ASSERT(root1->getChild("child")->hasHash());
+   CPPUNIT_ASSERT(root1->isEqual(root2));
+   CPPUNIT_ASSERT(root1->getChild("child")->getHash() != root1->getChild("leaf")->getHash());
+
+   // Changes drop the hash of the node and its ancestors, not of siblings
+   const cppdom::Node::HashValue old_hash = root1->getHash();
+   root1->getChild("child")->setCdata("other text");
+   CPPUNIT_ASSERT(!root1->hasHash());
+   CPPUNIT_ASSERT(!root1->getChild("child")->hasHash());
+   CPPUNIT_ASSERT(root1->getChild("leaf")->hasHash());
+   CPPUNIT_ASSERT(root1->getHash() != old_hash);
+   CPPUNIT_ASSERT(!root1->isEqual(root2));
+
+   root1->getChild("child")->setCdata("text");
+   CPPUNIT_ASSERT(root1->getHash() == old_hash);
+
+   root1->setAttribute("c", 3);
+   root2->setAttribute("c", 4);
+   CPPUNIT_ASSERT(root1->getHash() != root2->getHash());
+   CPPUNIT_ASSERT(!root1->isEqual(root2));
+   std::vector<std::string> ignore_attribs(1, "c"), no_elements;
+   CPPUNIT_ASSERT(root1->isEqual(root2, ignore_attribs, no_elements));
+
+   // Handing out the attribute map drops the hash
+   root1->attrib().erase("c");
+   CPPUNIT_ASSERT(!root1->hasHash());
+   root2->attrib().erase("c");
+   CPPUNIT_ASSERT(root1->getHash() == old_hash);
+   CPPUNIT_ASSERT(root1->isEqual(root2));
+
+   // Equal hashes are not trusted, edits through a kept map still count
+   cppdom::NodePtr ra(new cppdom::Node("r", ctx1));
+   cppdom::NodePtr rb(new cppdom::Node("r", ctx1));
+   ra->setAttribute("v", 1);
+   rb->setAttribute("v", 1);
+   cppdom::Attributes& kept = ra->attrib();
+   CPPUNIT_ASSERT(ra->getHash() == rb->getHash());
+   kept["v"] = cppdom::Attribute(std::string("2"));
+   CPPUNIT_ASSERT(ra->hasHash());
+   CPPUNIT_ASSERT(!ra->isEqual(rb));
+   ra->attrib()["v"] = cppdom::Attribute(std::string("1"));
+   rb->getHash();
+   rb->attrib()["v"] = cppdom::Attribute(std::string("2"));
+   CPPUNIT_ASSERT(!ra->isEqual(rb));
+
+   cppdom::NodePtr extra(new cppdom::Node("leaf", ctx2));
+   root2->getChild("leaf")->addChild(extra);
+   CPPUNIT_ASSERT(!root2->hasHash());
+   CPPUNIT_ASSERT(root1->getHash() != root2->getHash());
+   CPPUNIT_ASSERT(!root1->isEqual(root2));
+   std::vector<std::string> ignore_leaf(1, "leaf"), no_attribs;
+   CPPUNIT_ASSERT(root1->isEqual(root2, no_attribs, ignore_leaf));
+
+   // Duplicate detection
+   std::istringstream in3("<list><item x='1'/><item x='2'/><item x='1'/></list>");
+   cppdom::Document doc3(ctx1);
+   doc3.load(in3, ctx1);
+   cppdom::NodeList items = doc3.getChild("list")->getChildren("item");
+   CPPUNIT_ASSERT_EQUAL(std::size_t(3), items.size());
+   CPPUNIT_ASSERT(items[0]->getHash() == items[2]->getHash());
+   CPPUNIT_ASSERT(items[0]->getHash() != items[1]->getHash());
+}
+
+void NodeTest::testRemoveChildren()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Document doc(ctx);
+   std::istringstream in("<root><a/><b x='1'/><a/><c/><b x='2'/><a/></root>");
+   doc.load(in, ctx);
+   cppdom::NodePtr root = doc.getChild("root");
+   CPPUNIT_ASSERT_EQUAL(std::size_t(6), root->getChildren().size());
+
+   // By node
+   cppdom::NodePtr c = root->getChild("c");
+   root->getHash();
+   CPPUNIT_ASSERT(root->removeChild(c));
+   CPPUNIT_ASSERT(c->getParent() == NULL);
+   CPPUNIT_ASSERT(!root->hasHash());
+   CPPUNIT_ASSERT(!root->removeChild(c));
+   CPPUNIT_ASSERT_EQUAL(std::size_t(5), root->getChildren().size());
+
+   // First by name
+   cppdom::NodePtr first_b = root->getChild("b");
+   CPPUNIT_ASSERT(root->removeChild(std::string("b")));
+   CPPUNIT_ASSERT(first_b->getParent() == NULL);
+   CPPUNIT_ASSERT_EQUAL(std::string("2"), root->getChild("b")->getAttribute("x").getString());
+   CPPUNIT_ASSERT(!root->removeChild(std::string("not_there")));
+
+   // All by name, keeping the order of the rest
+   cppdom::NodeList as = root->getChildren("a");
+   CPPUNIT_ASSERT(root->removeChildren("a"));
+   CPPUNIT_ASSERT_EQUAL(std::size_t(1), root->getChildren().size());
+   CPPUNIT_ASSERT_EQUAL(std::string("b"), root->getChildren()[0]->getName());
+   for (cppdom::NodeList::iterator i = as.begin(); i != as.end(); ++i)
+   {  CPPUNIT_ASSERT((*i)->getParent() == NULL); }
+   CPPUNIT_ASSERT(!root->removeChildren("a"));
+
+   // By predicate, over a long list
+   cppdom::NodePtr list(new cppdom::Node("list", ctx));
+   for (int i = 0; i < 10000; ++i)
+   {
+      cppdom::NodePtr item(new cppdom::Node("item", ctx));
+      item->setAttribute("n", i);
+      list->addChild(item);
+   }
+   CPPUNIT_ASSERT(list->removeChildrenIf(cppdom::HasAttributeValuePredicate("n", "5000")));
+   CPPUNIT_ASSERT_EQUAL(std::size_t(9999), list->getChildren().size());
+   CPPUNIT_ASSERT(list->removeChildrenIf(cppdom::IsNodeTypePredicate(cppdom::Node::xml_nt_node)));
+   CPPUNIT_ASSERT(list->getChildren().empty());
+   CPPUNIT_ASSERT(!list->removeChildrenIf(cppdom::IsNodeTypePredicate(cppdom::Node::xml_nt_node)));
+}
+
+void NodeTest::testClone()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Document doc(ctx);
+   std::istringstream in("<root a='1'><child b='2'>text</child><leaf/></root>");
+   doc.load(in, ctx);
+   cppdom::NodePtr root = doc.getChild("root");
+   const cppdom::Node::HashValue hash = root->getHash();
+
+   // Deep, in the same context
+   cppdom::NodePtr copy = root->clone();
+   CPPUNIT_ASSERT(copy->getParent() == NULL);
+   CPPUNIT_ASSERT(copy->hasHash());
+   CPPUNIT_ASSERT(copy->getHash() == hash);
+   CPPUNIT_ASSERT(copy->isEqual(root));
+   CPPUNIT_ASSERT_EQUAL(std::size_t(2), copy->getChildren().size());
+   CPPUNIT_ASSERT(copy->getChildren()[0] != root->getChildren()[0]);
+   CPPUNIT_ASSERT(copy->getChildren()[0]->getParent() == copy.get());
+
+   // The copy shares nothing with the original
+   copy->getChild("child")->setAttribute("b", 3);
+   CPPUNIT_ASSERT_EQUAL(2, root->getChild("child")->getAttribute("b").getValue<int>());
+   CPPUNIT_ASSERT(root->getHash() == hash);
+   CPPUNIT_ASSERT(!copy->isEqual(root));
+
+   // Deep, into another context
+   cppdom::ContextPtr other(new cppdom::Context);
+   other->insertTagname("unrelated");
+   cppdom::NodePtr moved = root->clone(true, other);
+   CPPUNIT_ASSERT(moved->getContext() == other);
+   CPPUNIT_ASSERT_EQUAL(std::string("child"), moved->getChildren()[0]->getName());
+   CPPUNIT_ASSERT(moved->isEqual(root));
+   moved->invalidateHash();
+   CPPUNIT_ASSERT(moved->getHash() == hash);
+
+   // Shallow
+   cppdom::NodePtr shallow = root->clone(false);
+   CPPUNIT_ASSERT_EQUAL(std::string("root"), shallow->getName());
+   CPPUNIT_ASSERT_EQUAL(std::string("1"), shallow->getAttribute("a").getString());
+   CPPUNIT_ASSERT(shallow->getChildren().empty());
+   CPPUNIT_ASSERT(!shallow->hasHash());
+
+#ifdef CPPDOM_HAS_RVALUE_REFERENCES
+   cppdom::Node source(*root->clone());
+   cppdom::Node target(std::move(source));
+   CPPUNIT_ASSERT(source.getChildren().empty());
+   CPPUNIT_ASSERT(source.attrib().empty());
+   CPPUNIT_ASSERT_EQUAL(std::size_t(2), target.getChildren().size());
+   CPPUNIT_ASSERT(target.getChildren()[0]->getParent() == &target);
+   CPPUNIT_ASSERT(target.getHash() == hash);
+
+   cppdom::NodePtr leaf = root->getChild("leaf");
+   *leaf = std::move(target);
+   CPPUNIT_ASSERT(leaf->getParent() == root.get());
+   CPPUNIT_ASSERT(leaf->getChildren()[1]->getParent() == leaf.get());
+   CPPUNIT_ASSERT(target.getChildren().empty());
+   CPPUNIT_ASSERT(root->getHash() != hash);
+
+   cppdom::Attribute value("42");
+   CPPUNIT_ASSERT_EQUAL(42, value.getValue<int>());
+   cppdom::Attribute taken(std::move(value));
+   CPPUNIT_ASSERT_EQUAL(42, taken.getValue<int>());
+#endif
+}
+
+void NodeTest::testCdataBinary()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   unsigned char bytes[256];
+   for (unsigned i = 0; i < 256; ++i)
+   {  bytes[i] = static_cast<unsigned char>(i * 37); }
+
+   // all three tail lengths
+   for (unsigned size = 253; size <= 255; ++size)
+   {
+      cppdom::NodePtr node(new cppdom::Node("blob", ctx));
+      node->setCdataBinary(bytes, size);
+
+      std::vector<unsigned char> data;
+      CPPUNIT_ASSERT(node->getCdataBinary(data));
+      CPPUNIT_ASSERT(std::vector<unsigned char>(bytes, bytes + size) == data);
+
+      // the same as text
+      cppdom::NodePtr text(new cppdom::Node("blob", ctx));
+      text->setCdata(node->getCdata());
+      CPPUNIT_ASSERT_EQUAL(std::size_t((size + 2) / 3 * 4), text->getCdata().size());
+      CPPUNIT_ASSERT(text->getCdataBinary(data));
+      CPPUNIT_ASSERT(std::vector<unsigned char>(bytes, bytes + size) == data);
+      CPPUNIT_ASSERT_EQUAL(text->getHash(), node->getHash());
+      CPPUNIT_ASSERT(node->isEqual(text));
+
+      std::ostringstream saved, saved_text;
+      node->save(saved, 0, false, false);
+      text->save(saved_text, 0, false, false);
+      CPPUNIT_ASSERT_EQUAL(saved_text.str(), saved.str());
+
+      // copies keep the bytes
+      cppdom::NodePtr copy = node->clone();
+      CPPUNIT_ASSERT_EQUAL(node->getCdata(), copy->getCdata());
    }
 
+   cppdom::NodePtr node(new cppdom::Node("blob", ctx));
+   std::vector<unsigned char> data;
+   node->setCdata("TWFu\n  TWE=");
+   CPPUNIT_ASSERT(node->getCdataBinary(data));
+   CPPUNIT_ASSERT_EQUAL(std::string("ManMa"), std::string(data.begin(), data.end()));
+
+   node->setCdata("TWF");
+   CPPUNIT_ASSERT(!node->getCdataBinary(data));
+   node->setCdata("TW=u");
+   CPPUNIT_ASSERT(!node->getCdataBinary(data));
+   node->setCdata("TW*u");
+   CPPUNIT_ASSERT(!node->getCdataBinary(data));
+}
+
+void NodeTest::testDocumentOrder()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Document doc(ctx);
+   std::istringstream in("<r><a><b/><c/></a><d>text</d><e/></r>");
+   doc.load(in, ctx);
+   cppdom::NodePtr r = doc.getChild("r");
+   cppdom::NodePtr a = r->getChild("a");
+   cppdom::NodePtr b = a->getChild("b");
+   cppdom::NodePtr d = r->getChild("d");
+   cppdom::NodePtr e = r->getChild("e");
+
+   CPPUNIT_ASSERT_EQUAL(2u, e->getIndex());
+   CPPUNIT_ASSERT(a->getNextSibling() == d);
+   CPPUNIT_ASSERT(e->getPrevSibling() == d);
+   CPPUNIT_ASSERT(e->getNextSibling().get() == NULL);
+   CPPUNIT_ASSERT(a->getPrevSibling().get() == NULL);
+   CPPUNIT_ASSERT(r->getNextSibling().get() == NULL);
+   CPPUNIT_ASSERT_EQUAL(1u, r->getDepth());
+   CPPUNIT_ASSERT_EQUAL(3u, b->getDepth());
+
+   CPPUNIT_ASSERT(r->isAncestorOf(*b));
+   CPPUNIT_ASSERT(a->isAncestorOf(*b));
+   CPPUNIT_ASSERT(!d->isAncestorOf(*b));
+   CPPUNIT_ASSERT(!b->isAncestorOf(*b));
+   CPPUNIT_ASSERT(!b->isAncestorOf(*a));
+   CPPUNIT_ASSERT(b->getPreOrder() < d->getPreOrder());
+   CPPUNIT_ASSERT(b->getPostOrder() < a->getPostOrder());
+   CPPUNIT_ASSERT_EQUAL(3u, b->getDepth());
+
+   // Changes renumber the tree on the next use
+   a->removeChild(b);
+   CPPUNIT_ASSERT(!a->isAncestorOf(*b));
+   CPPUNIT_ASSERT_EQUAL(0u, b->getDepth());
+   cppdom::NodePtr c = a->getChild("c");
+   CPPUNIT_ASSERT_EQUAL(0u, c->getIndex());
+   e->addChild(b);
+   CPPUNIT_ASSERT(e->isAncestorOf(*b));
+   CPPUNIT_ASSERT(r->isAncestorOf(*b));
+   CPPUNIT_ASSERT_EQUAL(3u, b->getDepth());
+
+   // Changes to the child list as a whole are found on use
+   r->getChildren().erase(r->getChildren().begin());
+   CPPUNIT_ASSERT_EQUAL(0u, d->getIndex());
+   CPPUNIT_ASSERT(d->getPrevSibling().get() == NULL);
+
+   // Nodes of other trees are never descendants
+   cppdom::NodePtr other(new cppdom::Node("r", ctx));
+   CPPUNIT_ASSERT(!r->isAncestorOf(*other));
+   CPPUNIT_ASSERT(!other->isAncestorOf(*r));
+}
+
+void NodeTest::testNodePath()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Document doc(ctx);
+   std::istringstream in("<r><a><b/></a><a><b/><b/></a></r>");
+   doc.load(in, ctx);
+   cppdom::NodePtr r = doc.getChild("r");
+   cppdom::NodeList as = r->getChildren("a");
+   cppdom::NodePtr b0 = as[0]->getChild("b");
+   cppdom::NodePtr b2 = as[1]->getChildren()[1];
+
+   CPPUNIT_ASSERT_EQUAL(std::string("r/a/b"), b2->getPath().substr(b2->getPath().size() - 5));
+   const cppdom::NodePath& path = b2->getNodePath();
+   CPPUNIT_ASSERT_EQUAL(std::size_t(4), path.getLength());
+   CPPUNIT_ASSERT_EQUAL(1u, path.getIndex(2));
+   CPPUNIT_ASSERT_EQUAL(1u, path.getIndex(3));
+   CPPUNIT_ASSERT(path.getNameHandle(3) == b2->getNameHandle());
+   CPPUNIT_ASSERT_EQUAL(b2->getPath(), path.getString(*ctx));
+   CPPUNIT_ASSERT(path.getString(*ctx, true).find("r[0]/a[1]/b[1]") != std::string::npos);
+
+   // Same names at other positions are other paths
+   const cppdom::NodePath other = as[1]->getChildren()[0]->getNodePath();
+   CPPUNIT_ASSERT(path != other);
+   CPPUNIT_ASSERT(other < path);
+   CPPUNIT_ASSERT(!(path < other));
+   CPPUNIT_ASSERT(b0->getNodePath() < other);
+   CPPUNIT_ASSERT(as[1]->getNodePath() < path);
+
+   // Paths of copies of a tree are equal and hash the same
+   cppdom::Document copy(ctx);
+   std::istringstream in2("<r><a><b/></a><a><b/><b/></a></r>");
+   copy.load(in2, ctx);
+   const cppdom::NodePath& copied =
+      copy.getChild("r")->getChildren("a")[1]->getChildren()[1]->getNodePath();
+   CPPUNIT_ASSERT(copied == path);
+   CPPUNIT_ASSERT(cppdom::NodePathHash()(copied) == cppdom::NodePathHash()(path));
+
+   // Kept paths follow changes of the tree, returned ones do not
+   as[1]->removeChild(as[1]->getChildren()[0]);
+   CPPUNIT_ASSERT_EQUAL(0u, b2->getNodePath().getIndex(3));
+   CPPUNIT_ASSERT(b2->getNodePath() == other);
+   CPPUNIT_ASSERT_EQUAL(1u, path.getIndex(3));
+   as[1]->setName("c");
+   CPPUNIT_ASSERT(b2->getNodePath().getString(*ctx).find("r/c/b") != std::string::npos);
+   CPPUNIT_ASSERT_EQUAL(b2->getPath(), b2->getNodePath().getString(*ctx));
+   CPPUNIT_ASSERT(b0->getNodePath() < b2->getNodePath());
+   CPPUNIT_ASSERT_EQUAL(b0->getPath(), b0->getNodePath().getString(*ctx));
+
+   // Paths built with push compare to those of nodes
+   cppdom::NodePath built;
+   for (std::size_t i = 0; i < path.getLength(); ++i)
+   {  built.push(path.getNameHandle(i), path.getIndex(i)); }
+   CPPUNIT_ASSERT(built == path);
+   CPPUNIT_ASSERT(cppdom::NodePathHash()(built) == cppdom::NodePathHash()(path));
+   built.clear();
+   CPPUNIT_ASSERT_EQUAL(std::size_t(0), built.getLength());
+   CPPUNIT_ASSERT(built < path);
+}
+
+void NodeTest::testAttributeIndex()
+{
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Document doc(ctx);
+   std::istringstream in("<r><a id=\"1\" key=\"x\"><b id=\"2\"/></a><c id=\"3\"/></r>");
+   doc.load(in, ctx);
+   cppdom::NodePtr a = doc.getChild("r")->getChild("a");
+   cppdom::NodePtr c = doc.getChild("r")->getChild("c");
+
+   CPPUNIT_ASSERT(!doc.hasIndex("id"));
+   CPPUNIT_ASSERT_THROW(doc.findById("1"), cppdom::Error);
+   doc.buildIndex("id");
+   doc.buildIndex("key");
+   CPPUNIT_ASSERT(doc.hasIndex("id"));
+   CPPUNIT_ASSERT(doc.findById("1") == a);
+   CPPUNIT_ASSERT(doc.findById("2") == a->getChild("b"));
+   CPPUNIT_ASSERT(doc.findById("3") == c);
+   CPPUNIT_ASSERT(doc.findById("4").get() == NULL);
+   CPPUNIT_ASSERT(doc.findByAttribute("key", "x") == a);
+
+   // setAttribute moves the element to its new value
+   c->setAttribute("id", std::string("4"));
+   CPPUNIT_ASSERT(doc.findById("3").get() == NULL);
+   CPPUNIT_ASSERT(doc.findById("4") == c);
+
+   // Added subtrees are indexed, removed ones are not any more
+   cppdom::NodePtr d(new cppdom::Node("d", ctx));
+   d->setAttribute("id", std::string("5"));
+   cppdom::NodePtr e(new cppdom::Node("e", ctx));
+   e->setAttribute("id", std::string("6"));
+   d->addChild(e);
+   CPPUNIT_ASSERT(doc.findById("5").get() == NULL);
+   c->addChild(d);
+   CPPUNIT_ASSERT(doc.findById("5") == d);
+   CPPUNIT_ASSERT(doc.findById("6") == e);
+   doc.getChild("r")->removeChild(a);
+   CPPUNIT_ASSERT(doc.findById("1").get() == NULL);
+   CPPUNIT_ASSERT(doc.findById("2").get() == NULL);
+   CPPUNIT_ASSERT(doc.findByAttribute("key", "x").get() == NULL);
+
+   // Changes of removed nodes and of other documents are not seen
+   a->setAttribute("id", std::string("7"));
+   CPPUNIT_ASSERT(doc.findById("7").get() == NULL);
+
+   // A loaded binary image is indexed again
+   std::ostringstream image;
+   doc.saveBinary(image);
+   cppdom::Document other(ctx);
+   other.buildIndex("id");
+   std::istringstream image_in(image.str());
+   other.loadBinary(image_in);
+   CPPUNIT_ASSERT(other.findById("6").get() != NULL);
+   CPPUNIT_ASSERT_EQUAL(std::string("e"), other.findById("6")->getName());
+   CPPUNIT_ASSERT(other.findById("6") != e);
+
+   // Changes the index does not see never give a wrong element
+   cppdom::NodePtr r = doc.getChild("r");
+   c->attrib()["id"] = cppdom::Attribute(std::string("8"));
+   CPPUNIT_ASSERT(doc.findById("4").get() == NULL);
+   c->getChildren().clear();
+   CPPUNIT_ASSERT(doc.findById("5").get() == NULL);
+   CPPUNIT_ASSERT(doc.findById("6").get() == NULL);
+   doc.buildIndex("id");
+   CPPUNIT_ASSERT(doc.findById("8") == c);
+
+   // Assignment replaces the entries of the content
+   r->addChild(a);
+   *c = *a;
+   CPPUNIT_ASSERT(doc.findById("8").get() == NULL);
+   CPPUNIT_ASSERT(doc.findById("7") == a || doc.findById("7") == c);
+   c->setAttribute("id", std::string("8"));
+   CPPUNIT_ASSERT(doc.findById("7") == a);
+   CPPUNIT_ASSERT(doc.findById("8") == c);
+
+   // Elements loaded in place are indexed
+   cppdom::NodePtr g(new cppdom::Node("g", ctx));
+   r->addChild(g);
+   std::istringstream node_in("<g id=\"9\"><f id=\"10\"/></g>");
+   g->load(node_in, ctx);
+   CPPUNIT_ASSERT(doc.findById("9") == g);
+   CPPUNIT_ASSERT(doc.findById("10") == g->getChild("f"));
+
+   doc.dropIndex("id");
+   CPPUNIT_ASSERT(!doc.hasIndex("id"));
+   r->removeChild(c);
+   CPPUNIT_ASSERT(doc.findByAttribute("key", "x") == a);
+   doc.dropIndex("key");
+   a->setAttribute("key", std::string("y"));
+   CPPUNIT_ASSERT_THROW(doc.findByAttribute("key", "y"), cppdom::Error);
 }
 
 }
@@ -52,6 +52,13 @@ class NodeTest : public CppUnit::TestFixture
 CPPUNIT_TEST_SUITE(NodeTest);
 CPPUNIT_TEST(testChildAccess);
 CPPUNIT_TEST(testEqual);
+CPPUNIT_TEST(testHash);
+CPPUNIT_TEST(testRemoveChildren);
+CPPUNIT_TEST(testClone);
+CPPUNIT_TEST(testCdataBinary);
+CPPUNIT_TEST(testDocumentOrder);
+CPPUNIT_TEST(testNodePath);
+CPPUNIT_TEST(testAttributeIndex);
 CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -62,6 +69,27 @@ public:
    /** Load and run the equal test. */
    void testEqual();
 
+   /** Structural hashes and their invalidation. */
+   void testHash();
+
+   /** Removal of children by node, by name and by predicate. */
+   void testRemoveChildren();
+
+   /** Deep and shallow clones, and moves where the compiler has them. */
+   void testClone();
+
+   /** Bytes set as cdata, read back, saved and hashed as base64 text. */
+   void testCdataBinary();
+
+   /** Sibling navigation, depth and preorder/postorder numbers. */
+   void testDocumentOrder();
+
+   /** Paths as handles, their strings and when the kept ones are rebuilt. */
+   void testNodePath();
+
+   /** Document attribute indexes and their upkeep through changes. */
+   void testAttributeIndex();
+
 };
 
 }
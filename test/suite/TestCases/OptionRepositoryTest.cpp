@@ -127,6 +127,12 @@ void OptionRepositoryTest::testOptionSetting()
    CPPUNIT_ASSERT(opts.hasOption("test_set_root") == true);
    std::string str_val = opts.getValue<std::string>("test_set_root");
    CPPUNIT_ASSERT(std::string("test string") == str_val);
+
+   // Values that are not a valid number are read like operator>> reads them
+   opts.setValue("test_set_option/intval", "12 px");
+   CPPUNIT_ASSERT(12 == opts.getValue<int>("test_set_option/intval"));
+   opts.setValue("test_set_option/intval", "1.5");
+   CPPUNIT_ASSERT(1 == opts.getValue<int>("test_set_option/intval"));
 }
 
 
@@ -0,0 +1,225 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ *
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+#include <TestCases/ParallelLoadTest.h>
+#include <TestCases/TestData.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <cppdom/cppdom.h>
+#include <cppdom/parallel.h>
+
+namespace cppdomtest
+{
+CPPUNIT_TEST_SUITE_REGISTRATION(ParallelLoadTest);
+
+namespace
+{
+   std::vector<std::string> testFiles()
+   {
+      std::vector<std::string> filenames;
+      for (unsigned i = 0; i < 8; ++i)
+      {
+         filenames.push_back(cppdomtest::game_xml_filename);
+         filenames.push_back(cppdomtest::hamlet_xml_filename);
+         filenames.push_back(cppdomtest::nodetest_xml_filename);
+         filenames.push_back(cppdomtest::simple_nodes_xml_filename);
+      }
+      return filenames;
+   }
+
+   /** a document with many root children, bad markup in child badChild */
+   std::string makeLargeDocument(unsigned numChildren, unsigned badChild)
+   {
+      std::ostringstream xml;
+      xml << "<?xml version=\"1.0\"?>\n<!-- export -->\n<export version=\"2\">\n";
+      for (unsigned i = 0; i < numChildren; ++i)
+      {
+         xml << "  <record id=\"" << i << "\" note='a > b'>\n"
+             << "    <!-- record <" << i << "> -->\n"
+             << "    <name>Record number " << i << "</name>\n"
+             << "    <empty/>\n"
+             << (i == badChild ? "  </wrong>\n" : "  </record>\n");
+      }
+      xml << "  trailing text\n</export>\n";
+      return xml.str();
+   }
+}
+
+void ParallelLoadTest::testLoadOrder()
+{
+   const std::vector<std::string> filenames = testFiles();
+   cppdom::LoadResultList results = cppdom::loadDocumentsParallel(filenames, 4);
+   CPPUNIT_ASSERT(results.size() == filenames.size());
+
+   for (unsigned i = 0; i < filenames.size(); ++i)
+   {
+      CPPUNIT_ASSERT(results[i].isOk());
+      CPPUNIT_ASSERT(results[i].getFilename() == filenames[i]);
+
+      cppdom::DocumentPtr expected(new cppdom::Document);
+      expected->loadFile(filenames[i]);
+      CPPUNIT_ASSERT(results[i].getDocument()->isEqual(expected));
+   }
+
+   // Contexts are per document unless one is given
+   CPPUNIT_ASSERT(results[0].getDocument()->getContext() != results[1].getDocument()->getContext());
+}
+
+void ParallelLoadTest::testSharedContext()
+{
+   const std::vector<std::string> filenames = testFiles();
+   cppdom::ContextPtr context(new cppdom::Context);
+   cppdom::LoadResultList results = cppdom::loadDocumentsParallel(filenames, 0, context);
+
+   for (unsigned i = 0; i < results.size(); ++i)
+   {
+      CPPUNIT_ASSERT(results[i].isOk());
+      CPPUNIT_ASSERT(results[i].getDocument()->getContext() == context);
+   }
+   CPPUNIT_ASSERT(results[0].getDocument()->getChildren()[0]->getNameHandle() ==
+                  results[4].getDocument()->getChildren()[0]->getNameHandle());
+}
+
+void ParallelLoadTest::testErrors()
+{
+   const std::string bad_filename("ParallelLoadTestBad.xml");
+   {
+      std::ofstream out(bad_filename.c_str());
+      out << "<root>\n  <child>\n  </wrong>\n</root>\n";
+   }
+
+   std::vector<std::string> filenames;
+   filenames.push_back(cppdomtest::game_xml_filename);
+   filenames.push_back("data/does_not_exist.xml");
+   filenames.push_back(bad_filename);
+   filenames.push_back(cppdomtest::nodetest_xml_filename);
+
+   cppdom::LoadResultList results = cppdom::loadDocumentsParallel(filenames, 2);
+   std::remove(bad_filename.c_str());
+
+   CPPUNIT_ASSERT(results[0].isOk());
+   CPPUNIT_ASSERT(results[3].isOk());
+
+   CPPUNIT_ASSERT(!results[1].isOk());
+   CPPUNIT_ASSERT(results[1].getDocument().get() == NULL);
+   CPPUNIT_ASSERT(results[1].getError() == cppdom::xml_filename_invalid);
+
+   CPPUNIT_ASSERT(!results[2].isOk());
+   CPPUNIT_ASSERT(results[2].getError() == cppdom::xml_tagname_close_mismatch);
+   CPPUNIT_ASSERT(!results[2].getErrorString().empty());
+   CPPUNIT_ASSERT_EQUAL(2, results[2].getLocation().getLine());
+}
+
+void ParallelLoadTest::testSingleDocument()
+{
+   std::vector<std::string> filenames;
+   filenames.push_back(cppdomtest::hamlet_xml_filename);
+   filenames.push_back(cppdomtest::rime_xml_filename);
+   filenames.push_back(cppdomtest::nodetest_xml_filename);
+   filenames.push_back(cppdomtest::game_xml_filename);
+
+   for (unsigned i = 0; i < filenames.size(); ++i)
+   {
+      cppdom::DocumentPtr expected(new cppdom::Document);
+      expected->loadFile(filenames[i]);
+
+      cppdom::DocumentPtr doc(new cppdom::Document);
+      cppdom::loadFileParallel(*doc, filenames[i], 4);
+      CPPUNIT_ASSERT(doc->isEqual(expected));
+      CPPUNIT_ASSERT(doc->getPiList().size() == expected->getPiList().size());
+   }
+
+   const std::string xml = makeLargeDocument(2000, unsigned(-1));
+   std::istringstream sequential_in(xml);
+   std::istringstream parallel_in(xml);
+   cppdom::ContextPtr context(new cppdom::Context);
+   cppdom::DocumentPtr expected(new cppdom::Document(context));
+   expected->load(sequential_in, context);
+
+   cppdom::DocumentPtr doc(new cppdom::Document(context));
+   cppdom::Location location;
+   cppdom::loadParallel(*doc, parallel_in, context, location, 4);
+   CPPUNIT_ASSERT(doc->isEqual(expected));
+   CPPUNIT_ASSERT(doc->getChild("export")->getChildren().size() == 2001);
+
+   // One thread reads the stream directly
+   std::istringstream single_in(xml);
+   cppdom::DocumentPtr single(new cppdom::Document(context));
+   cppdom::loadParallel(*single, single_in, context, location, 1);
+   CPPUNIT_ASSERT(single->isEqual(expected));
+}
+
+void ParallelLoadTest::testSingleDocumentError()
+{
+   const std::string xml = makeLargeDocument(2000, 1500);
+   cppdom::ContextPtr context(new cppdom::Context);
+
+   cppdom::Location sequential_location;
+   cppdom::ErrorCode sequential_error(cppdom::xml_unknown);
+   try
+   {
+      std::istringstream in(xml);
+      cppdom::DocumentPtr doc(new cppdom::Document(context));
+      doc->load(in, context, sequential_location);
+      CPPUNIT_FAIL("Expected a parse error");
+   }
+   catch (cppdom::Error& e)
+   {  sequential_error = e.getError(); }
+
+   cppdom::Location parallel_location;
+   cppdom::ErrorCode parallel_error(cppdom::xml_unknown);
+   try
+   {
+      std::istringstream in(xml);
+      cppdom::DocumentPtr doc(new cppdom::Document(context));
+      cppdom::loadParallel(*doc, in, context, parallel_location, 4);
+      CPPUNIT_FAIL("Expected a parse error");
+   }
+   catch (cppdom::Error& e)
+   {  parallel_error = e.getError(); }
+
+   CPPUNIT_ASSERT(sequential_error == cppdom::xml_tagname_close_mismatch);
+   CPPUNIT_ASSERT(parallel_error == sequential_error);
+   CPPUNIT_ASSERT_EQUAL(sequential_location.getLine(), parallel_location.getLine());
+   CPPUNIT_ASSERT_EQUAL(sequential_location.getPos(), parallel_location.getPos());
+}
+
+}
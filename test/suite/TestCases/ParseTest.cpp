@@ -43,6 +43,7 @@
 #include <Suites.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 #include <cppdom/cppdom.h>
 
@@ -62,6 +63,267 @@ void ParseTest::loadTestDocs()
 //   doc = loadDocNoCatch(cppdomtest::xml_spec_filename);
 }
 
+void ParseTest::testMarkup()
+{
+   const std::string xml =
+      "<?xml version=\"1.0\"?>\n"
+      "<!-- before the root -->\n"
+      "<root>text <![CDATA[<raw> & ]]]]>more<!-- a -- comment -->"
+      "<?app do this?><a/><!----></root> trailing";
+
+   // by default comments and pis are skipped, cdata sections are text
+   {
+      cppdom::ContextPtr ctx(new cppdom::Context);
+      cppdom::Document doc(ctx);
+      std::istringstream in(xml);
+      doc.load(in, ctx);
+
+      CPPUNIT_ASSERT_EQUAL(std::string("xml"), doc.getPiList().front()->getName());
+      CPPUNIT_ASSERT_EQUAL(std::string("1.0"), doc.getPiList().front()->getAttribute("version").getString());
+
+      cppdom::NodePtr root = doc.getChild("root");
+      cppdom::NodeList& children = root->getChildren();
+      CPPUNIT_ASSERT_EQUAL(size_t(4), children.size());
+      CPPUNIT_ASSERT_EQUAL(std::string("text "), children[0]->getCdata());
+      CPPUNIT_ASSERT(children[1]->isCData());
+      CPPUNIT_ASSERT_EQUAL(std::string("<raw> & ]]"), children[1]->getCdata());
+      CPPUNIT_ASSERT_EQUAL(std::string("more"), children[2]->getCdata());
+      CPPUNIT_ASSERT_EQUAL(std::string("a"), children[3]->getName());
+
+      // the stream is left after the root element
+      std::string rest;
+      std::getline(in, rest);
+      CPPUNIT_ASSERT_EQUAL(std::string(" trailing"), rest);
+   }
+
+   // kept, they save and load again
+   {
+      cppdom::ContextPtr ctx(new cppdom::Context);
+      ctx->setKeepComments(true);
+      ctx->setKeepProcessingInstructions(true);
+      cppdom::Document doc(ctx);
+      std::istringstream in(xml);
+      doc.load(in, ctx);
+
+      cppdom::NodeList& children = doc.getChild("root")->getChildren();
+      CPPUNIT_ASSERT_EQUAL(size_t(7), children.size());
+      CPPUNIT_ASSERT(children[3]->isComment());
+      CPPUNIT_ASSERT_EQUAL(std::string(" a -- comment "), children[3]->getCdata());
+      CPPUNIT_ASSERT(children[4]->isPi());
+      CPPUNIT_ASSERT_EQUAL(std::string("app"), children[4]->getName());
+      CPPUNIT_ASSERT_EQUAL(std::string("do this"), children[4]->getCdata());
+      CPPUNIT_ASSERT(children[6]->isComment());
+      CPPUNIT_ASSERT_EQUAL(std::string(""), children[6]->getCdata());
+
+      // comments do not count as the text of their parent
+      CPPUNIT_ASSERT_EQUAL(std::string("text <raw> & ]]more"), doc.getChild("root")->getFullCdata());
+
+      std::ostringstream out;
+      doc.getChild("root")->save(out, 0, false, false);
+      CPPUNIT_ASSERT_EQUAL(std::string("<root>text &lt;raw&gt; &amp; ]]more<!-- a -- comment -->"
+                                       "<?app do this?><a/><!----></root>"), out.str());
+
+      // the saved text is one cdata node, the rest keeps its shape
+      cppdom::Node copy(ctx);
+      std::istringstream again(out.str());
+      copy.load(again, ctx);
+      std::ostringstream out_again;
+      copy.save(out_again, 0, false, false);
+      CPPUNIT_ASSERT_EQUAL(out.str(), out_again.str());
+   }
+
+   // markup without its end
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Node node(ctx);
+   std::istringstream broken("<root><!-- no end </root>");
+   CPPUNIT_ASSERT_THROW(node.load(broken, ctx), cppdom::Error);
+}
+
+void ParseTest::testLargeCdataSection()
+{
+   // base64-like payload, far larger than a block of the tokenizer
+   std::string payload;
+   const char* digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+   for (unsigned i = 0; i < 3000000; ++i)
+   {
+      payload += digits[(i * 7 + i / 64) % 64];
+      if (i % 76 == 75)
+      {  payload += '\n'; }
+   }
+
+   const std::string xml = "<blob type=\"base64\">\n<![CDATA[" + payload + "]]>\n</blob>";
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Node node(ctx);
+   std::istringstream in(xml);
+   node.load(in, ctx);
+
+   CPPUNIT_ASSERT_EQUAL(size_t(1), node.getChildren().size());
+   CPPUNIT_ASSERT(node.getChildren()[0]->isCData());
+   CPPUNIT_ASSERT(payload == node.getCdata());
+}
+
+void ParseTest::testBase64Elements()
+{
+   std::string bytes;
+   for (unsigned i = 0; i < 100000; ++i)
+   {  bytes += char(i * 31 + i / 256); }
+
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Node blob("texture", ctx);
+   blob.setCdataBinary(bytes.data(), bytes.size());
+   std::ostringstream out;
+   out << "<data><texture>\n";
+   blob.getChildren()[0]->save(out, 0, false, false);
+   out << "\n</texture><calib><![CDATA[AAEC]]></calib><name>AAEC</name></data>";
+
+   ctx->addBase64Element("texture");
+   ctx->addBase64Element("calib");
+   cppdom::Node node(ctx);
+   std::istringstream in(out.str());
+   node.load(in, ctx);
+
+   std::vector<unsigned char> data;
+   CPPUNIT_ASSERT(node.getChild("texture")->getCdataBinary(data));
+   CPPUNIT_ASSERT(bytes == std::string(data.begin(), data.end()));
+   CPPUNIT_ASSERT(node.getChild("calib")->getCdataBinary(data));
+   CPPUNIT_ASSERT_EQUAL(std::size_t(3), data.size());
+   CPPUNIT_ASSERT_EQUAL(std::string("AAEC"), node.getChild("calib")->getCdata());
+   CPPUNIT_ASSERT_EQUAL(std::string("AAEC"), node.getChild("name")->getCdata());
+
+   // text that is not base64
+   cppdom::Node bad(ctx);
+   std::istringstream bad_in("<data><texture>AA*C</texture></data>");
+   CPPUNIT_ASSERT_THROW(bad.load(bad_in, ctx), cppdom::Error);
+}
+
+void ParseTest::testWhitespaceModes()
+{
+   const std::string text("<?xml version=\"1.0\"?>\n<data>\n  <a>  one two \n</a>\n  <b/>  </data>\n");
+   cppdom::ContextPtr ctx(new cppdom::Context);
+
+   // default: leading whitespace goes, and with it whitespace-only text
+   cppdom::Document doc_default(ctx);
+   std::istringstream in_default(text);
+   doc_default.load(in_default, ctx);
+   CPPUNIT_ASSERT_EQUAL(std::size_t(2), doc_default.getChild("data")->getChildren().size());
+   CPPUNIT_ASSERT_EQUAL(std::string("one two \n"), doc_default.getChild("data")->getChild("a")->getCdata());
+
+   ctx->setWhitespaceMode(cppdom::Context::xml_ws_drop_blank);
+   cppdom::Document doc_blank(ctx);
+   std::istringstream in_blank(text);
+   doc_blank.load(in_blank, ctx);
+   CPPUNIT_ASSERT_EQUAL(std::size_t(2), doc_blank.getChild("data")->getChildren().size());
+   CPPUNIT_ASSERT_EQUAL(std::string("  one two \n"), doc_blank.getChild("data")->getChild("a")->getCdata());
+
+   ctx->setWhitespaceMode(cppdom::Context::xml_ws_trim);
+   cppdom::Document doc_trim(ctx);
+   std::istringstream in_trim(text);
+   doc_trim.load(in_trim, ctx);
+   CPPUNIT_ASSERT_EQUAL(std::size_t(2), doc_trim.getChild("data")->getChildren().size());
+   CPPUNIT_ASSERT_EQUAL(std::string("one two"), doc_trim.getChild("data")->getChild("a")->getCdata());
+
+   // preserve: the whitespace between the elements becomes cdata nodes
+   ctx->setWhitespaceMode(cppdom::Context::xml_ws_preserve);
+   cppdom::Document doc_preserve(ctx);
+   std::istringstream in_preserve(text);
+   doc_preserve.load(in_preserve, ctx);
+   cppdom::NodeList& kids = doc_preserve.getChild("data")->getChildren();
+   CPPUNIT_ASSERT_EQUAL(std::size_t(5), kids.size());
+   CPPUNIT_ASSERT(kids[0]->isCData());
+   CPPUNIT_ASSERT_EQUAL(std::string("\n  "), kids[0]->getCdata());
+   CPPUNIT_ASSERT_EQUAL(std::string("  one two \n"), kids[1]->getCdata());
+   CPPUNIT_ASSERT_EQUAL(std::string("\n  "), kids[2]->getCdata());
+   CPPUNIT_ASSERT_EQUAL(std::string("b"), kids[3]->getName());
+   CPPUNIT_ASSERT_EQUAL(std::string("  "), kids[4]->getCdata());
+
+   // trailing whitespace that spans the tokenizer's blocks is trimmed too
+   ctx->setWhitespaceMode(cppdom::Context::xml_ws_trim);
+   cppdom::Node big(ctx);
+   std::istringstream in_big("<data>  x" + std::string(40000, ' ') + "</data>");
+   big.load(in_big, ctx);
+   CPPUNIT_ASSERT_EQUAL(std::string("x"), big.getCdata());
+}
+
+namespace
+{
+   /** keeps the elements no deeper than mDepth */
+   class DepthFilter : public cppdom::ElementFilter
+   {
+   public:
+      DepthFilter(std::size_t depth)
+         : mDepth(depth)
+      {}
+
+      virtual bool keepElement(const std::vector<cppdom::TagNameHandle>& path,
+                               const cppdom::Context&)
+      {  return path.size() <= mDepth; }
+
+   private:
+      std::size_t mDepth;
+   };
+}
+
+void ParseTest::testElementFilter()
+{
+   // The skipped audio element has markup that only looks like tags, and
+   // more content than one block of the tokenizer
+   std::string audio("  <audio rate=\"44100\" note='a > b' tag=\"/>\">\n"
+                     "    <!-- </audio> --><![CDATA[ </audio> ]]><?pi </audio> ?>\n");
+   for (unsigned i = 0; i < 2000; ++i)
+   {  audio += "    <channel id=\"1\"><gain>0.5</gain><mute/></channel>\n"; }
+   audio += "  </audio>\n";
+   const std::string head("<?xml version=\"1.0\"?>\n<config>\n  <render mode=\"gl\"><size>3</size></render>\n");
+   const std::string tail("  <network port=\"80\"/>\n</config>\n");
+
+   cppdom::ContextPtr ctx(new cppdom::Context);
+   cppdom::Document expected(ctx);
+   std::istringstream expected_in(head + tail);
+   expected.load(expected_in, ctx);
+
+   cppdom::ContextPtr filter_ctx(new cppdom::Context);
+   cppdom_boost::shared_ptr<cppdom::PathFilter> paths(new cppdom::PathFilter);
+   paths->addPath("config/render");
+   paths->addPath("config/network");
+   filter_ctx->setElementFilter(paths);
+   cppdom::Document doc(filter_ctx);
+   std::istringstream in(head + audio + tail);
+   doc.load(in, filter_ctx);
+   CPPUNIT_ASSERT(doc.isEqual(cppdom::DocumentPtr(new cppdom::Document(expected))));
+   CPPUNIT_ASSERT_EQUAL(std::string("3"), doc.getChildPath("config/render/size")->getCdata());
+
+   // The location counts the skipped input
+   cppdom::ContextPtr full_ctx(new cppdom::Context);
+   cppdom::Document full(full_ctx);
+   std::istringstream full_in(head + audio + tail);
+   full.load(full_in, full_ctx);
+   CPPUNIT_ASSERT_EQUAL(full_ctx->getLocation().getLine(), filter_ctx->getLocation().getLine());
+   CPPUNIT_ASSERT_EQUAL(full_ctx->getLocation().getPos(), filter_ctx->getLocation().getPos());
+
+   // A filter on the depth
+   filter_ctx->setElementFilter(cppdom::ElementFilterPtr(new DepthFilter(2)));
+   cppdom::Document shallow(filter_ctx);
+   std::istringstream shallow_in(head + audio + tail);
+   shallow.load(shallow_in, filter_ctx);
+   cppdom::NodePtr config = shallow.getChild("config");
+   CPPUNIT_ASSERT_EQUAL(std::size_t(3), config->getChildren().size());
+   CPPUNIT_ASSERT(config->getChild("render")->getChildren().empty());
+   CPPUNIT_ASSERT(config->getChild("audio")->getChild("channel").get() == NULL);
+   CPPUNIT_ASSERT_EQUAL(std::string(" </audio> "), config->getChild("audio")->getCdata());
+
+   // Skipped content still has to end
+   cppdom::Document cut(filter_ctx);
+   std::istringstream cut_in("<config><a><b><c></b></a>");
+   CPPUNIT_ASSERT_THROW(cut.load(cut_in, filter_ctx), cppdom::Error);
+   // A rejected root is an error, not an empty document
+   cppdom::ContextPtr other_ctx(new cppdom::Context);
+   cppdom_boost::shared_ptr<cppdom::PathFilter> other_paths(new cppdom::PathFilter);
+   other_paths->addPath("other/x");
+   other_ctx->setElementFilter(other_paths);
+   cppdom::Document other(other_ctx);
+   std::istringstream other_in(head + tail);
+   CPPUNIT_ASSERT_THROW(other.load(other_in, other_ctx), cppdom::Error);
+}
+
 
 cppdom::DocumentPtr ParseTest::loadDocNoCatch(std::string filename)
 {
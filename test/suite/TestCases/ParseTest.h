@@ -51,6 +51,11 @@ class ParseTest : public CppUnit::TestFixture
 
 CPPUNIT_TEST_SUITE(ParseTest);
 CPPUNIT_TEST(loadTestDocs);
+CPPUNIT_TEST(testMarkup);
+CPPUNIT_TEST(testLargeCdataSection);
+CPPUNIT_TEST(testBase64Elements);
+CPPUNIT_TEST(testWhitespaceModes);
+CPPUNIT_TEST(testElementFilter);
 CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -58,6 +63,17 @@ public:
    /** Just load up a bunch of test documents with no errors. */
    void loadTestDocs();
 
+   /** Cdata sections, comments and processing instructions */
+   void testMarkup();
+
+   /** A cdata section much larger than the read buffer */
+   void testLargeCdataSection();
+
+   /** Text of base64 elements decoded while parsing */
+   void testBase64Elements();
+   void testWhitespaceModes();
+   void testElementFilter();
+
 public:
    // Load the named file without catching exceptions
    cppdom::DocumentPtr loadDocNoCatch(std::string filename);
@@ -239,6 +239,147 @@ void SpiritTest::testXmlParser()
 }
 
 
+void SpiritTest::testBuilder()
+{
+   std::string xml(
+            "<root><node1 attrib='value'>"
+            "<node2 a1='val a1' a2='1.567' a3='&lt;false'>"
+            "<node3><node4>"
+            "Stuff<!-- More here -->And &lt;more<b>this</b>dfdf"
+            "</node4>txt and txt </node3>  aa</node2><leaf/></node1>"
+            "</root>"
+            );
+
+   cppdom::ContextPtr ctx(new cppdom::Context());
+   cppdom::DocumentPtr expected(new cppdom::Document(ctx));
+   std::istringstream in(xml);
+   expected->load(in, ctx);
+
+   cppdom::spirit::Parser spirit_parser;
+   cppdom::DocumentPtr doc(new cppdom::Document(ctx));
+   spirit_parser.parseDocument(*doc, xml);
+   CPPUNIT_ASSERT(doc->getChild("root")->isEqual(expected->getChild("root")));
+   CPPUNIT_ASSERT_EQUAL(std::string("<false"),
+      doc->getChildPath("root/node1/node2")->getAttribute("a3").getString());
+   CPPUNIT_ASSERT(doc->getChildPath("root/node1/leaf")->isLeaf());
+
+   // Tracing is a compile time choice
+   typedef cppdom::spirit::XmlBuilder<const char*, cppdom::spirit::StreamTrace> tracing_builder_t;
+   tracing_builder_t tracing_builder;
+   std::ostringstream trace;
+   tracing_builder.setTrace(cppdom::spirit::StreamTrace(trace));
+   cppdom::DocumentPtr traced(new cppdom::Document(ctx));
+   tracing_builder.reinit(traced.get(), ctx);
+   cppdom::spirit::XmlGrammar<tracing_builder_t> tracing_grammar(&tracing_builder);
+   std::string small("<root a='1'>text<leaf/></root>");
+   CPPUNIT_ASSERT(bs::parse(small.c_str(), tracing_grammar).full);
+   CPPUNIT_ASSERT(traced->getChild("root")->getChild("leaf").get() != NULL);
+   CPPUNIT_ASSERT(trace.str().find("Elt in: [root]") != std::string::npos);
+   CPPUNIT_ASSERT(trace.str().find("Text: [text]") != std::string::npos);
+   CPPUNIT_ASSERT(trace.str().find("Elt exit: root") != std::string::npos);
+
+   std::string mismatch("<root><a></b></root>");
+   cppdom::DocumentPtr bad(new cppdom::Document(ctx));
+   CPPUNIT_ASSERT_THROW(spirit_parser.parseDocument(*bad, mismatch), cppdom::Error);
+}
+
+
+void SpiritTest::testInputs()
+{
+   std::string xml("<?xml version=\"1.0\"?>\n<root a='1'>\n");
+   for (int i = 0; i < 2000; ++i)
+   {
+      xml += "  <item id='x y' n='";
+      xml += char('0' + i % 10);
+      xml += "'>some  text &amp; more</item>\n  <leaf/>\n";
+   }
+   xml += "</root>\n";
+
+   cppdom::ContextPtr ctx(new cppdom::Context());
+   cppdom::spirit::Parser spirit_parser;
+   cppdom::DocumentPtr from_string(new cppdom::Document(ctx));
+   spirit_parser.parseDocument(*from_string, xml);
+   cppdom::NodePtr root = from_string->getChild("root");
+   CPPUNIT_ASSERT_EQUAL(std::size_t(4000), root->getChildren().size());
+   CPPUNIT_ASSERT_EQUAL(std::string("x y"), root->getChild("item")->getAttribute("id").getString());
+
+   // Whitespace in the stream is kept
+   std::istringstream in1(xml);
+   cppdom::DocumentPtr from_istream(new cppdom::Document(ctx));
+   spirit_parser.parseDocument(*from_istream, in1);
+   CPPUNIT_ASSERT(from_istream->getChild("root")->isEqual(root));
+
+   // A lookahead far smaller than the document
+   std::istringstream in2(xml);
+   cppdom::DocumentPtr streamed(new cppdom::Document(ctx));
+   spirit_parser.parseStream(*streamed, in2, 256);
+   CPPUNIT_ASSERT(streamed->getChild("root")->isEqual(root));
+
+   // Text longer than the lookahead is an error
+   std::string long_text("<root>");
+   long_text.append(100000, 'x');
+   long_text += "</root>";
+   std::istringstream in3(long_text);
+   cppdom::DocumentPtr too_long(new cppdom::Document(ctx));
+   CPPUNIT_ASSERT_THROW(spirit_parser.parseStream(*too_long, in3, 256), cppdom::Error);
+
+   std::istringstream in4(long_text);
+   cppdom::DocumentPtr long_enough(new cppdom::Document(ctx));
+   spirit_parser.parseStream(*long_enough, in4);
+   CPPUNIT_ASSERT_EQUAL(std::size_t(100000), long_enough->getChild("root")->getCdata().size());
+
+   cppdom::DocumentPtr missing(new cppdom::Document(ctx));
+   CPPUNIT_ASSERT_THROW(spirit_parser.parseFile(*missing, "not/there.xml"), cppdom::Error);
+}
+
+
+namespace
+{
+   struct UntrimmedXmlPolicy : public cppdom::spirit::FullXmlPolicy
+   {
+      enum { trimText = false };
+   };
+}
+
+void SpiritTest::testPolicies()
+{
+   std::string plain("<root a='1'><item n='x &lt; y'>text &amp; more</item>\n <leaf/></root>");
+
+   cppdom::ContextPtr ctx(new cppdom::Context());
+   cppdom::spirit::Parser spirit_parser;
+   cppdom::DocumentPtr full(new cppdom::Document(ctx));
+   spirit_parser.parseDocument(*full, plain);
+   cppdom::NodePtr root = full->getChild("root");
+   CPPUNIT_ASSERT_EQUAL(std::string("x < y"), root->getChild("item")->getAttribute("n").getString());
+   CPPUNIT_ASSERT_EQUAL(std::string("text & more"), root->getChild("item")->getCdata());
+
+   // Trusted input: entity references are left alone
+   cppdom::DocumentPtr trusted(new cppdom::Document(ctx));
+   spirit_parser.parseRange<cppdom::spirit::TrustedXmlPolicy>(*trusted, plain.data(),
+                                                              plain.data() + plain.size());
+   cppdom::NodePtr trusted_root = trusted->getChild("root");
+   CPPUNIT_ASSERT_EQUAL(std::string("x &lt; y"), trusted_root->getChild("item")->getAttribute("n").getString());
+   CPPUNIT_ASSERT_EQUAL(std::string("text &amp; more"), trusted_root->getChild("item")->getCdata());
+   std::vector<std::string> no_attribs, ignore_item(1, "item");
+   CPPUNIT_ASSERT(trusted_root->isEqual(root, no_attribs, ignore_item));
+
+   // Features switched off do not parse
+   std::string commented("<root><!-- note --><item/></root>");
+   cppdom::DocumentPtr doc(new cppdom::Document(ctx));
+   spirit_parser.parseDocument(*doc, commented);
+   cppdom::DocumentPtr bad(new cppdom::Document(ctx));
+   CPPUNIT_ASSERT_THROW(spirit_parser.parseRange<cppdom::spirit::TrustedXmlPolicy>(*bad,
+                           commented.data(), commented.data() + commented.size()), cppdom::Error);
+
+   // Whitespace is kept when text is not trimmed
+   cppdom::DocumentPtr untrimmed(new cppdom::Document(ctx));
+   spirit_parser.parseRange<UntrimmedXmlPolicy>(*untrimmed, plain.data(), plain.data() + plain.size());
+   cppdom::NodeList& children = untrimmed->getChild("root")->getChildren();
+   CPPUNIT_ASSERT_EQUAL(std::size_t(3), children.size());
+   CPPUNIT_ASSERT_EQUAL(std::string("\n "), children[1]->getCdata());
+}
+
+
 }  // namespace cppdomtest
 
 
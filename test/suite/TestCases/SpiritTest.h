@@ -50,6 +50,9 @@ class SpiritTest : public CppUnit::TestFixture
 
    CPPUNIT_TEST(testBasics);
    CPPUNIT_TEST(testXmlParser);
+   CPPUNIT_TEST(testBuilder);
+   CPPUNIT_TEST(testInputs);
+   CPPUNIT_TEST(testPolicies);
 
    CPPUNIT_TEST_SUITE_END();
 
@@ -57,6 +60,15 @@ public:
    void testBasics();
    
    void testXmlParser();
+
+   /** The spirit builder makes the same tree as cppdom::Parser. */
+   void testBuilder();
+
+   /** Strings, streams and bounded streaming give the same tree. */
+   void testInputs();
+
+   /** Grammar features switched off at compile time. */
+   void testPolicies();
 };
 
 }
@@ -0,0 +1,242 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil c-basic-offset: 3 -*- */
+// vim:cindent:ts=3:sw=3:et:tw=80:sta:
+/*************************************************************** cppdom-cpr beg
+ *
+ * cppdom was forked from the original xmlpp version 0.6 under the LGPL. This
+ * new, branched xmlpp is under the same LGPL (of course) and is being
+ * maintained by:
+ *      Kevin Meinert   <subatomic@users.sourceforge.net>
+ *      Allen Bierbaum  <allenb@users.sourceforge.net>
+ *      Ben Scott       <nonchocoboy@users.sourceforge.net>
+ *
+ * -----------------------------------------------------------------
+ *
+ * xmlpp - an xml parser and validator written in C++
+ * copyright (c) 2000-2001 Michael Fink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * -----------------------------------------------------------------
+ * File:          $RCSfile$
+ * Date modified: $Date$
+ * Version:       $Revision$
+ * -----------------------------------------------------------------
+ *
+ ************************************************************ cppdom-cpr-end */
+#include <TestCases/ThreadTest.h>
+#include <TestCases/TestData.h>
+
+#include <fstream>
+#include <sstream>
+#include <limits>
+
+#include <cppdom/cppdom.h>
+
+#ifdef CPPDOM_HAS_STD_THREAD
+#  include <thread>
+#endif
+
+namespace cppdomtest
+{
+CPPUNIT_TEST_SUITE_REGISTRATION(ThreadTest);
+
+namespace
+{
+   const unsigned num_threads = 8;
+
+   /** Runs the read-only queries over a whole subtree, returns a checksum. */
+   unsigned long queryTree(cppdom::NodePtr node)
+   {
+      unsigned long sum = node->getName().size() + node->getCdata().size();
+      sum += node->getFullCdata().size();
+      sum += node->getAttribute("id").getString().size();
+      sum += node->getChildren("SPEECH").size();
+      if (node->hasChild("TITLE"))
+      {  sum += node->getChild("TITLE")->getFullCdata().size(); }
+
+      cppdom::NodeList& children = node->getChildren();
+      for (cppdom::NodeList::iterator i = children.begin(); i != children.end(); ++i)
+      {
+         sum += queryTree(*i);
+      }
+      return sum;
+   }
+
+#ifdef CPPDOM_HAS_STD_THREAD
+   void readerThread(cppdom::DocumentPtr doc, unsigned rounds, unsigned long* result)
+   {
+      unsigned long sum(0);
+      for (unsigned r = 0; r < rounds; ++r)
+      {
+         sum = queryTree(doc->getChild("PLAY"));
+      }
+      *result = sum;
+   }
+
+   void copyThread(cppdom::NodePtr node, unsigned rounds)
+   {
+      for (unsigned r = 0; r < rounds; ++r)
+      {
+         cppdom::NodeList copies(node->getChildren());
+         cppdom::NodePtr another(node);
+      }
+   }
+
+   void parseThread(cppdom::ContextPtr context, std::string filename, cppdom::DocumentPtr* result)
+   {
+      std::ifstream in(filename.c_str());
+      cppdom::Location location;
+      cppdom::DocumentPtr doc(new cppdom::Document(context));
+      doc->load(in, context, location);
+      *result = doc;
+   }
+#endif
+
+   const unsigned num_names = 5000;
+
+   std::string makeName(unsigned i)
+   {
+      std::ostringstream name;
+      name << "name_" << i;
+      return name.str();
+   }
+
+   /** inserts all names starting at a different place per thread */
+   void internThread(cppdom::ContextPtr context, unsigned start, std::vector<cppdom::TagNameHandle>* handles)
+   {
+      handles->assign(num_names, -1);
+      for (unsigned n = 0; n < num_names; ++n)
+      {
+         const unsigned i = (start + n * 7) % num_names;
+         (*handles)[i] = context->insertTagname(makeName(i));
+      }
+   }
+
+}
+
+void ThreadTest::testConcurrentReaders()
+{
+#ifdef CPPDOM_HAS_STD_THREAD
+   cppdom::DocumentPtr doc(new cppdom::Document);
+   doc->loadFile(cppdomtest::hamlet_xml_filename);
+   const unsigned long expected = queryTree(doc->getChild("PLAY"));
+
+   std::vector<unsigned long> results(num_threads, 0);
+   std::vector<std::thread> threads;
+   for (unsigned t = 0; t < num_threads; ++t)
+   {
+      threads.push_back(std::thread(readerThread, doc, 10, &results[t]));
+   }
+   for (unsigned t = 0; t < num_threads; ++t)
+   {
+      threads[t].join();
+      CPPUNIT_ASSERT_EQUAL(expected, results[t]);
+   }
+#endif
+}
+
+void ThreadTest::testConcurrentPointerCopies()
+{
+#ifdef CPPDOM_HAS_STD_THREAD
+   cppdom::DocumentPtr doc(new cppdom::Document);
+   doc->loadFile(cppdomtest::game_xml_filename);
+   cppdom::NodePtr root = doc->getChild("gameinput");
+   const long root_count = root.use_count();
+   const long child_count = root->getChildren()[0].use_count();
+
+   std::vector<std::thread> threads;
+   for (unsigned t = 0; t < num_threads; ++t)
+   {
+      threads.push_back(std::thread(copyThread, root, 20000));
+   }
+   for (unsigned t = 0; t < num_threads; ++t)
+   {  threads[t].join(); }
+
+   CPPUNIT_ASSERT_EQUAL(root_count, root.use_count());
+   CPPUNIT_ASSERT_EQUAL(child_count, root->getChildren()[0].use_count());
+#endif
+}
+
+void ThreadTest::testInterning()
+{
+   cppdom::ContextPtr context(new cppdom::Context);
+   std::vector<std::vector<cppdom::TagNameHandle> > handles(num_threads);
+
+#ifdef CPPDOM_HAS_STD_THREAD
+   std::vector<std::thread> threads;
+   for (unsigned t = 0; t < num_threads; ++t)
+   {
+      threads.push_back(std::thread(internThread, context, t * 613, &handles[t]));
+   }
+   for (unsigned t = 0; t < num_threads; ++t)
+   {  threads[t].join(); }
+#else
+   for (unsigned t = 0; t < num_threads; ++t)
+   {  internThread(context, t * 613, &handles[t]); }
+#endif
+
+   std::vector<bool> used(num_names, false);
+   for (unsigned i = 0; i < num_names; ++i)
+   {
+      const cppdom::TagNameHandle handle = handles[0][i];
+      CPPUNIT_ASSERT(handle >= 0 && handle < cppdom::TagNameHandle(num_names));
+      CPPUNIT_ASSERT(!used[handle]);
+      used[handle] = true;
+
+      for (unsigned t = 1; t < num_threads; ++t)
+      {  CPPUNIT_ASSERT_EQUAL(handle, handles[t][i]); }
+      CPPUNIT_ASSERT(makeName(i) == context->getTagname(handle));
+      CPPUNIT_ASSERT_EQUAL(handle, context->findTagname(makeName(i)));
+   }
+   CPPUNIT_ASSERT_EQUAL(cppdom::TagNameHandle(-1), context->findTagname("never_inserted"));
+   CPPUNIT_ASSERT(context->getTagname(cppdom::TagNameHandle(num_names)).empty());
+   CPPUNIT_ASSERT(context->getTagname(std::numeric_limits<cppdom::TagNameHandle>::max()).empty());
+}
+
+void ThreadTest::testSharedContextParsing()
+{
+#ifdef CPPDOM_HAS_STD_THREAD
+   cppdom::ContextPtr context(new cppdom::Context);
+   std::vector<std::string> filenames;
+   filenames.push_back(cppdomtest::hamlet_xml_filename);
+   filenames.push_back(cppdomtest::game_xml_filename);
+   filenames.push_back(cppdomtest::nodetest_xml_filename);
+
+   std::vector<cppdom::DocumentPtr> docs(num_threads);
+   std::vector<std::thread> threads;
+   for (unsigned t = 0; t < num_threads; ++t)
+   {
+      threads.push_back(std::thread(parseThread, context, filenames[t % filenames.size()], &docs[t]));
+   }
+   for (unsigned t = 0; t < num_threads; ++t)
+   {  threads[t].join(); }
+
+   for (unsigned t = 0; t < num_threads; ++t)
+   {
+      cppdom::ContextPtr own_context(new cppdom::Context);
+      cppdom::DocumentPtr expected(new cppdom::Document(own_context));
+      expected->loadFile(filenames[t % filenames.size()]);
+      CPPUNIT_ASSERT(docs[t]->isEqual(expected));
+
+      // Same context, so the same names have the same handles
+      cppdom::NodePtr root = docs[t]->getChildren()[0];
+      cppdom::NodePtr other_root = docs[t % filenames.size()]->getChildren()[0];
+      CPPUNIT_ASSERT_EQUAL(root->getNameHandle(), other_root->getNameHandle());
+   }
+#endif
+}
+
+}
@@ -34,9 +34,17 @@ inline void dump_node( Node &node, int level = 0 )
       c = '#';
       c_data = node.getCdata();
       break;
+   case Node::xml_nt_comment:
+      c = '!';
+      c_data = node.getCdata();
+      break;
+   case Node::xml_nt_pi:
+      c = '?';
+      c_data = node.getCdata();
+      break;
    }
 
-   if(node.isCData())
+   if(node.isCData() || node.isComment() || node.isPi())
       std::cout << c << name.c_str() << "[" << c_data << "]" << std::endl;
    else
       std::cout << c << name.c_str() << std::endl;